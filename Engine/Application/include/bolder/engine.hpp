@@ -8,6 +8,15 @@ namespace detail {
 struct Engine_impl;
 }
 
+namespace ecs {
+class World;
+class Scheduler;
+}
+
+namespace physics {
+class System;
+}
+
 /// This class manages all the states and the main loop of the game engine
 class Engine
 {
@@ -18,6 +27,15 @@ public:
     /// Run the engine
     int exec(int argc, char** argv);
 
+    /// Gets the world of all the entities of the game
+    ecs::World& world();
+
+    /// Gets the scheduler whose systems update the world every fixed step
+    ecs::Scheduler& scheduler();
+
+    /// Gets the system that simulates the rigid bodies, run by the scheduler
+    physics::System& physics();
+
 private:
     std::unique_ptr<detail::Engine_impl> impl_;
 };
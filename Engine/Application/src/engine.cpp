@@ -6,7 +6,11 @@
 #include "bolder/display.hpp"
 #include "bolder/event.hpp"
 #include "bolder/logger.hpp"
+#include "bolder/thread_pool.hpp"
+#include "bolder/ecs/scheduler.hpp"
+#include "bolder/ecs/world.hpp"
 #include "bolder/graphics/renderer.hpp"
+#include "bolder/physics/system.hpp"
 
 namespace {
     // Check if fps is too low and report to logger
@@ -25,11 +29,19 @@ struct Engine_impl {
     event::Channel channel;
     platform::Display display;
     std::unique_ptr<graphics::Renderer> graphics;
+    Thread_pool workers;
+    ecs::World world;
+    ecs::Scheduler scheduler;
+    physics::System& physics;
 
     Engine_impl(const char* title)
         : channel{},
           display{title, channel},
-          graphics{std::make_unique<graphics::Renderer>(channel)} {
+          graphics{std::make_unique<graphics::Renderer>(channel)},
+          workers{},
+          world{},
+          scheduler{workers},
+          physics{scheduler.emplace_system<physics::System>(workers)} {
 
     }
 
@@ -53,6 +65,9 @@ void Engine_impl::game_loop()
 
     // Time s(ms) between two update
     constexpr milliseconds ms_per_update {10};
+    // Updates that a frame may run to catch up, after which the simulation
+    // falls behind the real time instead of spiraling into ever longer frames
+    constexpr int max_updates_per_frame = 5;
 
     while (!display.closed()) {
         auto current = high_resolution_clock::now();
@@ -62,10 +77,27 @@ void Engine_impl::game_loop()
 
         // Todo: process input
 
+        int updates = 0;
         while (lag >= ms_per_update) {
-            // Todo: None graphics update
+            if (updates == max_updates_per_frame) {
+                BOLDER_LOG_WARNING << "Skip " << lag.count()
+                                   << " ms of updates to catch up";
+                lag = Ms{0};
+                break;
+            }
+
+            const auto update_start = high_resolution_clock::now();
+            scheduler.run(world, duration<double>{ms_per_update}.count());
+            const auto update_time = duration_cast<Ms>(
+                        high_resolution_clock::now() - update_start);
+            if (update_time > ms_per_update) {
+                BOLDER_LOG_WARNING << "Update takes " << update_time.count()
+                                   << " ms, longer than "
+                                   << ms_per_update.count() << " ms";
+            }
+
             lag -= ms_per_update;
-            // Todo: report error if update takes longer that ms_per_update
+            ++updates;
         }
 
         // Render
@@ -95,4 +127,19 @@ int Engine::exec(int argc, char** argv)
     return impl_->exec(argc, argv);
 }
 
+ecs::World& Engine::world()
+{
+    return impl_->world;
+}
+
+ecs::Scheduler& Engine::scheduler()
+{
+    return impl_->scheduler;
+}
+
+physics::System& Engine::physics()
+{
+    return impl_->physics;
+}
+
 }
@@ -0,0 +1,101 @@
+// Throughput of handle managers shared between threads
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bolder/concurrent_handle_manager.hpp"
+#include "bolder/handle_manager.hpp"
+
+using namespace bolder;
+
+namespace {
+
+using Bench_handle = resource::Handle<16>;
+constexpr bolder::uint32 capacity = 1u << 16;
+constexpr int operations_per_thread = 1 << 20;
+constexpr int batch_size = 256;
+
+// A Handle_manager guarded by a mutex, as the baseline
+class Locked_handle_manager {
+public:
+    Bench_handle add(int value) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return handles_->add(value);
+    }
+
+    void remove(Bench_handle handle) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        handles_->remove(handle);
+    }
+
+    const int* operator[](Bench_handle handle) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return (*handles_)[handle];
+    }
+
+private:
+    using Manager = resource::Handle_manager<Bench_handle, int, capacity>;
+    std::unique_ptr<Manager> handles_ = std::make_unique<Manager>();
+    std::mutex mutex_;
+};
+
+// Every thread allocates a batch of handles, resolves every handle of the
+// batch, and then removes them. Returns million operations per second.
+template<typename Manager>
+double run(Manager& handles, unsigned thread_count) {
+    auto worker = [&handles]() {
+        std::vector<Bench_handle> batch;
+        batch.reserve(batch_size);
+        long long sum = 0;
+        for (int i = 0; i < operations_per_thread; i += 3 * batch_size) {
+            for (int j = 0; j != batch_size; ++j) {
+                batch.push_back(handles.add(i));
+            }
+            for (auto handle : batch) {
+                sum += *handles[handle];
+            }
+            for (auto handle : batch) {
+                handles.remove(handle);
+            }
+            batch.clear();
+        }
+        return sum;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i != thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+    return operations_per_thread * double(thread_count) / elapsed.count()
+            / 1e6;
+}
+
+}
+
+int main() {
+    const auto max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "threads  locked (Mops/s)  concurrent (Mops/s)\n";
+    for (auto threads = 1u; threads <= max_threads; threads *= 2) {
+        Locked_handle_manager locked;
+        auto concurrent = std::make_unique<resource::Concurrent_handle_manager<
+                Bench_handle, int, capacity>>();
+
+        std::cout << std::setw(7) << threads
+                  << std::setw(17) << run(locked, threads)
+                  << std::setw(21) << run(*concurrent, threads) << '\n';
+    }
+}
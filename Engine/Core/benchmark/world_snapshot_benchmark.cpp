@@ -0,0 +1,92 @@
+// Load time of World snapshots, against creating the entities one by one
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "bolder/ecs/query.hpp"
+#include "bolder/ecs/snapshot.hpp"
+#include "bolder/ecs/world.hpp"
+
+using namespace bolder;
+
+namespace {
+
+struct Position {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y;
+};
+
+struct Health {
+    int value;
+};
+
+struct Row {
+    Position position;
+    Velocity velocity;
+    Health health;
+};
+
+constexpr int entity_count = 1 << 20;
+constexpr auto filename = "world_snapshot_benchmark.bin";
+
+template<typename Function>
+double milliseconds(Function f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+}
+
+int main() {
+    std::vector<Row> rows;
+    {
+        ecs::World world;
+        for (int i = 0; i != entity_count; ++i) {
+            const auto x = static_cast<float>(i);
+            if (i % 2 == 0) {
+                world.create_entity(Position{x, x}, Velocity{1, 0}, Health{i});
+            } else {
+                world.create_entity(Position{x, x}, Velocity{0, 1});
+            }
+        }
+        ecs::Query<const Position, const Velocity>{world}.each(
+                    [&rows](const Position& position, const Velocity& velocity) {
+            rows.push_back(Row{position, velocity, Health{0}});
+        });
+
+        std::cout << "save snapshot (ms)         "
+                  << milliseconds([&world] {
+            ecs::save_snapshot(world, filename);
+        }) << '\n';
+    }
+
+    // Registers the component types, as a game does before loading a level
+    ecs::make_signature<Position, Velocity, Health>();
+
+    std::cout << "load snapshot (ms)         " << milliseconds([] {
+        ecs::World world;
+        ecs::load_snapshot(world, filename);
+    }) << '\n';
+
+    std::cout << "create one by one (ms)     " << milliseconds([&rows] {
+        ecs::World world;
+        for (auto i = 0u; i != rows.size(); ++i) {
+            if (i % 2 == 0) {
+                world.create_entity(rows[i].position, rows[i].velocity,
+                                    rows[i].health);
+            } else {
+                world.create_entity(rows[i].position, rows[i].velocity);
+            }
+        }
+    }) << '\n';
+
+    std::remove(filename);
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "bolder/handle.hpp"
+#include "bolder/resource_error.hpp"
+
+namespace bolder { namespace resource {
+
+/**
+ * @class Concurrent_handle_manager
+ * @ingroup resource_group
+ * @brief A thread-safe Handle_manager.
+ * @tparam Handle The handle type that refers to the managed data
+ * @tparam T Type of managed data
+ * @tparam capacity Maximum number of data the manager can hold
+ *
+ * add() and remove() can be called from any number of threads at the same time
+ * without locks, and operator[] is wait-free. This lets loader threads create
+ * resources while the render thread resolves their handles.
+ *
+ * Free entries form a lock-free stack. Its head packs the index of the first
+ * free entry together with a tag that is incremented on every push and pop, so
+ * that a head which has been popped and pushed back in the meantime (the ABA
+ * problem) is never mistaken for an unchanged head.
+ *
+ * Every entry has an atomic state that packs its generation and a live bit.
+ * add() publishes the state with release semantics only after the element is
+ * written, and operator[] reads it with acquire semantics, so a handle that
+ * resolves always sees a fully written element.
+ *
+ * @note Unlike Handle_manager, elements are not kept densely packed.
+ * @warning The caller must not remove a handle while other threads still use
+ * the element it refers to.
+ * @see Handle_manager
+ */
+template<typename Handle, typename T, uint32 capacity>
+class Concurrent_handle_manager {
+    static constexpr auto max_capacity = 1u << Handle::index_bits;
+    static_assert(capacity <= max_capacity,
+                  "capacity bigger then max value of handle index");
+    static_assert(Handle::generation_bits < 32,
+                  "generation and the live bit must fit into 32 bits");
+
+    static constexpr uint32 generation_mask =
+            (1u << Handle::generation_bits) - 1;
+    static constexpr uint32 live_bit = 1u;
+    static constexpr uint32 end_of_list = ~0u;
+
+public:
+    using value_type = T;
+    using size_type = uint32;
+
+    Concurrent_handle_manager();
+
+    Concurrent_handle_manager(const Concurrent_handle_manager&) = delete;
+    Concurrent_handle_manager& operator=(const Concurrent_handle_manager&)
+        = delete;
+
+    Handle add(value_type value);
+
+    void remove(Handle handle);
+
+    /**
+     * @brief Gets underlying variable that a handle refer to.
+     * @param handle
+     * @return A pointer to underlying variable that a handle refer to;
+     * nullptr if the handle is no longer valid.
+     */
+    const value_type* operator[](Handle handle) const {
+        const auto index = handle.index();
+        if (index >= capacity) {
+            return nullptr;
+        }
+
+        const auto state = states_[index].load(std::memory_order_acquire);
+        if (state != live_state(handle.generation())) {
+            return nullptr;
+        }
+
+        return &elems_[index];
+    }
+
+    /// Returns the number of live elements at some moment during the call
+    size_type size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+private:
+    // The free list head: tag in the high 32 bits, entry index in the low bits
+    std::atomic<uint64> free_head_;
+    std::array<std::atomic<uint32>, capacity> next_free_;
+    // (generation << 1) | live_bit
+    std::array<std::atomic<uint32>, capacity> states_;
+    std::array<T, capacity> elems_;
+    std::atomic<size_type> size_ {0};
+
+    static constexpr uint32 live_state(uint32 generation) {
+        return ((generation & generation_mask) << 1) | live_bit;
+    }
+
+    static constexpr uint64 pack_head(uint32 tag, uint32 index) {
+        return (uint64{tag} << 32) | index;
+    }
+
+    static constexpr uint32 head_tag(uint64 head) {
+        return static_cast<uint32>(head >> 32);
+    }
+
+    static constexpr uint32 head_index(uint64 head) {
+        return static_cast<uint32>(head);
+    }
+
+    uint32 pop_free();
+    void push_free(uint32 index);
+};
+
+template<typename Handle, typename T, uint32 capacity>
+Concurrent_handle_manager<Handle, T, capacity>::Concurrent_handle_manager() {
+    for (auto i = 0u; i != capacity; ++i) {
+        next_free_[i].store(i + 1 == capacity ? end_of_list : i + 1,
+                            std::memory_order_relaxed);
+        states_[i].store(0, std::memory_order_relaxed);
+    }
+    free_head_.store(pack_head(0, capacity == 0 ? end_of_list : 0),
+                     std::memory_order_release);
+}
+
+template<typename Handle, typename T, uint32 capacity>
+Handle Concurrent_handle_manager<Handle, T, capacity>::add(T elem) {
+    const auto index = pop_free();
+    if (index == end_of_list) {
+        throw Resource_error{Handle_error_type::out_of_space};
+    }
+
+    // The entry is exclusively owned by this thread until it is published
+    const auto generation =
+            states_[index].load(std::memory_order_relaxed) >> 1;
+    elems_[index] = elem;
+    states_[index].store(live_state(generation), std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return Handle{index, generation};
+}
+
+template<typename Handle, typename T, uint32 capacity>
+void Concurrent_handle_manager<Handle, T, capacity>::remove(Handle handle) {
+    const auto index = handle.index();
+    if (index >= capacity) {
+        throw Resource_error{Handle_error_type::invalid_handle};
+    }
+
+    auto expected = live_state(handle.generation());
+    const auto next_generation = (handle.generation() + 1) & generation_mask;
+    // Only one of the threads that remove the same handle can succeed
+    if (!states_[index].compare_exchange_strong(
+                expected, next_generation << 1, std::memory_order_acq_rel,
+                std::memory_order_relaxed)) {
+        if ((expected & live_bit) == 0) {
+            throw Resource_error{Handle_error_type::null_entry};
+        }
+        throw Resource_error{Handle_error_type::invalid_handle};
+    }
+
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    push_free(index);
+}
+
+// Returns end_of_list if there is no free entry
+template<typename Handle, typename T, uint32 capacity>
+uint32 Concurrent_handle_manager<Handle, T, capacity>::pop_free() {
+    auto head = free_head_.load(std::memory_order_acquire);
+    for (;;) {
+        const auto index = head_index(head);
+        if (index == end_of_list) {
+            return end_of_list;
+        }
+
+        // May read a stale link if another thread popped the entry meanwhile;
+        // the tag makes the exchange below fail in that case.
+        const auto next = next_free_[index].load(std::memory_order_relaxed);
+        if (free_head_.compare_exchange_weak(
+                    head, pack_head(head_tag(head) + 1, next),
+                    std::memory_order_acquire, std::memory_order_acquire)) {
+            return index;
+        }
+    }
+}
+
+template<typename Handle, typename T, uint32 capacity>
+void Concurrent_handle_manager<Handle, T, capacity>::push_free(uint32 index) {
+    auto head = free_head_.load(std::memory_order_relaxed);
+    for (;;) {
+        next_free_[index].store(head_index(head), std::memory_order_relaxed);
+        if (free_head_.compare_exchange_weak(
+                    head, pack_head(head_tag(head) + 1, index),
+                    std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+}} // namespace bolder::resource
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "bolder/byte.hpp"
+#include "bolder/ecs/component.hpp"
+#include "bolder/ecs/entity.hpp"
+
+namespace bolder { namespace ecs {
+
+class Archetype;
+
+/**
+ * @brief When a column of a chunk was last modified.
+ * @ingroup ecs_group
+ *
+ * Ticks are values of World::write_tick() at the time of modification.
+ */
+struct Column_ticks {
+    /// Last time rows were added to the chunk
+    uint32 added;
+    /// Last time the column was written, including when rows were added
+    uint32 changed;
+};
+
+/**
+ * @brief A fixed-size block of memory that stores rows of an Archetype.
+ * @ingroup ecs_group
+ *
+ * A chunk stores its rows as structure of arrays: the entity of every row
+ * comes first, followed by one contiguous column per component type. Every
+ * column also carries Column_ticks, so that systems can skip the chunks that
+ * did not change since they last ran.
+ */
+class Chunk {
+public:
+    static constexpr std::size_t bytes = 16 * 1024;
+
+    /// Leaves the storage uninitialized
+    Chunk() noexcept {}
+
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
+    /// Returns the number of rows in this chunk
+    uint32 size() const noexcept {
+        return size_;
+    }
+
+    Byte* data() noexcept {
+        return reinterpret_cast<Byte*>(&storage_);
+    }
+
+    const Byte* data() const noexcept {
+        return reinterpret_cast<const Byte*>(&storage_);
+    }
+
+    const Column_ticks& ticks(uint32 column) const noexcept {
+        return ticks_[column];
+    }
+
+private:
+    friend class Archetype;
+
+    typename std::aligned_storage<bytes, alignof(std::max_align_t)>::type
+        storage_;
+    uint32 size_ = 0;
+    std::vector<Column_ticks> ticks_;
+};
+
+/**
+ * @brief Where the components of an entity are stored.
+ * @ingroup ecs_group
+ */
+struct Entity_location {
+    Archetype* archetype = nullptr;
+    uint32 chunk = 0;
+    uint32 row = 0;
+};
+
+/**
+ * @brief Storage of all the entities that have the same set of components.
+ * @ingroup ecs_group
+ *
+ * Rows are kept packed inside every chunk: removing a row moves the last row of
+ * its chunk into the hole. New rows go to the first chunk that has room.
+ *
+ * Tag components take no memory in chunks. Every chunk stores a single value of
+ * each shared component, at the end of the chunk, and new rows only go to a
+ * chunk whose shared components have the same bytes as theirs. The shared
+ * components of a row are passed around as a block of shared_size() bytes,
+ * laid out like the end of a chunk.
+ */
+class Archetype {
+public:
+    /// Column index of a component that is not in the archetype
+    static constexpr uint32 npos = ~0u;
+
+    explicit Archetype(const Signature& signature);
+
+    /// Destroys the components of all the rows
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    const Signature& signature() const {
+        return signature_;
+    }
+
+    /// Returns the number of entities in the archetype
+    uint32 size() const {
+        return size_;
+    }
+
+    /// Returns the maximum number of rows of a chunk
+    uint32 chunk_capacity() const {
+        return chunk_capacity_;
+    }
+
+    std::size_t chunk_count() const {
+        return chunks_.size();
+    }
+
+    Chunk& chunk(std::size_t index) {
+        return *chunks_[index];
+    }
+
+    const Chunk& chunk(std::size_t index) const {
+        return *chunks_[index];
+    }
+
+    /// Returns the number of component columns
+    uint32 column_count() const {
+        return static_cast<uint32>(columns_.size());
+    }
+
+    /// Returns the component id of a column
+    Component_id column_component(uint32 column) const {
+        return columns_[column].component;
+    }
+
+    /// Returns the bytes between two rows of a column, which is 0 for tags and
+    /// shared components
+    std::size_t column_stride(uint32 column) const {
+        return columns_[column].stride;
+    }
+
+    /// Returns the size of the block of the shared components of a chunk
+    std::size_t shared_size() const {
+        return shared_size_;
+    }
+
+    /// Returns the block of the shared components of a chunk
+    const Byte* shared_values(const Chunk& chunk) const {
+        return chunk.data() + shared_offset_;
+    }
+
+    /// Returns the offset of a shared component in the block of shared
+    /// components
+    std::size_t shared_offset(uint32 column) const {
+        return columns_[column].offset - shared_offset_;
+    }
+
+    /// Returns the column of a component, or npos if the archetype has none
+    uint32 column_index(Component_id component) const {
+        return column_indices_[component];
+    }
+
+    Entity* entities(Chunk& chunk) const {
+        return reinterpret_cast<Entity*>(chunk.data());
+    }
+
+    const Entity* entities(const Chunk& chunk) const {
+        return reinterpret_cast<const Entity*>(chunk.data());
+    }
+
+    /// Returns the start of a column in a chunk
+    void* column_data(Chunk& chunk, uint32 column) const {
+        return chunk.data() + columns_[column].offset;
+    }
+
+    /// Returns the column of component T in a chunk, T may be const
+    template<typename T>
+    T* column(Chunk& chunk) const {
+        const auto index = column_index(component_id<std::remove_const_t<T>>());
+        return static_cast<T*>(column_data(chunk, index));
+    }
+
+    /// Returns a component in a row, or nullptr if the archetype has none
+    void* component(const Entity_location& location,
+                    Component_id component) const;
+
+    /// Records that a column of a chunk is written at tick
+    void mark_changed(Chunk& chunk, uint32 column, uint32 tick) const {
+        chunk.ticks_[column].changed = tick;
+    }
+
+    /**
+     * @brief Reserves a row for entity, leaving its components uninitialized.
+     * @param entity Entity of the new row
+     * @param tick Change tick that every column of the chunk is marked as
+     * added and changed at
+     * @param shared The shared components of the row, which can be null if
+     * shared_size() is 0
+     */
+    Entity_location allocate(Entity entity, uint32 tick, const Byte* shared);
+
+    /**
+     * @brief Reserves consecutive rows of a chunk for entities, leaving their
+     * components uninitialized.
+     * @param entities Entities of the new rows
+     * @param count Number of entities; receives the number of reserved rows,
+     * which is less than the original count if the chunk runs out of room
+     * @param tick Change tick that every column of the chunk is marked as
+     * added and changed at
+     * @param shared The shared components of the rows, which can be null if
+     * shared_size() is 0
+     * @return Location of the first reserved row
+     */
+    Entity_location allocate_n(const Entity* entities, uint32& count,
+                               uint32 tick, const Byte* shared);
+
+    /**
+     * @brief Copy constructs the components of consecutive rows of a chunk.
+     * @param location The first row
+     * @param count Number of rows, which must be in the same chunk
+     * @param prototypes The component that every row copies, for every column
+     *
+     * Trivially copyable columns are filled with memcpy. Tags and shared
+     * components are skipped, since the chunk already has them. If a copy
+     * constructor throws, the components that are already copied are
+     * destroyed.
+     */
+    void clone_rows(const Entity_location& location, uint32 count,
+                    const void* const* prototypes);
+
+    /// Destroys the components of a row, but keeps the row
+    void destroy_row(const Entity_location& location);
+
+    /**
+     * @brief Moves the components of a row into a row of another archetype.
+     *
+     * Components that target does not have are destroyed, and components that
+     * only target has are left uninitialized. Shared components are not moved,
+     * since the target row has the ones of its chunk. The source row is kept.
+     */
+    void move_row(const Entity_location& location, Archetype& target,
+                  const Entity_location& destination);
+
+    /**
+     * @brief Removes a row whose components were destroyed or moved out.
+     * @return The entity that is moved into the removed row, which is the
+     * removed entity itself if it was the last row of its chunk.
+     */
+    Entity remove_row(const Entity_location& location);
+
+    /**
+     * @brief Moves rows of a chunk into an earlier chunk that has room and the
+     * same shared components, and frees the last chunk once it is empty.
+     * @param count Maximum number of rows to move; receives the number of
+     * moved rows, which is 0 once no row can move to an earlier chunk
+     * @return Location of the first moved row; the moved rows are consecutive
+     *
+     * Every column of the receiving chunk takes the later ticks of its own and
+     * of the last chunk, so that no change is lost.
+     */
+    Entity_location compact(uint32& count);
+
+private:
+    struct Column {
+        Component_id component;
+        std::size_t offset;
+        std::size_t stride;
+        Component_info info;
+    };
+
+    Signature signature_;
+    std::vector<Column> columns_;
+    std::vector<uint32> column_indices_;
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    uint32 chunk_capacity_ = 0;
+    uint32 size_ = 0;
+    std::size_t shared_offset_ = 0;
+    std::size_t shared_size_ = 0;
+    // No chunk before this one has room for a new row
+    uint32 first_open_chunk_ = 0;
+
+    Byte* element(Chunk& chunk, uint32 column, uint32 row) const {
+        return chunk.data() + columns_[column].offset
+                + row * columns_[column].stride;
+    }
+
+    Entity_location move_rows(uint32 source, uint32 target, uint32& count);
+    uint32 open_chunk(const Byte* shared) const;
+    bool same_shared(const Chunk& chunk, const Byte* shared) const;
+};
+
+}} // namespace bolder::ecs
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bolder/byte.hpp"
+#include "bolder/ecs/component.hpp"
+#include "bolder/ecs/entity.hpp"
+#include "bolder/exception.hpp"
+#include "bolder/thread_pool.hpp"
+
+namespace bolder { namespace ecs {
+
+class Archetype;
+class World;
+
+/**
+ * @brief Records structural changes of a World to apply them later.
+ * @ingroup ecs_group
+ *
+ * Systems that run in parallel cannot create or destroy entities, or add or
+ * remove components, since that moves rows that other systems may be reading.
+ * Instead they record the changes into a command buffer, and playback() applies
+ * them at a sync point where no system runs.
+ *
+ * Commands are written into a compact byte stream, with the components they
+ * carry constructed in place. The components of created entities are instead
+ * staged in columns, one set of columns for every combination of component
+ * types, so that playback moves them into the chunks of their archetype a
+ * column at a time. Recording does not allocate once the buffer has warmed up.
+ *
+ * A command buffer must only be used by one thread at a time. To record from
+ * the threads of a parallel_for, such as the ones of Query::par_each(), every
+ * participant takes its own buffer from participants(), and playback() applies
+ * them after the commands of the buffer itself.
+ *
+ * Entities created by a command buffer do not exist in the World until
+ * playback. The Entity that create_entity() returns can be used in later
+ * commands of the same buffer, but not anywhere else, not even in the buffers
+ * of participants().
+ *
+ * @par Example
+ * @code{.cpp}
+ * auto bullet = commands.create_entity(Position{x, y});
+ * commands.add_component(bullet, Velocity{0, 10});
+ * commands.destroy_entity(expired);
+ * // At the sync point
+ * commands.playback(world);
+ * @endcode
+ *
+ * @par Example of recording from a parallel query
+ * @code{.cpp}
+ * query.par_each(pool, commands.participants(pool),
+ *         [](ecs::Command_buffer& commands, const Health& health) {
+ *     if (health.value <= 0) commands.create_entity(Explosion{});
+ * });
+ * @endcode
+ */
+class Command_buffer {
+public:
+    Command_buffer();
+
+    /// Destroys the components of the commands that are not played back
+    ~Command_buffer();
+
+    Command_buffer(const Command_buffer&) = delete;
+    Command_buffer& operator=(const Command_buffer&) = delete;
+
+    /**
+     * @brief Records creating an entity that has the components.
+     * @throw Runtime_error if a component type appears more than once.
+     */
+    template<typename... Components>
+    Entity create_entity(Components&&... components);
+
+    /// Records destroying an entity
+    void destroy_entity(Entity entity);
+
+    /// Records adding a component to an entity
+    template<typename T>
+    void add_component(Entity entity, T&& component);
+
+    /// Records replacing the value of a component that an entity has
+    template<typename T>
+    void set_component(Entity entity, T&& component);
+
+    /// Records removing a component from an entity
+    template<typename T>
+    void remove_component(Entity entity);
+
+    /// Returns whether neither this buffer nor its participants() have
+    /// commands
+    bool empty() const;
+
+    /**
+     * @brief Gets a command buffer for every participant of a parallel_for on
+     * pool.
+     *
+     * The buffers are kept between playbacks, so they warm up like this one.
+     * @throw Runtime_error if the buffers are made for a pool of another size
+     * and still have commands.
+     */
+    Per_participant<Command_buffer>& participants(const Thread_pool& pool);
+
+    /**
+     * @brief Applies and clears all the commands, and then the ones of
+     * participants() in the order of the participants.
+     *
+     * Entity creations of a buffer are applied first, grouped by archetype.
+     * The rows of an archetype without shared components are reserved in one
+     * batch, and every column of a chunk is then filled with a single memcpy,
+     * or a move of each component if it is not trivially copyable. The other
+     * commands are applied in the order they are recorded.
+     *
+     * @throw Runtime_error if a command refers to an entity that is not alive,
+     * adds a component that the entity already has, or sets or removes a
+     * component that it does not have. The commands after the failed one are
+     * discarded.
+     */
+    void playback(World& world);
+
+    /// Discards all the commands
+    void clear();
+
+private:
+    enum class Command_type : uint32 {
+        destroy_entity,
+        add_component,
+        set_component,
+        remove_component,
+        played, ///< A command that is already applied
+    };
+
+    // Every command starts with a header; add and set are followed by a
+    // single component
+    struct Command {
+        Command_type type;
+        uint32 component_count;
+        Entity entity;
+        std::size_t size; ///< Size of the command in bytes, including payload
+    };
+
+    // Every component starts with a header, followed by the component itself
+    struct Component_header {
+        Component_id component;
+    };
+
+    struct Block {
+        std::unique_ptr<Byte[]> data;
+        std::size_t capacity;
+        std::size_t size;
+    };
+
+    // Components of one type of the entities that a batch creates
+    struct Staged_column {
+        Component_id component;
+        std::unique_ptr<Byte[]> data;
+    };
+
+    // Entity creations that have the same component types. Tags need no
+    // column, since the archetype stores nothing for them.
+    struct Creation_batch {
+        Signature signature;
+        std::vector<Staged_column> columns;
+        // Index in created_ of the entity of every row
+        std::vector<uint32> rows;
+        uint32 capacity;
+        // Rows before this one are already moved into the World
+        uint32 played;
+    };
+
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+    static constexpr std::size_t block_size = 64 * 1024;
+
+    std::vector<Block> blocks_;
+    // Blocks before this one are full
+    std::size_t current_block_ = 0;
+    std::size_t command_count_ = 0;
+    uint32 created_count_ = 0;
+    // Entities of the World that the pending creations are mapped to
+    std::vector<Entity> created_;
+    std::vector<Creation_batch> batches_;
+    // The batch of the last creation, which the next one likely shares
+    std::size_t last_batch_ = 0;
+    std::unique_ptr<Per_participant<Command_buffer>> participants_;
+
+    static constexpr std::size_t aligned(std::size_t size) {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    template<typename T>
+    static constexpr std::size_t component_record_size() {
+        return aligned(sizeof(Component_header)) + aligned(sizeof(T));
+    }
+
+    template<typename T>
+    static Byte* write_component(Byte* out, T&& component);
+
+    template<typename T>
+    static void stage_component(Creation_batch& batch, uint32 row,
+                                T&& component);
+
+    static Byte* staged_component(Creation_batch& batch, uint32 row,
+                                  Component_id component);
+
+    Creation_batch& creation_batch(const Signature& signature);
+    uint32 reserve_row(Creation_batch& batch);
+    void destroy_staged(Creation_batch& batch, uint32 first, uint32 last);
+
+    Byte* allocate(std::size_t size);
+    Command* record(Command_type type, Entity entity, uint32 component_count,
+                    std::size_t payload_size);
+
+    template<typename Function>
+    void for_each_command(Function f);
+
+    Entity resolve(Entity entity) const;
+    void create_entities(World& world);
+    void create_rows(World& world, Archetype& archetype, Creation_batch& batch,
+                     std::vector<Entity>& entities);
+    void create_shared_rows(World& world, Archetype& archetype,
+                            Creation_batch& batch,
+                            std::vector<Entity>& entities);
+    void destroy_payload(Command& command);
+};
+
+template<typename T>
+Byte* Command_buffer::write_component(Byte* out, T&& component)
+{
+    using Component = std::decay_t<T>;
+    new (out) Component_header{component_id<Component>()};
+    out += aligned(sizeof(Component_header));
+    new (out) Component(std::forward<T>(component));
+    return out + aligned(sizeof(Component));
+}
+
+template<typename T>
+void Command_buffer::stage_component(Creation_batch& batch, uint32 row,
+                                     T&& component)
+{
+    using Component = std::decay_t<T>;
+    auto* out = staged_component(batch, row, component_id<Component>());
+    if (out != nullptr) {
+        new (out) Component(std::forward<T>(component));
+    }
+}
+
+template<typename... Components>
+Entity Command_buffer::create_entity(Components&&... components)
+{
+    const auto signature = make_signature<std::decay_t<Components>...>();
+    if (signature.count() != sizeof...(Components)) {
+        throw Runtime_error {"Create an entity with duplicated component types"};
+    }
+
+    auto& batch = creation_batch(signature);
+    const auto row = reserve_row(batch);
+    const Component_id ids[] = {0, component_id<std::decay_t<Components>>()...};
+    std::size_t staged = 1;
+    try {
+        const int expand[] = {0, (stage_component(
+                batch, row, std::forward<Components>(components)),
+                ++staged, 0)...};
+        static_cast<void>(expand);
+    } catch (...) {
+        while (staged != 1) {
+            const auto id = ids[--staged];
+            auto* component = staged_component(batch, row, id);
+            if (component != nullptr) component_info(id).destroy(component);
+        }
+        throw;
+    }
+
+    batch.rows.push_back(created_count_);
+    ++command_count_;
+    return Entity{created_count_++, Entity::reserved_generation};
+}
+
+template<typename T>
+void Command_buffer::add_component(Entity entity, T&& component)
+{
+    auto* command = record(Command_type::add_component, entity, 1,
+                           component_record_size<std::decay_t<T>>());
+    write_component(reinterpret_cast<Byte*>(command) + aligned(sizeof(Command)),
+                    std::forward<T>(component));
+}
+
+template<typename T>
+void Command_buffer::set_component(Entity entity, T&& component)
+{
+    auto* command = record(Command_type::set_component, entity, 1,
+                           component_record_size<std::decay_t<T>>());
+    write_component(reinterpret_cast<Byte*>(command) + aligned(sizeof(Command)),
+                    std::forward<T>(component));
+}
+
+template<typename T>
+void Command_buffer::remove_component(Entity entity)
+{
+    auto* command = record(Command_type::remove_component, entity, 1,
+                           aligned(sizeof(Component_header)));
+    new (reinterpret_cast<Byte*>(command) + aligned(sizeof(Command)))
+            Component_header{component_id<T>()};
+}
+
+}} // namespace bolder::ecs
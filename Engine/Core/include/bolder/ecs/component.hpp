@@ -0,0 +1,172 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "bolder/integer.hpp"
+
+/**
+ * @file component.hpp
+ * @brief Runtime type information of ECS components.
+ */
+
+namespace bolder { namespace ecs {
+
+using Component_id = uint32;
+
+/// Maximum number of distinct component types in a program
+constexpr uint32 max_components = 128;
+
+/// Id of no component type
+constexpr Component_id invalid_component = ~0u;
+
+/**
+ * @brief Set of component types.
+ * @ingroup ecs_group
+ *
+ * The bit of a component type is its Component_id.
+ */
+using Signature = std::bitset<max_components>;
+
+/**
+ * @brief Whether T is a tag component.
+ * @ingroup ecs_group
+ *
+ * Tags are empty types, such as a marker struct Enemy {}, that only exist in
+ * the signature of an archetype and take no memory in its chunks.
+ */
+template<typename T>
+struct is_tag_component
+    : std::integral_constant<bool, std::is_empty<T>::value
+                                   && std::is_trivially_copyable<T>::value> {};
+
+/**
+ * @brief Whether T is a shared component.
+ * @ingroup ecs_group
+ *
+ * Specialize it to derive from std::true_type to make T shared. A chunk stores
+ * a single shared component for all of its rows, so entities that have
+ * different values of it are split into different chunks of the same
+ * archetype. A shared component must be trivially copyable, and values are
+ * compared by their bytes, so it should have no padding.
+ *
+ * @par Example
+ * @code{.cpp}
+ * struct Material {
+ *     graphics::Texture_handle texture;
+ * };
+ *
+ * namespace bolder { namespace ecs {
+ * template<> struct is_shared_component<Material> : std::true_type {};
+ * }}
+ * @endcode
+ */
+template<typename T>
+struct is_shared_component : std::false_type {};
+
+/**
+ * @brief Type-erased operations of a component type.
+ * @ingroup ecs_group
+ *
+ * Archetypes store components as raw bytes and use these to move, copy and
+ * destroy them.
+ */
+struct Component_info {
+    using Copy_function = void (*)(void* destination, const void* source);
+
+    std::size_t size;
+    std::size_t alignment;
+    /// Whether the component is trivially copyable and can be moved by memcpy
+    bool trivial;
+    /// Whether the component is a tag
+    bool tag;
+    /// Whether the component is shared by all the rows of a chunk, which is
+    /// never the case for a tag
+    bool shared;
+    void (*move_construct)(void* destination, void* source);
+    /// Null if the component is not copy constructible
+    Copy_function copy_construct;
+    void (*destroy)(void* component);
+    /// Name of the type, which identifies it across runs of a program
+    const char* name;
+};
+
+namespace detail {
+Component_id register_component(const Component_info& info);
+
+template<typename T>
+void move_construct(void* destination, void* source) {
+    new (destination) T(std::move(*static_cast<T*>(source)));
+}
+
+template<typename T>
+void copy_construct(void* destination, const void* source) {
+    new (destination) T(*static_cast<const T*>(source));
+}
+
+template<typename T>
+Component_info::Copy_function copy_function(std::true_type) {
+    return &copy_construct<T>;
+}
+
+template<typename T>
+Component_info::Copy_function copy_function(std::false_type) {
+    return nullptr;
+}
+
+template<typename T>
+void destroy(void* component) {
+    static_cast<T*>(component)->~T();
+}
+} // namespace detail
+
+/**
+ * @brief Gets the id of a component type.
+ * @ingroup ecs_group
+ *
+ * Component ids are assigned on first use and are dense, starting from zero.
+ * @throw Runtime_error if more than max_components types are used.
+ */
+template<typename T>
+Component_id component_id() {
+    static_assert(std::is_same<T, std::decay_t<T>>::value,
+                  "Component type cannot be a reference or const");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "Over-aligned component is not supported");
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "Component need to be nothrow move constructible");
+    static_assert(!is_shared_component<T>::value
+                  || std::is_trivially_copyable<T>::value,
+                  "Shared component need to be trivially copyable");
+
+    static const Component_id id = detail::register_component(Component_info{
+        sizeof(T), alignof(T), std::is_trivially_copyable<T>::value,
+        is_tag_component<T>::value,
+        is_shared_component<T>::value && !is_tag_component<T>::value,
+        &detail::move_construct<T>,
+        detail::copy_function<T>(std::is_copy_constructible<T>{}),
+        &detail::destroy<T>, typeid(T).name()});
+    return id;
+}
+
+/// Gets the type-erased operations of a registered component type
+const Component_info& component_info(Component_id id);
+
+/// Finds a registered component type by its Component_info::name, and returns
+/// its id, or invalid_component if none is registered
+Component_id find_component(const char* name);
+
+/// Gets the signature that contains exactly the Components
+template<typename... Components>
+Signature make_signature() {
+    Signature signature;
+    const int expand[] = {0, (signature.set(component_id<Components>()), 0)...};
+    static_cast<void>(expand);
+    return signature;
+}
+
+}} // namespace bolder::ecs
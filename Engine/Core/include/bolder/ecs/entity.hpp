@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iosfwd>
+
+#include "bolder/integer.hpp"
+
+namespace bolder { namespace ecs {
+
+class Command_buffer;
+class World;
+
+/**
+ * @brief An entity is an identifier that groups components in a World.
+ * @ingroup ecs_group
+ *
+ * Entities are created by World::create_entity(). An entity is an index into
+ * the tables of its World together with the generation of that index, which
+ * tells apart the entities that reuse the index of a destroyed one.
+ */
+class Entity {
+public:
+    /// Generation of the entities that a Command_buffer creates before they
+    /// exist in the World; no entity of a World has this generation
+    static constexpr uint32 reserved_generation = ~0u;
+
+    /// Default constructor creates a null entity that never refers to anything
+    Entity() = default;
+
+    uint32 index() const {
+        return index_;
+    }
+
+    uint32 generation() const {
+        return generation_;
+    }
+
+    friend bool operator==(Entity lhs, Entity rhs) {
+        return lhs.index_ == rhs.index_ && lhs.generation_ == rhs.generation_;
+    }
+
+    friend bool operator!=(Entity lhs, Entity rhs) {
+        return !(lhs == rhs);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, Entity entity);
+
+private:
+    friend class Command_buffer;
+    friend class World;
+
+    Entity(uint32 index, uint32 generation)
+        : index_{index}, generation_{generation} {}
+
+    uint32 index_ = ~0u;
+    uint32 generation_ = 0;
+};
+
+}} // namespace bolder::ecs
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bolder/byte.hpp"
+#include "bolder/ecs/component.hpp"
+
+namespace bolder { namespace ecs {
+
+/**
+ * @brief A prototype entity that World::instantiate() copies.
+ * @ingroup ecs_group
+ *
+ * A prefab stores one value of each of its components. Instantiating it creates
+ * all the copies in the rows of a single archetype at once: trivially copyable
+ * components are copied with memcpy, and only the other components run their
+ * copy constructors. The components of a prefab must be copy constructible.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Prefab enemy {Position{0, 0}, Health{100}, Sprite{texture}};
+ * enemy.get_component<Position>()->x = spawn_x;
+ * auto wave = world.instantiate(enemy, 10000);
+ * @endcode
+ */
+class Prefab {
+public:
+    /// Creates a prefab that has the components
+    template<typename... Components>
+    explicit Prefab(Components&&... components);
+
+    ~Prefab();
+
+    Prefab(Prefab&& other) noexcept = default;
+    Prefab& operator=(Prefab&& other) noexcept;
+
+    /// Returns the set of the components of the prefab
+    const Signature& signature() const {
+        return signature_;
+    }
+
+    /// Returns a component of the prefab, or nullptr if it has no T
+    template<typename T>
+    T* get_component() {
+        return static_cast<T*>(find(component_id<T>()));
+    }
+
+    /// @copydoc get_component()
+    template<typename T>
+    const T* get_component() const {
+        return static_cast<const T*>(find(component_id<T>()));
+    }
+
+    /// Returns a component of the prefab, or nullptr if it has no such
+    /// component
+    void* find(Component_id component) const;
+
+private:
+    struct Component_record {
+        Component_id component;
+        std::size_t offset;
+    };
+
+    Signature signature_;
+    std::vector<Component_record> components_;
+    std::unique_ptr<Byte[]> data_;
+
+    static constexpr std::size_t aligned(std::size_t size) {
+        return (size + alignof(std::max_align_t) - 1)
+                / alignof(std::max_align_t) * alignof(std::max_align_t);
+    }
+
+    template<typename T>
+    void emplace(T&& component);
+
+    void destroy_components();
+};
+
+template<typename... Components>
+Prefab::Prefab(Components&&... components)
+    : signature_{make_signature<std::decay_t<Components>...>()}
+{
+    assert(signature_.count() == sizeof...(Components)
+           && "Create a prefab with duplicated component types");
+
+    const std::size_t sizes[] = {0, aligned(sizeof(std::decay_t<Components>))...};
+    std::size_t size = 0;
+    for (auto component_size : sizes) size += component_size;
+
+    // Allocations of Byte arrays are aligned for any object that fits in them
+    data_.reset(new Byte[size]);
+    components_.reserve(sizeof...(Components));
+    try {
+        const int expand[] = {0, (emplace(std::forward<Components>(components)),
+                                  0)...};
+        static_cast<void>(expand);
+    } catch (...) {
+        destroy_components();
+        throw;
+    }
+}
+
+template<typename T>
+void Prefab::emplace(T&& component)
+{
+    using Component = std::decay_t<T>;
+    static_assert(std::is_copy_constructible<Component>::value,
+                  "Component of a prefab need to be copy constructible");
+
+    const auto offset = components_.empty()
+            ? 0
+            : components_.back().offset
+              + aligned(component_info(components_.back().component).size);
+    new (data_.get() + offset) Component(std::forward<T>(component));
+    components_.push_back(Component_record{component_id<Component>(), offset});
+}
+
+}} // namespace bolder::ecs
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bolder/ecs/archetype.hpp"
+#include "bolder/ecs/component.hpp"
+#include "bolder/ecs/world.hpp"
+#include "bolder/thread_pool.hpp"
+
+namespace bolder { namespace ecs {
+
+/**
+ * @brief The rows of a chunk that a Query visits.
+ * @ingroup ecs_group
+ */
+template<typename... Components>
+class Chunk_view {
+public:
+    Chunk_view(const Archetype& archetype, Chunk& chunk,
+               Components*... columns)
+        : archetype_{&archetype}, chunk_{&chunk}, columns_{columns...} {}
+
+    uint32 size() const {
+        return chunk_->size();
+    }
+
+    const Entity* entities() const {
+        return archetype_->entities(*chunk_);
+    }
+
+    /// Returns the contiguous column of a component type of the query
+    template<typename T>
+    T* column() const {
+        return std::get<T*>(columns_);
+    }
+
+    /**
+     * @brief Returns the shared component T of all the rows.
+     *
+     * The query must require T, for example with Query::with().
+     */
+    template<typename T>
+    const T& shared() const {
+        static_assert(is_shared_component<T>::value, "Component is not shared");
+        assert(archetype_->column_index(component_id<T>()) != Archetype::npos);
+        return *archetype_->template column<const T>(*chunk_);
+    }
+
+private:
+    const Archetype* archetype_;
+    Chunk* chunk_;
+    std::tuple<Components*...> columns_;
+};
+
+/**
+ * @brief Iterates over the entities that have all of the Components.
+ * @ingroup ecs_group
+ *
+ * A query visits the chunks of every matching archetype in turn, so the
+ * components it reads are contiguous in memory. A component type marked as
+ * const is only read by the query.
+ *
+ * The matching archetypes come from a Query_cache of the World, which is looked
+ * up when the query is built and kept up to date as archetypes are created.
+ * Keep a query across frames, for example as a member of a System, to not even
+ * pay for the lookup.
+ *
+ * Entities must not be created or destroyed, and components must not be added
+ * or removed, while a query iterates.
+ *
+ * Tags and shared components have no column, so they cannot be Components of a
+ * query. with<T>() only visits the entities that have them, and
+ * Chunk_view::shared() reads the shared components of a chunk, so that a
+ * renderer can batch the chunks by material without looking at every entity.
+ *
+ * Iterating marks the non-const component columns of every visited chunk as
+ * changed. Filters skip whole chunks: changed<T>() keeps the chunks whose
+ * column of T changed after the since() tick, and added<T>() the chunks that
+ * got new rows after it. A system usually passes its System::last_run() tick.
+ * Adding a filter that the query already has does nothing, so a query that is
+ * kept across frames can set its filters every frame.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Query<Position, const Velocity> query {world};
+ * query.each([dt](Position& position, const Velocity& velocity) {
+ *     position.x += velocity.x * dt;
+ *     position.y += velocity.y * dt;
+ * });
+ * @endcode
+ *
+ * @par Example of filters
+ * @code{.cpp}
+ * Query<Bounds, const Position> query {world};
+ * query.changed<Position>().since(last_run()).each(update_bounds);
+ * @endcode
+ *
+ * The par_ functions spread the chunks over the threads of a Thread_pool with
+ * parallel_for, for a single system that has a lot of entities to update. They
+ * can give every thread its own context, for example to sum a value over all
+ * the entities without synchronization.
+ *
+ * @par Example of shared components
+ * @code{.cpp}
+ * Query<const Sprite> query {world};
+ * query.with<Visible>().with<Material>().each_chunk([&](const auto& view) {
+ *     renderer.draw(view.template shared<Material>().texture,
+ *                   view.template column<const Sprite>(), view.size());
+ * });
+ * @endcode
+ *
+ * @par Example of parallel iteration
+ * @code{.cpp}
+ * auto energies = query.par_each(pool, 0.f,
+ *         [](float& energy, const Velocity& velocity, const Mass& mass) {
+ *     energy += mass.value * velocity.length_square() / 2;
+ * });
+ * const auto energy = std::accumulate(energies.begin(), energies.end(), 0.f);
+ * @endcode
+ */
+template<typename... Components>
+class Query {
+public:
+    using chunk_view = Chunk_view<Components...>;
+
+    explicit Query(World& world)
+        : world_{world},
+          cache_{&world.query_cache(
+                     make_signature<std::remove_const_t<Components>...>())} {
+        const bool columns[] = {true, is_column<Components>()...};
+        static_cast<void>(columns);
+    }
+
+    /// Only visits the entities that have T, which can be a tag or a shared
+    /// component
+    template<typename T>
+    Query& with() {
+        require(component_id<T>());
+        return *this;
+    }
+
+    /// Only visits the chunks where T changed after the since() tick
+    template<typename T>
+    Query& changed() {
+        add_filter(changed_, component_id<T>());
+        return *this;
+    }
+
+    /// Only visits the chunks that got new rows after the since() tick
+    template<typename T>
+    Query& added() {
+        add_filter(added_, component_id<T>());
+        return *this;
+    }
+
+    /// Sets the tick that the changed() and added() filters compare against
+    Query& since(uint32 tick) {
+        since_ = tick;
+        return *this;
+    }
+
+    /// Calls f with a chunk_view of every non-empty matching chunk
+    template<typename Function>
+    void each_chunk(Function f) const {
+        const auto tick = world_.write_tick();
+        visit_chunks([&f, tick](Archetype& archetype, Chunk& chunk) {
+            mark_changed(archetype, chunk, tick);
+            f(make_view(archetype, chunk));
+        });
+    }
+
+    /// Calls f with references to the Components of every matching entity
+    template<typename Function>
+    void each(Function f) const {
+        each_chunk([&f](const chunk_view& view) {
+            for (auto row = 0u; row != view.size(); ++row) {
+                f(view.template column<Components>()[row]...);
+            }
+        });
+    }
+
+    /**
+     * @brief Calls f with a chunk_view of every non-empty matching chunk, on
+     * the calling thread and the threads of a pool.
+     *
+     * f is called as f(context, view) from several threads at the same time,
+     * where context is the Context of the calling thread. Every thread starts
+     * from a copy of initial.
+     *
+     * @return The contexts of all the threads, to be combined by the caller
+     */
+    template<typename Context, typename Function>
+    std::vector<Context> par_each_chunk(Thread_pool& pool,
+                                        const Context& initial,
+                                        Function f) const {
+        // A context of its own cache lines for every thread, also when
+        // std::vector would pack the contexts, as it does for bool
+        Per_participant<Context> contexts {pool, initial};
+        par_each_chunk(pool, contexts, f);
+
+        std::vector<Context> result;
+        result.reserve(contexts.size());
+        for (std::size_t i = 0; i != contexts.size(); ++i) {
+            result.push_back(std::move(contexts[i]));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Calls f with a chunk_view of every non-empty matching chunk, on
+     * the calling thread and the threads of a pool, with contexts that the
+     * caller keeps.
+     *
+     * f is called as f(context, view), where context is the one of the
+     * participant of the calling thread, for example a Command_buffer of
+     * Command_buffer::participants().
+     */
+    template<typename Context, typename Function>
+    void par_each_chunk(Thread_pool& pool, Per_participant<Context>& contexts,
+                        Function f) const {
+        assert(contexts.size() == pool.size() + 1);
+        const auto tick = world_.write_tick();
+        std::vector<std::pair<Archetype*, Chunk*>> chunks;
+        visit_chunks([&chunks, tick](Archetype& archetype, Chunk& chunk) {
+            mark_changed(archetype, chunk, tick);
+            chunks.emplace_back(&archetype, &chunk);
+        });
+
+        parallel_for(pool, chunks.size(),
+                     [&](std::size_t participant, std::size_t i) {
+            f(contexts[participant],
+              make_view(*chunks[i].first, *chunks[i].second));
+        });
+    }
+
+    /**
+     * @brief Calls f with a context and references to the Components of every
+     * matching entity, on the calling thread and the threads of a pool.
+     *
+     * f is called as f(context, components...) from several threads at the
+     * same time, with the contexts described in par_each_chunk().
+     *
+     * @return The contexts of all the threads, to be combined by the caller
+     */
+    template<typename Context, typename Function>
+    std::vector<Context> par_each(Thread_pool& pool, const Context& initial,
+                                  Function f) const {
+        return par_each_chunk(pool, initial,
+                              [&f](Context& context, const chunk_view& view) {
+            for (auto row = 0u; row != view.size(); ++row) {
+                f(context, view.template column<Components>()[row]...);
+            }
+        });
+    }
+
+    /// Calls f as f(context, components...) for every matching entity, with the
+    /// contexts of par_each_chunk(Thread_pool&, Per_participant<Context>&,
+    /// Function)
+    template<typename Context, typename Function>
+    void par_each(Thread_pool& pool, Per_participant<Context>& contexts,
+                  Function f) const {
+        par_each_chunk(pool, contexts,
+                       [&f](Context& context, const chunk_view& view) {
+            for (auto row = 0u; row != view.size(); ++row) {
+                f(context, view.template column<Components>()[row]...);
+            }
+        });
+    }
+
+    /// Calls f with references to the Components of every matching entity, on
+    /// the calling thread and the threads of a pool at the same time
+    template<typename Function>
+    void par_each(Thread_pool& pool, Function f) const {
+        struct No_context {};
+        par_each_chunk(pool, No_context{},
+                       [&f](No_context&, const chunk_view& view) {
+            for (auto row = 0u; row != view.size(); ++row) {
+                f(view.template column<Components>()[row]...);
+            }
+        });
+    }
+
+private:
+    World& world_;
+    const Query_cache* cache_;
+    std::vector<Component_id> changed_;
+    std::vector<Component_id> added_;
+    uint32 since_ = 0;
+
+    template<typename T>
+    static constexpr bool is_column() {
+        using Component = std::remove_const_t<T>;
+        static_assert(!is_tag_component<Component>::value
+                      && !is_shared_component<Component>::value,
+                      "Query tags and shared components with with()");
+        return true;
+    }
+
+    void require(Component_id component) {
+        if (!cache_->signature().test(component)) {
+            auto signature = cache_->signature();
+            cache_ = &world_.query_cache(signature.set(component));
+        }
+    }
+
+    void add_filter(std::vector<Component_id>& filters,
+                    Component_id component) {
+        if (std::find(filters.begin(), filters.end(), component)
+                == filters.end()) {
+            filters.push_back(component);
+            require(component);
+        }
+    }
+
+    bool passes_filters(const Archetype& archetype, const Chunk& chunk) const {
+        for (auto component : changed_) {
+            const auto column = archetype.column_index(component);
+            if (chunk.ticks(column).changed <= since_) return false;
+        }
+        for (auto component : added_) {
+            const auto column = archetype.column_index(component);
+            if (chunk.ticks(column).added <= since_) return false;
+        }
+        return true;
+    }
+
+    // Calls f with every non-empty matching chunk that passes the filters
+    template<typename Function>
+    void visit_chunks(Function f) const {
+        for (auto* archetype : cache_->archetypes()) {
+            for (auto i = 0u; i != archetype->chunk_count(); ++i) {
+                auto& chunk = archetype->chunk(i);
+                if (chunk.size() != 0 && passes_filters(*archetype, chunk)) {
+                    f(*archetype, chunk);
+                }
+            }
+        }
+    }
+
+    static chunk_view make_view(Archetype& archetype, Chunk& chunk) {
+        return chunk_view{archetype, chunk,
+                          archetype.template column<Components>(chunk)...};
+    }
+
+    static void mark_changed(Archetype& archetype, Chunk& chunk, uint32 tick) {
+        const int expand[] = {0, (mark_column_changed<Components>(
+                archetype, chunk, tick), 0)...};
+        static_cast<void>(expand);
+    }
+
+    template<typename T>
+    static void mark_column_changed(Archetype& archetype, Chunk& chunk,
+                                    uint32 tick) {
+        if (!std::is_const<T>::value) {
+            archetype.mark_changed(
+                    chunk,
+                    archetype.column_index(
+                        component_id<std::remove_const_t<T>>()),
+                    tick);
+        }
+    }
+};
+
+}} // namespace bolder::ecs
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bolder/ecs/command_buffer.hpp"
+#include "bolder/ecs/component.hpp"
+#include "bolder/integer.hpp"
+
+namespace bolder {
+
+class Thread_pool;
+
+namespace ecs {
+
+class World;
+
+/**
+ * @brief Component types that a System reads and writes.
+ * @ingroup ecs_group
+ */
+struct Access {
+    Signature reads;
+    Signature writes;
+
+    /// Whether two systems touch the same component and one of them writes it
+    bool conflicts_with(const Access& other) const {
+        return (writes & (other.reads | other.writes)).any()
+                || (reads & other.writes).any();
+    }
+};
+
+/**
+ * @brief Gets the Access of a set of component types.
+ * @ingroup ecs_group
+ *
+ * Component types marked as const are read, and the others are written,
+ * matching the Components of a Query.
+ */
+template<typename... Components>
+Access make_access() {
+    Access access;
+    const int expand[] = {0, (std::is_const<Components>::value
+            ? access.reads.set(component_id<std::remove_const_t<Components>>())
+            : access.writes.set(component_id<std::remove_const_t<Components>>()),
+            0)...};
+    static_cast<void>(expand);
+    return access;
+}
+
+/**
+ * @brief Interface of the systems that update components of a World.
+ * @ingroup ecs_group
+ *
+ * A system declares the component types that it reads and writes, so that a
+ * Scheduler can run it at the same time as the systems that do not conflict
+ * with it. update() must not touch other component types, and must not create
+ * or destroy entities or add or remove components directly; it records those
+ * changes into its Command_buffer instead.
+ */
+class System {
+public:
+    explicit System(const Access& access);
+    virtual ~System();
+
+    System(const System&) = delete;
+    System& operator=(const System&) = delete;
+
+    const Access& access() const {
+        return access_;
+    }
+
+    /**
+     * @brief Returns the change tick of the previous run of this system.
+     *
+     * Pass it to Query::since() to only visit what changed since then. It is
+     * 0 before the first run, so that everything counts as changed.
+     */
+    uint32 last_run() const {
+        return last_run_;
+    }
+
+    /**
+     * @brief Updates the world by dt seconds.
+     * @param commands The command buffer of this system, which is played back
+     * after every system of the frame finishes
+     */
+    virtual void update(World& world, Command_buffer& commands, double dt) = 0;
+
+private:
+    friend class Scheduler;
+
+    Access access_;
+    uint32 last_run_ = 0;
+};
+
+/**
+ * @brief Runs systems in parallel on a Thread_pool.
+ * @ingroup ecs_group
+ *
+ * The scheduler builds a dependency graph from the Access of its systems: a
+ * system depends on every earlier added system that conflicts with it. A
+ * system is dispatched to the pool as soon as all of its dependencies are
+ * finished, so systems that do not conflict run at the same time while
+ * conflicting systems always run in the order they were added.
+ *
+ * Every system has its own Command_buffer. Since a system only runs on one
+ * thread at a time, recording commands needs no locks. After all the systems
+ * finish, run() plays the buffers back in the order the systems were added, so
+ * structural changes are deterministic whichever threads the systems ran on.
+ * A system that spreads its work over the pool records from every thread into
+ * the Command_buffer::participants() of its buffer, which are played back with
+ * it; which participant runs which part of the work is up to the pool.
+ *
+ * Before a system runs, the scheduler advances the change tick of the World,
+ * and records it as System::last_run() afterwards.
+ */
+class Scheduler {
+public:
+    explicit Scheduler(Thread_pool& pool);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /// Adds a system after all the existing ones
+    System& add_system(std::unique_ptr<System> system);
+
+    /// Constructs a system of type T and adds it after all the existing ones
+    template<typename T, typename... Args>
+    T& emplace_system(Args&&... args) {
+        auto system = std::make_unique<T>(std::forward<Args>(args)...);
+        auto& result = *system;
+        add_system(std::move(system));
+        return result;
+    }
+
+    /// Returns the number of systems
+    std::size_t size() const {
+        return nodes_.size();
+    }
+
+    /**
+     * @brief Runs every system once, waits for all of them to finish, and then
+     * plays back their commands.
+     *
+     * If systems throw, the remaining systems still run and the first exception
+     * is rethrown after they finish, without playing back any command.
+     */
+    void run(World& world, double dt);
+
+private:
+    struct Node {
+        Node(std::unique_ptr<System> node_system, uint32 dependencies);
+        Node(Node&&) = default;
+        Node& operator=(Node&&) = default;
+        ~Node();
+
+        std::unique_ptr<System> system;
+        std::unique_ptr<Command_buffer> commands;
+        std::vector<std::size_t> dependents;
+        uint32 dependency_count;
+    };
+
+    Thread_pool& pool_;
+    std::vector<Node> nodes_;
+    // Unfinished dependencies of every node in the current run
+    std::vector<std::atomic<uint32>> pending_;
+
+    std::mutex mutex_; // Protects remaining_ and error_
+    std::condition_variable finished_;
+    std::size_t remaining_ = 0;
+    std::exception_ptr error_;
+
+    void dispatch(std::size_t index, World& world, double dt);
+    void execute(std::size_t index, World& world, double dt);
+};
+
+}} // namespace bolder::ecs
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "bolder/byte.hpp"
+
+/**
+ * @file snapshot.hpp
+ * @brief Binary memory images of ECS worlds.
+ */
+
+namespace bolder { namespace ecs {
+
+class World;
+
+/**
+ * @brief Appends a snapshot of a world to out.
+ * @ingroup ecs_group
+ *
+ * A snapshot is a relocatable memory image of the entity table and of every
+ * archetype, with the entities and each component column stored contiguously
+ * in the same layout as in chunks. Loading it copies the columns into chunks in
+ * bulk, without parsing any component.
+ *
+ * Component types are identified by their Component_info::name, so a snapshot
+ * can only be loaded by a build of the same program, after it registers every
+ * component type of the snapshot with component_id(). Component types must have
+ * distinct names; types in anonymous namespaces of different files can share
+ * one. The format uses the byte order of the machine that writes it.
+ *
+ * @throw Runtime_error if a component is not trivially copyable, or is shared
+ */
+void save_snapshot(const World& world, std::vector<Byte>& out);
+
+/**
+ * @brief Writes a snapshot of a world to a file.
+ * @throw Runtime_error if a component is not trivially copyable or is shared,
+ * or the file cannot be written
+ */
+void save_snapshot(const World& world, const char* filename);
+
+/**
+ * @brief Loads a snapshot into a world that never had any entity.
+ * @ingroup ecs_group
+ * @param data The snapshot, aligned to 16 bytes
+ *
+ * The entities keep their indices and generations, so components that refer
+ * to other entities stay valid. Every loaded chunk is marked as added and
+ * changed at the change tick of the snapshot.
+ *
+ * @throw Runtime_error if the world had entities, the snapshot is invalid or
+ * misaligned, or one of its component types is not registered in this program
+ * with the same size
+ */
+void load_snapshot(World& world, const Byte* data, std::size_t size);
+
+/**
+ * @brief Maps a snapshot file and loads it into a world that never had any
+ * entity.
+ * @throw Runtime_error in the same cases as load_snapshot(World&, const Byte*,
+ * std::size_t), or if the file cannot be mapped
+ */
+void load_snapshot(World& world, const char* filename);
+
+}} // namespace bolder::ecs
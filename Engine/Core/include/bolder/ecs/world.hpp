@@ -0,0 +1,379 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bolder/byte.hpp"
+#include "bolder/ecs/archetype.hpp"
+#include "bolder/ecs/component.hpp"
+#include "bolder/ecs/entity.hpp"
+#include "bolder/exception.hpp"
+
+namespace bolder { namespace ecs {
+
+class Prefab;
+
+/**
+ * @brief The archetypes that have all the components of a signature.
+ * @ingroup ecs_group
+ *
+ * The World owns the caches and appends every archetype that it creates to the
+ * caches that it matches, so a Query walks a prebuilt list instead of testing
+ * every archetype.
+ */
+class Query_cache {
+public:
+    explicit Query_cache(const Signature& signature) : signature_{signature} {}
+
+    const Signature& signature() const {
+        return signature_;
+    }
+
+    /// Returns the matching archetypes, in order of creation
+    const std::vector<Archetype*>& archetypes() const {
+        return archetypes_;
+    }
+
+private:
+    friend class World;
+
+    Signature signature_;
+    std::vector<Archetype*> archetypes_;
+
+    bool matches(const Archetype& archetype) const {
+        return (archetype.signature() & signature_) == signature_;
+    }
+};
+
+/**
+ * @brief Container of all the entities and their components.
+ * @ingroup ecs_group
+ *
+ * Entities that have the same set of components are grouped into an
+ * Archetype, which stores the components in fixed-size chunks of contiguous
+ * columns. Adding or removing a component moves an entity to another
+ * archetype. Use a Query to iterate over the components of entities.
+ *
+ * An entity is an index together with a generation. Destroying an entity
+ * increments the generation of its index, and the index is reused by later
+ * entities, so the tables indexed by entities stay as small as the number of
+ * entities alive at the same time. A destroyed entity never compares equal to
+ * a later one, and checking whether an entity is alive is O(1).
+ *
+ * The World keeps a change tick that the Scheduler advances before every system
+ * runs. Writing a component through get_component() or a Query marks the
+ * column of its chunk with the current tick, and creating or moving entities
+ * into a chunk marks all of its columns, so that a query can skip the chunks
+ * that did not change since a given tick.
+ *
+ * The World keeps a Query_cache for every signature that queries ask for, and
+ * updates them as it creates archetypes.
+ *
+ * Tag components only exist in signatures. A shared component is stored once
+ * per chunk, and writing it through get_component() changes it for every entity
+ * of the chunk; set_shared_component() moves a single entity to a chunk of the
+ * new value instead.
+ *
+ * Destroying and moving entities leaves holes in chunks. Call compact() between
+ * frames to refill them and free the chunks that become empty, so that queries
+ * and memory use do not degrade as entities churn.
+ *
+ * Components must be nothrow move constructible, since entities are moved
+ * between rows.
+ *
+ * @par Example
+ * @code{.cpp}
+ * World world;
+ * auto entity = world.create_entity(Position{0, 0}, Velocity{1, 0});
+ * world.add_component(entity, Sprite{texture});
+ * world.get_component<Position>(entity)->x = 10;
+ * @endcode
+ */
+class World {
+public:
+    using size_type = uint32;
+
+    World();
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    /// Creates an entity that has no component
+    Entity create_entity();
+
+    /// Creates an entity that has the components
+    template<typename... Components>
+    Entity create_entity(Components&&... components);
+
+    /**
+     * @brief Creates count copies of a prefab.
+     * @param entities Receives the created entities
+     *
+     * The copies are created in consecutive rows of the archetype of the
+     * prefab, with one signature lookup and chunk allocation for all of them.
+     * If a copy constructor throws, no entity is created.
+     */
+    void instantiate(const Prefab& prefab, size_type count, Entity* entities);
+
+    /// Creates count copies of a prefab and returns them
+    std::vector<Entity> instantiate(const Prefab& prefab, size_type count);
+
+    /**
+     * @brief Destroys an entity and all of its components.
+     * @throw Runtime_error if the entity is not alive.
+     */
+    void destroy_entity(Entity entity);
+
+    /// Returns whether an entity is created and not yet destroyed
+    bool alive(Entity entity) const;
+
+    /// Returns the number of alive entities
+    size_type size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Adds a component to an entity.
+     * @return Reference to the added component, which is valid until the next
+     * structural change of the World
+     * @throw Runtime_error if the entity is not alive or already has a T.
+     */
+    template<typename T>
+    std::decay_t<T>& add_component(Entity entity, T&& component);
+
+    /**
+     * @brief Removes a component from an entity.
+     * @throw Runtime_error if the entity is not alive or has no T.
+     */
+    template<typename T>
+    void remove_component(Entity entity);
+
+    /**
+     * @brief Gets a component of an entity.
+     * @return A pointer to the component; nullptr if the entity is not alive or
+     * has no T. The pointer is valid until the next structural change of the
+     * World.
+     *
+     * The non-const overload marks the component as changed.
+     */
+    template<typename T>
+    T* get_component(Entity entity);
+
+    /// @copydoc get_component(Entity)
+    template<typename T>
+    const T* get_component(Entity entity) const;
+
+    /**
+     * @brief Sets a shared component of an entity, moving the entity to a
+     * chunk that has the value.
+     * @throw Runtime_error if the entity is not alive or has no T.
+     */
+    template<typename T>
+    void set_shared_component(Entity entity, const T& component);
+
+    template<typename T>
+    bool has_component(Entity entity) const {
+        return get_component<T>(entity) != nullptr;
+    }
+
+    /**
+     * @brief Moves entities to fill the holes in the chunks of every
+     * archetype, and frees the chunks that become empty.
+     * @param budget Time after which compaction stops; at least one batch of
+     * rows is moved if there is anything to compact
+     * @return Whether every archetype is compact, otherwise the next call
+     * resumes where this one stopped
+     *
+     * Compaction is a structural change, so it must not run while a Query
+     * iterates the World.
+     */
+    bool compact(std::chrono::steady_clock::duration budget);
+
+    /// Returns all the archetypes, in order of creation
+    const std::vector<std::unique_ptr<Archetype>>& archetypes() const {
+        return archetypes_;
+    }
+
+    /**
+     * @brief Returns the cache of the archetypes that have all the components
+     * of a signature.
+     *
+     * The cache is created by the first call for a signature, and lives as long
+     * as the World. Thread-safe.
+     */
+    const Query_cache& query_cache(const Signature& signature);
+
+    /// Returns the tick of the World, that changes outside of systems are
+    /// marked with
+    uint32 change_tick() const {
+        return change_tick_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the tick that changes on the calling thread are marked
+     * with.
+     *
+     * While a Scheduler runs a system on the calling thread, this is the tick
+     * of that run, which becomes the System::last_run() of the system, so that
+     * the system does not see its own changes in its next run even when other
+     * systems advance the tick at the same time. Otherwise it is
+     * change_tick().
+     */
+    uint32 write_tick() const;
+
+    /// Advances the change tick and returns the new tick. Thread-safe.
+    uint32 increment_change_tick() {
+        return change_tick_.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+private:
+    friend class Command_buffer;
+    friend class Scheduler;
+    friend void save_snapshot(const World& world, std::vector<Byte>& out);
+    friend void load_snapshot(World& world, const Byte* data,
+                              std::size_t size);
+
+    struct Entity_record {
+        // The archetype is null if no alive entity has this index
+        Entity_location location;
+        // Generation of the alive entity, or of the next entity that reuses
+        // the index
+        uint32 generation;
+    };
+
+    std::vector<std::unique_ptr<Archetype>> archetypes_;
+    std::unordered_map<Signature, Archetype*> archetype_index_;
+    std::mutex query_caches_mutex_;
+    std::unordered_map<Signature, std::unique_ptr<Query_cache>> query_caches_;
+    // Record of every entity by index
+    std::vector<Entity_record> records_;
+    // Indices of destroyed entities that can be reused
+    std::vector<uint32> free_indices_;
+    size_type size_ = 0;
+    std::atomic<uint32> change_tick_;
+    // Archetype that the next compact() starts from
+    std::size_t compact_cursor_ = 0;
+
+    /// Finds the archetype of a signature, or creates it
+    Archetype& archetype(const Signature& signature);
+
+    // Sets the write_tick() of the calling thread while it runs a system, or
+    // clears it with 0
+    void set_system_tick(uint32 tick);
+
+    Entity_location& checked_location(Entity entity);
+    Entity new_entity(Archetype& archetype, const Byte* shared);
+    void new_entities(Archetype& archetype, uint32 count, Entity* entities,
+                      const Byte* shared);
+    Entity reserve_entity();
+
+    /// Moves an entity to the archetype with one more component, and returns
+    /// the uninitialized storage of that component. value is only read if the
+    /// component is shared, and is the value of the chunk to move to.
+    void* insert_component(Entity entity, Component_id component,
+                           const void* value);
+    void erase_component(Entity entity, Component_id component);
+    /// Returns a component of an entity, or nullptr if it is not alive or
+    /// has no such component
+    void* find_component(Entity entity, Component_id component) const;
+    void* write_component(Entity entity, Component_id component);
+    void set_shared(Entity entity, Component_id component, const void* value);
+    void move_entity(Entity entity, Archetype& target, Component_id component,
+                     const void* value);
+    void remove_row(const Entity_location& location);
+    std::vector<Byte> shared_values(const Entity_location& location,
+                                    const Archetype& target,
+                                    Component_id component,
+                                    const void* value) const;
+
+    template<typename T>
+    static void copy_shared(const Archetype& archetype, Byte* shared,
+                            const T& component);
+};
+
+template<typename... Components>
+Entity World::create_entity(Components&&... components)
+{
+    const auto signature = make_signature<std::decay_t<Components>...>();
+    assert(signature.count() == sizeof...(Components)
+           && "Create an entity with duplicated component types");
+
+    auto& target = archetype(signature);
+    std::vector<Byte> shared(target.shared_size());
+    const int copies[] = {0, (copy_shared(target, shared.data(), components),
+                              0)...};
+    static_cast<void>(copies);
+
+    // Constructing a shared component writes the value that its chunk already
+    // has, and a tag the scratch slot of its chunk
+    const auto entity = new_entity(target, shared.data());
+    const auto& location = records_[entity.index()].location;
+    const int expand[] = {0, (new (location.archetype->component(
+            location, component_id<std::decay_t<Components>>()))
+            std::decay_t<Components>(std::forward<Components>(components)),
+            0)...};
+    static_cast<void>(expand);
+    return entity;
+}
+
+template<typename T>
+std::decay_t<T>& World::add_component(Entity entity, T&& component)
+{
+    using Component = std::decay_t<T>;
+    // Constructs the component before moving the entity, since only the move
+    // constructor of components is guaranteed not to throw
+    Component value(std::forward<T>(component));
+    return *new (insert_component(entity, component_id<Component>(), &value))
+            Component(std::move(value));
+}
+
+template<typename T>
+void World::remove_component(Entity entity)
+{
+    erase_component(entity, component_id<T>());
+}
+
+template<typename T>
+void World::set_shared_component(Entity entity, const T& component)
+{
+    static_assert(is_shared_component<T>::value, "Component is not shared");
+    set_shared(entity, component_id<T>(), &component);
+}
+
+template<typename T>
+T* World::get_component(Entity entity)
+{
+    return static_cast<T*>(write_component(entity, component_id<T>()));
+}
+
+template<typename T>
+const T* World::get_component(Entity entity) const
+{
+    return static_cast<const T*>(find_component(entity, component_id<T>()));
+}
+
+// Copies a shared component into the block of shared components of a row
+template<typename T>
+void World::copy_shared(const Archetype& archetype, Byte* shared,
+                        const T& component)
+{
+    const auto& info = component_info(component_id<T>());
+    if (info.shared) {
+        const auto column = archetype.column_index(component_id<T>());
+        std::memcpy(shared + archetype.shared_offset(column),
+                    static_cast<const void*>(std::addressof(component)),
+                    info.size);
+    }
+}
+
+}} // namespace bolder::ecs
@@ -9,11 +9,12 @@
   */
 
 #include <algorithm>
-#include <cassert>
+#include <atomic>
 #include <vector>
-#include <functional>
+#include <memory>
 #include <mutex>
 
+#include "bolder/delegate.hpp"
 #include "bolder/exception.hpp"
 
 namespace bolder { namespace event {
@@ -145,6 +146,13 @@ struct Handler_trait {
 namespace detail {
 
 // A global channel per event type
+//
+// The handlers are published as an immutable list. Adding or removing a
+// handler copies the list and swaps the copy in, while broadcast() only reads
+// the current list, without locking, allocating or copying. A replaced list is
+// retired until no broadcast() runs, since one may still be reading it; then
+// either the next change of the handlers or the last broadcast() to finish
+// frees it.
 template<class Event>
 class Internal_static_channel {
 public:
@@ -160,17 +168,27 @@ public:
     void broadcast(const Event& event);
 
 private:
-    using Handler = std::function<void(const Event&)>;
-
-    std::mutex handlers_mutex_; // Protects handlers
-    std::vector<void*> original_ptrs_;
-    std::vector<Handler> handlers_;
+    // Calls the operator() of a handler, which also identifies it
+    using Handler = Delegate<void(const Event&)>;
+    using Handler_list = std::vector<Handler>;
+
+    std::mutex handlers_mutex_; // Protects the lists, but not the snapshot
+    std::unique_ptr<const Handler_list> handlers_;
+    std::vector<std::unique_ptr<const Handler_list>> retired_;
+    // The list that broadcasts read, or null when there is no handler
+    std::atomic<const Handler_list*> snapshot_ {nullptr};
+    std::atomic<int> active_broadcasts_ {0};
+    // Whether retired_ is not empty, to not lock after every broadcast
+    std::atomic<bool> has_retired_ {false};
 
     Internal_static_channel() {}
 
-    void validate() const {
-        assert(original_ptrs_.size() == handlers_.size());
+    Handler_list copy_handlers() const {
+        return handlers_ ? *handlers_ : Handler_list{};
     }
+
+    void publish(Handler_list handlers);
+    void finish_broadcast();
 };
 
 template<class Event>
@@ -183,47 +201,81 @@ template<class Event>
 template <typename T>
 void Internal_static_channel<Event>::add_handler(T& handler) {
     std::lock_guard<std::mutex> lock(handlers_mutex_);
-    original_ptrs_.push_back(&handler);
-    handlers_.push_back(
-                [&handler] (const Event& event) {
-        handler(event);
-    }
-    );
-
-    validate();
+    auto handlers = copy_handlers();
+    handlers.push_back(Handler::bind(handler));
+    publish(std::move(handlers));
 }
 
 template<class Event>
 template <typename T>
 void Internal_static_channel<Event>::remove_handler(T& handler) {
     std::lock_guard<std::mutex> lock(handlers_mutex_);
-    const auto it = std::find(original_ptrs_.begin(), original_ptrs_.end(),
-                              &handler);
-    if (it == original_ptrs_.end()) {
+    auto handlers = copy_handlers();
+    const auto it = std::find(handlers.begin(), handlers.end(),
+                              Handler::bind(handler));
+    if (it == handlers.end()) {
         throw Runtime_error {
             "Tried to remove a handler that was not in the handler list"
         };
     }
 
-    const auto index = it - original_ptrs_.begin();
-    std::iter_swap(it, original_ptrs_.end() - 1);
-    std::iter_swap(handlers_.begin() + index, handlers_.end() - 1);
-    original_ptrs_.pop_back();
-    handlers_.pop_back();
+    std::iter_swap(it, handlers.end() - 1);
+    handlers.pop_back();
+
+    publish(std::move(handlers));
+}
+
+// Swaps in a new list; must be called with handlers_mutex_ locked
+template<class Event>
+void Internal_static_channel<Event>::publish(Handler_list handlers) {
+    std::unique_ptr<const Handler_list> published;
+    if (!handlers.empty()) {
+        published = std::make_unique<const Handler_list>(std::move(handlers));
+    }
+    snapshot_.store(published.get());
+    if (handlers_) {
+        retired_.push_back(std::move(handlers_));
+        has_retired_.store(true);
+    }
+    handlers_ = std::move(published);
 
-    validate();
+    // A broadcast that starts after the store reads the new list, so when none
+    // runs, no one reads the retired ones
+    if (active_broadcasts_.load() == 0) {
+        retired_.clear();
+        has_retired_.store(false);
+    }
 }
 
 template<class Event>
 void Internal_static_channel<Event>::broadcast(const Event& event) {
-    std::vector<Handler> local_queue(handlers_.size());
-    {
-        std::lock_guard<std::mutex> lock(handlers_mutex_);
-        local_queue = handlers_;
+    ++active_broadcasts_;
+    const auto handlers = snapshot_.load();
+    if (handlers) {
+        try {
+            for (const auto& handler: *handlers)
+                handler(event);
+        } catch (...) {
+            finish_broadcast();
+            throw;
+        }
     }
+    finish_broadcast();
+}
 
-    for (auto& handler: local_queue)
-        handler(event);
+// Frees the retired lists when the last running broadcast finishes. It does
+// not wait for the mutex: whoever holds it is changing the handlers, and a
+// later broadcast or change frees the lists instead.
+template<class Event>
+void Internal_static_channel<Event>::finish_broadcast() {
+    if (--active_broadcasts_ != 0 || !has_retired_.load()) return;
+
+    std::unique_lock<std::mutex> lock(handlers_mutex_, std::try_to_lock);
+    // A broadcast that starts while the lock is held reads the current list
+    if (lock.owns_lock() && active_broadcasts_.load() == 0) {
+        retired_.clear();
+        has_retired_.store(false);
+    }
 }
 
 } // namespace detail
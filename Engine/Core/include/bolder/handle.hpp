@@ -7,6 +7,12 @@ namespace bolder { namespace resource {
 template<typename Handle, typename T, int capacity = 4096>
 class Handle_manager;
 
+template<typename Handle, typename T, uint32 page_size = 256>
+class Paged_handle_manager;
+
+template<typename Handle, typename T, uint32 capacity = 4096>
+class Concurrent_handle_manager;
+
 /**
  * @class Handle
  * @ingroup resource_group
@@ -29,6 +35,8 @@ class Handle_manager;
  * @endcode
  *
  * @see Handle_manager about how to manage underlying resource using handles.
+ * @see Paged_handle_manager for a manager that grows on demand.
+ * @see Concurrent_handle_manager for a manager shared between threads.
  */
 template <uint8 N>
 struct Handle {
@@ -39,7 +47,7 @@ struct Handle {
     static constexpr auto generation_bits = 32 - N;
 
     /// Default constructor creates a handle with an invalid generation
-    Handle() {
+    Handle() : index_{0}, generation_{0} {
         --generation_;
     }
 
@@ -58,6 +66,12 @@ private:
     template<typename Handle, typename T, int capacity>
     friend class Handle_manager;
 
+    template<typename Handle, typename T, uint32 page_size>
+    friend class Paged_handle_manager;
+
+    template<typename Handle, typename T, uint32 capacity>
+    friend class Concurrent_handle_manager;
+
     // Prevent outside code from creating handles
     Handle(uint32 index, uint32 generation)
         : index_{index}, generation_{generation}
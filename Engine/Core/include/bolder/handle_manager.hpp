@@ -6,21 +6,72 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "bolder/byte.hpp"
 #include "bolder/handle.hpp"
 #include "bolder/resource_error.hpp"
 
 namespace bolder { namespace resource {
 
 namespace detail {
+// Header of a Handle_manager snapshot, followed by the raw arrays of the
+// manager
+struct Handle_snapshot_header {
+    static constexpr uint32 magic_number = 0x53484442; // "BDHS"
+    static constexpr uint32 current_version = 1;
+
+    uint32 magic;
+    uint32 version;
+    uint32 element_size;
+    uint32 capacity;
+    uint32 index_bits;
+    uint32 size;
+    uint32 first_free_entry;
+};
+
 template<typename Handle>
 struct Handle_entry {
-    uint32 next_free_index : Handle::index_bits;
+    // Index of the next free entry when this entry is free; otherwise the
+    // position of its element in the dense element array
+    uint32 index : Handle::index_bits;
     uint32 generation : Handle::generation_bits;
 };
 }
 
+/**
+ * @class Handle_manager
+ * @ingroup resource_group
+ * @brief Owns data that are referred by Handle
+ * @tparam Handle The handle type that refers to the managed data
+ * @tparam T Type of managed data
+ * @tparam capacity Maximum number of data the manager can hold
+ *
+ * Handle_manager is a sparse set: every handle index refers to an entry that
+ * stores its generation and the position of its element inside a densely
+ * packed element array. Live elements are always contiguous, so visiting every
+ * element costs time in proportion to size() instead of capacity. Elements are
+ * kept in insertion order, except that removing an element moves the last
+ * element into its place.
+ *
+ * Elements live in uninitialized storage: an element is only constructed when
+ * it is added and destroyed when it is removed, so T needs neither a default
+ * constructor nor a copy constructor. Removing an element move-constructs the
+ * last element into its place, so T only needs a move constructor that does
+ * not throw, and no assignment.
+ *
+ * If T is trivially copyable, the whole state of a manager can be captured by
+ * snapshot() and brought back by restore(). Both are a handful of memcpy
+ * calls, and every handle that was valid when the snapshot was taken is valid
+ * again after the restore.
+ *
+ * @see Paged_handle_manager for a manager that grows on demand.
+ */
 template<typename Handle, typename T, int capacity>
 class Handle_manager {
     static constexpr auto max_capacity = 1u << Handle::index_bits;
@@ -30,6 +81,9 @@ public:
     using value_type = T;
     using size_type = uint32;
 
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
     Handle_manager() {
         size_type next = 1u;
         std::generate(handles_.begin(), handles_.end(), [&next]() {
@@ -39,10 +93,40 @@ public:
         });
     }
 
+    ~Handle_manager();
+
+    Handle_manager(const Handle_manager&) = delete;
+    Handle_manager& operator=(const Handle_manager&) = delete;
+
     Handle add(value_type value);
 
+    /// Constructs a new element in place from args
+    template<typename... Args>
+    Handle emplace(Args&&... args);
+
     void remove(Handle handle);
 
+    /// @name Batched operations
+    /// Each batched operation validates its whole batch once up front.
+    ///@{
+    void add_n(const value_type* values, size_type count, Handle* handles);
+
+    void remove_n(const Handle* handles, size_type count);
+
+    size_type resolve_n(const Handle* handles, size_type count,
+                        const value_type** values) const;
+    ///@}
+
+    /// @name Snapshot
+    /// Only available when T is trivially copyable.
+    ///@{
+    std::size_t snapshot_size() const;
+
+    void snapshot(std::vector<Byte>& buffer) const;
+
+    void restore(const Byte* data, std::size_t size);
+    ///@}
+
     /**
      * @brief Gets underlying variable that a handle refer to.
      * @param handle
@@ -51,48 +135,363 @@ public:
      */
     const value_type* operator[](Handle handle) const {
         const auto index = handle.index();
-        if (handle.generation() != handles_[index].generation) {
+        // Also test liveness: after a restore(), a handle created later may
+        // carry the generation of an entry that is free in the snapshot
+        if (!actives_[index]
+                || handle.generation() != handles_[index].generation) {
             return nullptr;
         }
 
-        return &elems_[index];
+        return &elem(handles_[index].index);
+    }
+
+    /// @copydoc operator[](Handle) const
+    value_type* operator[](Handle handle) {
+        const auto& self = *this;
+        return const_cast<value_type*>(self[handle]);
     }
 
     size_type size() const;
 
+    /// @name Dense iteration
+    /// Live elements are stored contiguously in [begin(), end()).
+    ///@{
+    iterator begin() { return &elem(0); }
+    iterator end() { return &elem(0) + size_; }
+    const_iterator begin() const { return &elem(0); }
+    const_iterator end() const { return &elem(0) + size_; }
+    ///@}
+
+    /// Calls f on every live element
+    template<typename Function>
+    void for_each(Function f) {
+        std::for_each(begin(), end(), f);
+    }
+
+    /// Calls f on every live element
+    template<typename Function>
+    void for_each(Function f) const {
+        std::for_each(begin(), end(), f);
+    }
+
 private:
-    std::bitset<capacity> actives_;
-    std::array<detail::Handle_entry<Handle>, capacity> handles_;
-    std::array<T, capacity> elems_;
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    static constexpr auto slots = static_cast<std::size_t>(capacity);
+
+    std::bitset<slots> actives_;
+    std::array<detail::Handle_entry<Handle>, slots> handles_;
+    std::array<Storage, slots> elems_;
+    // Entry index of every element in the dense array
+    std::array<uint32, slots> entry_indices_;
     size_type size_ = 0;
     size_type first_free_entry_ = 0;
+
+    value_type& elem(size_type dense_index) {
+        return *reinterpret_cast<T*>(&elems_[dense_index]);
+    }
+
+    const value_type& elem(size_type dense_index) const {
+        return *reinterpret_cast<const T*>(&elems_[dense_index]);
+    }
+
+    Handle link_last_element();
+    void validate(Handle handle) const;
+    void erase(uint32 index);
+    static bool links_consistent(const detail::Handle_snapshot_header& header,
+                                 const Byte* arrays);
 };
 
 template<typename Handle, typename T, int capacity>
-Handle Handle_manager<Handle, T, capacity>::add(T elem) {
+Handle_manager<Handle, T, capacity>::~Handle_manager() {
+    for (auto& value : *this) {
+        value.~T();
+    }
+}
+
+template<typename Handle, typename T, int capacity>
+Handle Handle_manager<Handle, T, capacity>::add(T value) {
+    return emplace(std::move(value));
+}
+
+template<typename Handle, typename T, int capacity>
+template<typename... Args>
+Handle Handle_manager<Handle, T, capacity>::emplace(Args&&... args) {
     if (size_ == capacity) {
         throw Resource_error{Handle_error_type::out_of_space};
     }
 
+    // Construct first so that a throwing constructor leaves no trace
+    new (&elems_[size_]) T(std::forward<Args>(args)...);
+    return link_last_element();
+}
+
+template<typename Handle, typename T, int capacity>
+void Handle_manager<Handle, T, capacity>::remove(Handle handle) {
+    validate(handle);
+    erase(handle.index());
+}
+
+/**
+ * @brief Adds copies of count elements.
+ * @param values Elements to add
+ * @param count Number of elements to add
+ * @param handles Output array that receives count handles of the new elements
+ * @throw Resource_error if there is no room for all the elements, in which case
+ * nothing is added.
+ */
+template<typename Handle, typename T, int capacity>
+void Handle_manager<Handle, T, capacity>::add_n(const T* values,
+                                                size_type count,
+                                                Handle* handles) {
+    if (count > capacity - size_) {
+        throw Resource_error{Handle_error_type::out_of_space};
+    }
+
+    for (auto i = 0u; i != count; ++i) {
+        new (&elems_[size_]) T(values[i]);
+        handles[i] = link_last_element();
+    }
+}
+
+/**
+ * @brief Removes count elements.
+ * @param handles Handles of elements to remove; a handle that appears more
+ * than once is removed once
+ * @param count Number of handles
+ * @throw Resource_error if any handle is invalid, in which case nothing is
+ * removed.
+ */
+template<typename Handle, typename T, int capacity>
+void Handle_manager<Handle, T, capacity>::remove_n(const Handle* handles,
+                                                   size_type count) {
+    for (auto i = 0u; i != count; ++i) {
+        validate(handles[i]);
+    }
+
+    for (auto i = 0u; i != count; ++i) {
+        // Skips the repeats of a handle that this batch already removed
+        if (actives_[handles[i].index()]) erase(handles[i].index());
+    }
+}
+
+/**
+ * @brief Gets underlying variables that count handles refer to.
+ * @param handles Handles to resolve
+ * @param count Number of handles
+ * @param values Output array that receives a pointer for every handle; nullptr
+ * if the handle is no longer valid
+ * @return Number of valid handles
+ */
+template<typename Handle, typename T, int capacity>
+typename Handle_manager<Handle, T, capacity>::size_type
+Handle_manager<Handle, T, capacity>::resolve_n(const Handle* handles,
+                                               size_type count,
+                                               const T** values) const {
+    // Branchless, so that a batch of mixed valid and stale handles does not
+    // pay for mispredictions
+    size_type valid_count = 0;
+    for (auto i = 0u; i != count; ++i) {
+        const auto index = handles[i].index();
+        const auto entry = handles_[index];
+        const bool valid = actives_[index]
+                && entry.generation == handles[i].generation();
+        values[i] = valid ? &elem(entry.index) : nullptr;
+        valid_count += valid;
+    }
+    return valid_count;
+}
+
+template<typename Handle, typename T, int capacity>
+typename Handle_manager<Handle, T, capacity>::size_type
+Handle_manager<Handle, T, capacity>::size() const {
+    return size_;
+}
+
+/// Returns the number of bytes that snapshot() writes
+template<typename Handle, typename T, int capacity>
+std::size_t Handle_manager<Handle, T, capacity>::snapshot_size() const {
+    return sizeof(detail::Handle_snapshot_header) + sizeof(actives_)
+            + sizeof(handles_) + size_ * (sizeof(uint32) + sizeof(T));
+}
+
+/**
+ * @brief Captures the whole state of the manager.
+ * @param buffer Receives the snapshot; its capacity is reused, so taking
+ * snapshots repeatedly into the same buffer does not allocate.
+ *
+ * The snapshot stores the free list, the generations and the live elements in
+ * a versioned binary format. Elements are copied as raw bytes.
+ */
+template<typename Handle, typename T, int capacity>
+void Handle_manager<Handle, T, capacity>::snapshot(
+        std::vector<Byte>& buffer) const {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable elements can be snapshotted");
+    static_assert(std::is_trivially_copyable<decltype(actives_)>::value,
+                  "bitset need to be trivially copyable");
+
+    buffer.resize(snapshot_size());
+    const detail::Handle_snapshot_header header {
+        detail::Handle_snapshot_header::magic_number,
+        detail::Handle_snapshot_header::current_version,
+        sizeof(T),
+        capacity,
+        Handle::index_bits,
+        size_,
+        first_free_entry_
+    };
+
+    auto out = buffer.data();
+    auto write = [&out](const void* source, std::size_t bytes) {
+        std::memcpy(out, source, bytes);
+        out += bytes;
+    };
+    write(&header, sizeof(header));
+    write(&actives_, sizeof(actives_));
+    write(handles_.data(), sizeof(handles_));
+    write(entry_indices_.data(), size_ * sizeof(uint32));
+    write(elems_.data(), size_ * sizeof(T));
+}
+
+/**
+ * @brief Restores the state captured by snapshot().
+ * @param data Pointer to the snapshot
+ * @param size Size of the snapshot in bytes
+ * @throw Resource_error if the snapshot was taken from a manager of another
+ * type or in another format version, or if its entries do not form a valid
+ * free list and dense array, in which case the manager is unchanged.
+ */
+template<typename Handle, typename T, int capacity>
+void Handle_manager<Handle, T, capacity>::restore(const Byte* data,
+                                                  std::size_t size) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable elements can be restored");
+
+    detail::Handle_snapshot_header header;
+    if (size < sizeof(header)) {
+        throw Resource_error{Handle_error_type::invalid_snapshot};
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.magic != detail::Handle_snapshot_header::magic_number
+            || header.version != detail::Handle_snapshot_header::current_version
+            || header.element_size != sizeof(T)
+            || header.capacity != static_cast<uint32>(capacity)
+            || header.index_bits != Handle::index_bits
+            || header.size > header.capacity
+            || size != sizeof(header) + sizeof(actives_) + sizeof(handles_)
+                       + header.size * (sizeof(uint32) + sizeof(T))) {
+        throw Resource_error{Handle_error_type::invalid_snapshot};
+    }
+
+    auto in = data + sizeof(header);
+    if (!links_consistent(header, in)) {
+        throw Resource_error{Handle_error_type::invalid_snapshot};
+    }
+
+    auto read = [&in](void* destination, std::size_t bytes) {
+        std::memcpy(destination, in, bytes);
+        in += bytes;
+    };
+    read(&actives_, sizeof(actives_));
+    read(handles_.data(), sizeof(handles_));
+    read(entry_indices_.data(), header.size * sizeof(uint32));
+    read(elems_.data(), header.size * sizeof(T));
+    size_ = header.size;
+    first_free_entry_ = header.first_free_entry;
+}
+
+// Checks that the entries of a snapshot, which follow its header, link every
+// live entry to its own dense element and every free entry into one free list,
+// so that no later operation indexes outside of the arrays
+template<typename Handle, typename T, int capacity>
+bool Handle_manager<Handle, T, capacity>::links_consistent(
+        const detail::Handle_snapshot_header& header, const Byte* arrays) {
+    std::bitset<slots> actives;
+    std::memcpy(&actives, arrays, sizeof(actives));
+    const auto entries = arrays + sizeof(actives);
+    const auto entry_indices = entries + sizeof(handles_);
+
+    auto entry_at = [entries](size_type index) {
+        detail::Handle_entry<Handle> entry;
+        std::memcpy(&entry, entries + index * sizeof(entry), sizeof(entry));
+        return entry;
+    };
+    auto entry_index_at = [entry_indices](size_type dense_index) {
+        uint32 index;
+        std::memcpy(&index, entry_indices + dense_index * sizeof(index),
+                    sizeof(index));
+        return index;
+    };
+
+    if (actives.count() != header.size) {
+        return false;
+    }
+    for (size_type dense_index = 0; dense_index != header.size; ++dense_index) {
+        const auto index = entry_index_at(dense_index);
+        if (index >= slots || !actives[index]
+                || entry_at(index).index != dense_index) {
+            return false;
+        }
+    }
+
+    // The free list has to visit every free entry once; its last link is
+    // never followed
+    std::bitset<slots> visited;
+    auto index = header.first_free_entry;
+    for (auto i = header.size; i != header.capacity; ++i) {
+        if (index >= slots || actives[index] || visited[index]) {
+            return false;
+        }
+        visited[index] = true;
+        index = entry_at(index).index;
+    }
+    return true;
+}
+
+// Takes a free entry for the element just constructed at the end of the dense
+// array, and returns its handle
+template<typename Handle, typename T, int capacity>
+Handle Handle_manager<Handle, T, capacity>::link_last_element() {
     const auto index = first_free_entry_;
     const auto generation = handles_[index].generation;
-    first_free_entry_ = handles_[index].next_free_index;
+    first_free_entry_ = handles_[index].index;
     actives_[index] = true;
-    elems_[index] = elem;
+    handles_[index].index = size_;
+    entry_indices_[size_] = index;
     ++size_;
     return Handle{index, generation};
 }
 
 template<typename Handle, typename T, int capacity>
-void Handle_manager<Handle, T, capacity>::remove(Handle handle) {
+void Handle_manager<Handle, T, capacity>::validate(Handle handle) const {
     const auto index = handle.index();
     if (actives_[index] == false) {
         throw Resource_error{Handle_error_type::null_entry};
     } else if (handles_[index].generation != handle.generation()) {
         throw Resource_error{Handle_error_type::invalid_handle};
     }
+}
+
+// Destroys the element of a live entry and frees the entry
+template<typename Handle, typename T, int capacity>
+void Handle_manager<Handle, T, capacity>::erase(uint32 index) {
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "Elements need a move constructor that does not throw");
+
+    // Fill the hole with the last element to keep the elements packed
+    const auto dense_index = handles_[index].index;
+    const auto last = size_ - 1;
+    if (dense_index != last) {
+        elem(dense_index).~T();
+        new (&elems_[dense_index]) T(std::move(elem(last)));
+        entry_indices_[dense_index] = entry_indices_[last];
+        handles_[entry_indices_[dense_index]].index = dense_index;
+    }
+    elem(last).~T();
 
-    handles_[index].next_free_index = first_free_entry_;
+    handles_[index].index = first_free_entry_;
     first_free_entry_ = index;
 
     actives_[index] = false;
@@ -100,10 +499,4 @@ void Handle_manager<Handle, T, capacity>::remove(Handle handle) {
     --size_;
 }
 
-template<typename Handle, typename T, int capacity>
-typename Handle_manager<Handle, T, capacity>::size_type
-Handle_manager<Handle, T, capacity>::size() const {
-    return size_;
-}
-
 }} // namespace bolder::resource
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bolder/handle.hpp"
+#include "bolder/handle_manager.hpp"
+#include "bolder/resource_error.hpp"
+
+namespace bolder { namespace resource {
+
+/**
+ * @class Paged_handle_manager
+ * @ingroup resource_group
+ * @brief A Handle_manager that grows by fixed-size pages on demand.
+ * @tparam Handle The handle type that refers to the managed data
+ * @tparam T Type of managed data
+ * @tparam page_size Number of entries added at a time, must be a power of two
+ *
+ * Unlike Handle_manager, which embeds all of its slots inline, this manager
+ * only adds a page of entries when every entry is in use. It can grow up to
+ * the limit that Handle::index_bits allows. The entries are one flat array
+ * that a handle index selects directly, so a lookup reads the entry and then
+ * the element, like in Handle_manager.
+ *
+ * Elements live in a densely packed array that grows with size(). It keeps its
+ * memory when elements are removed, until shrink_to_fit() releases what is
+ * above size(), for example after unloading a level. Entries are never
+ * released, since their generations detect the stale handles to them; they
+ * cost a few bytes for every slot used at the peak.
+ *
+ * As in Handle_manager, live elements are contiguous and kept in insertion
+ * order, except that removing an element moves the last element into its
+ * place.
+ *
+ * Like Handle_manager, elements are only constructed when they are added, so T
+ * needs neither a default constructor nor a copy constructor, and only a move
+ * constructor that does not throw.
+ *
+ * @see Handle_manager
+ */
+template<typename Handle, typename T, uint32 page_size>
+class Paged_handle_manager {
+    static constexpr auto max_capacity = 1u << Handle::index_bits;
+    static_assert(page_size != 0 && (page_size & (page_size - 1)) == 0,
+                  "page size must be a power of two");
+    static_assert(page_size <= max_capacity,
+                  "page size bigger then max value of handle index");
+
+public:
+    using value_type = T;
+    using size_type = uint32;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
+    Paged_handle_manager() = default;
+    ~Paged_handle_manager();
+
+    Paged_handle_manager(const Paged_handle_manager&) = delete;
+    Paged_handle_manager& operator=(const Paged_handle_manager&) = delete;
+
+    Handle add(value_type value);
+
+    /// Constructs a new element in place from args
+    template<typename... Args>
+    Handle emplace(Args&&... args);
+
+    void remove(Handle handle);
+
+    /// @name Batched operations
+    /// Each batched operation validates its whole batch once up front.
+    ///@{
+    void add_n(const value_type* values, size_type count, Handle* handles);
+
+    void remove_n(const Handle* handles, size_type count);
+
+    size_type resolve_n(const Handle* handles, size_type count,
+                        const value_type** values) const;
+    ///@}
+
+    /**
+     * @brief Gets underlying variable that a handle refer to.
+     * @param handle
+     * @return A pointer to underlying variable that a handle refer to;
+     * nullptr if the handle is no longer valid.
+     */
+    const value_type* operator[](Handle handle) const {
+        const auto index = handle.index();
+        if (index >= entries_.size() || !actives_[index]
+                || handle.generation() != entries_[index].generation) {
+            return nullptr;
+        }
+
+        return &elems_[entries_[index].index];
+    }
+
+    /// @copydoc operator[](Handle) const
+    value_type* operator[](Handle handle) {
+        const auto& self = *this;
+        return const_cast<value_type*>(self[handle]);
+    }
+
+    size_type size() const;
+
+    /// Returns the number of entries, which only grows
+    size_type capacity() const;
+
+    /// Releases the memory of the element storage that is above size()
+    void shrink_to_fit();
+
+    /// @name Dense iteration
+    /// Live elements are stored contiguously in [begin(), end()).
+    ///@{
+    iterator begin() { return elems_.data(); }
+    iterator end() { return elems_.data() + elems_.size(); }
+    const_iterator begin() const { return elems_.data(); }
+    const_iterator end() const { return elems_.data() + elems_.size(); }
+    ///@}
+
+    /// Calls f on every live element
+    template<typename Function>
+    void for_each(Function f) {
+        std::for_each(begin(), end(), f);
+    }
+
+    /// Calls f on every live element
+    template<typename Function>
+    void for_each(Function f) const {
+        std::for_each(begin(), end(), f);
+    }
+
+private:
+    std::vector<detail::Handle_entry<Handle>> entries_;
+    std::vector<bool> actives_;
+    std::vector<T> elems_;
+    // Entry index of every element in the dense array
+    std::vector<uint32> entry_indices_;
+    size_type size_ = 0;
+    // Equal to capacity() when there is no free entry
+    size_type first_free_entry_ = 0;
+
+    void grow();
+    Handle link_last_element();
+    void validate(Handle handle) const;
+    void erase(uint32 index);
+};
+
+template<typename Handle, typename T, uint32 page_size>
+Paged_handle_manager<Handle, T, page_size>::~Paged_handle_manager() = default;
+
+template<typename Handle, typename T, uint32 page_size>
+Handle Paged_handle_manager<Handle, T, page_size>::add(T value) {
+    return emplace(std::move(value));
+}
+
+template<typename Handle, typename T, uint32 page_size>
+template<typename... Args>
+Handle Paged_handle_manager<Handle, T, page_size>::emplace(Args&&... args) {
+    if (size_ == max_capacity) {
+        throw Resource_error{Handle_error_type::out_of_space};
+    }
+
+    if (first_free_entry_ == capacity()) {
+        grow();
+    }
+
+    elems_.emplace_back(std::forward<Args>(args)...);
+    return link_last_element();
+}
+
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::remove(Handle handle) {
+    validate(handle);
+    erase(handle.index());
+}
+
+/**
+ * @brief Adds copies of count elements.
+ * @param values Elements to add
+ * @param count Number of elements to add
+ * @param handles Output array that receives count handles of the new elements
+ * @throw Resource_error if there is no room for all the elements, in which case
+ * nothing is added.
+ */
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::add_n(const T* values,
+                                                       size_type count,
+                                                       Handle* handles) {
+    if (count > max_capacity - size_) {
+        throw Resource_error{Handle_error_type::out_of_space};
+    }
+
+    // Keep the geometric growth of the vectors
+    const auto new_size = std::max<std::size_t>(size_ + count,
+                                                2 * elems_.capacity());
+    if (elems_.capacity() < size_ + count) {
+        elems_.reserve(new_size);
+        entry_indices_.reserve(new_size);
+    }
+    for (auto i = 0u; i != count; ++i) {
+        if (first_free_entry_ == capacity()) {
+            grow();
+        }
+
+        elems_.push_back(values[i]);
+        handles[i] = link_last_element();
+    }
+}
+
+/**
+ * @brief Removes count elements.
+ * @param handles Handles of elements to remove; a handle that appears more
+ * than once is removed once
+ * @param count Number of handles
+ * @throw Resource_error if any handle is invalid, in which case nothing is
+ * removed.
+ */
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::remove_n(const Handle* handles,
+                                                          size_type count) {
+    for (auto i = 0u; i != count; ++i) {
+        validate(handles[i]);
+    }
+
+    for (auto i = 0u; i != count; ++i) {
+        // Skips the repeats of a handle that this batch already removed
+        if (actives_[handles[i].index()]) erase(handles[i].index());
+    }
+}
+
+/**
+ * @brief Gets underlying variables that count handles refer to.
+ * @param handles Handles to resolve
+ * @param count Number of handles
+ * @param values Output array that receives a pointer for every handle; nullptr
+ * if the handle is no longer valid
+ * @return Number of valid handles
+ */
+template<typename Handle, typename T, uint32 page_size>
+typename Paged_handle_manager<Handle, T, page_size>::size_type
+Paged_handle_manager<Handle, T, page_size>::resolve_n(const Handle* handles,
+                                                      size_type count,
+                                                      const T** values) const {
+    size_type valid_count = 0;
+    for (auto i = 0u; i != count; ++i) {
+        values[i] = (*this)[handles[i]];
+        valid_count += values[i] != nullptr;
+    }
+    return valid_count;
+}
+
+template<typename Handle, typename T, uint32 page_size>
+typename Paged_handle_manager<Handle, T, page_size>::size_type
+Paged_handle_manager<Handle, T, page_size>::size() const {
+    return size_;
+}
+
+template<typename Handle, typename T, uint32 page_size>
+typename Paged_handle_manager<Handle, T, page_size>::size_type
+Paged_handle_manager<Handle, T, page_size>::capacity() const {
+    return static_cast<size_type>(entries_.size());
+}
+
+/**
+ * Handles stay valid, but elements may move, so pointers to them do not. Adding
+ * elements afterwards allocates the element storage again.
+ */
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::shrink_to_fit() {
+    elems_.shrink_to_fit();
+    entry_indices_.shrink_to_fit();
+}
+
+// Appends a page of entries that are chained into the free list. The free list
+// is terminated by capacity(), which is exactly the first index of the new
+// page, so entries freed before the growth stay linked in front of it.
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::grow() {
+    assert(capacity() < max_capacity);
+
+    const auto first = capacity();
+    for (auto next = first + 1; next != first + page_size + 1; ++next) {
+        entries_.push_back(detail::Handle_entry<Handle>{next, 0});
+    }
+    actives_.resize(entries_.size(), false);
+}
+
+// Takes a free entry for the element just appended to the dense array, and
+// returns its handle
+template<typename Handle, typename T, uint32 page_size>
+Handle Paged_handle_manager<Handle, T, page_size>::link_last_element() {
+    const auto index = first_free_entry_;
+    auto& entry = entries_[index];
+
+    entry_indices_.push_back(index);
+
+    const auto generation = entry.generation;
+    first_free_entry_ = entry.index;
+    actives_[index] = true;
+    entry.index = size_;
+    ++size_;
+    return Handle{index, generation};
+}
+
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::validate(Handle handle) const {
+    const auto index = handle.index();
+    if (index >= capacity()) {
+        throw Resource_error{Handle_error_type::invalid_handle};
+    }
+
+    if (actives_[index] == false) {
+        throw Resource_error{Handle_error_type::null_entry};
+    } else if (entries_[index].generation != handle.generation()) {
+        throw Resource_error{Handle_error_type::invalid_handle};
+    }
+}
+
+// Destroys the element of a live entry and frees the entry
+template<typename Handle, typename T, uint32 page_size>
+void Paged_handle_manager<Handle, T, page_size>::erase(uint32 index) {
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "Elements need a move constructor that does not throw");
+
+    auto& erased = entries_[index];
+
+    // Fill the hole with the last element to keep the elements packed
+    const auto dense_index = erased.index;
+    const auto last = size_ - 1;
+    if (dense_index != last) {
+        elems_[dense_index].~T();
+        new (&elems_[dense_index]) T(std::move(elems_[last]));
+        entry_indices_[dense_index] = entry_indices_[last];
+        entries_[entry_indices_[dense_index]].index = dense_index;
+    }
+    elems_.pop_back();
+    entry_indices_.pop_back();
+
+    erased.index = first_free_entry_;
+    first_free_entry_ = index;
+
+    actives_[index] = false;
+    ++erased.generation;
+    --size_;
+}
+
+}} // namespace bolder::resource
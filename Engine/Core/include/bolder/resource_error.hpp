@@ -8,6 +8,7 @@ enum class Handle_error_type {
     out_of_space, ///< Add resource to an manager that are full
     null_entry, ///< Modify an entry that do not contains any value
     invalid_handle, ///< Modify Handle_manager with invalid handle
+    invalid_snapshot, ///< Restore Handle_manager from an incompatible snapshot
 };
 
 struct Resource_error : Runtime_error {
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "bolder/handle.hpp"
+#include "bolder/handle_manager.hpp"
+
+namespace bolder { namespace resource {
+
+template<typename Manager>
+class Weak_handle;
+
+/**
+ * @class Strong_handle
+ * @ingroup resource_group
+ * @brief A reference-counted handle that keeps its element alive.
+ *
+ * Copying a Strong_handle increments the reference count of its element, and
+ * destroying it decrements the count. When the last Strong_handle of an
+ * element goes away, the element is queued for destruction in its
+ * Shared_handle_manager rather than destroyed right away.
+ *
+ * @see Shared_handle_manager
+ */
+template<typename Manager>
+class Strong_handle {
+public:
+    using handle_type = typename Manager::handle_type;
+
+    /// Default constructor creates an empty handle
+    Strong_handle() = default;
+
+    Strong_handle(const Strong_handle& other)
+        : manager_{other.manager_}, handle_{other.handle_} {
+        if (manager_) manager_->acquire(handle_);
+    }
+
+    Strong_handle(Strong_handle&& other) noexcept
+        : manager_{other.manager_}, handle_{other.handle_} {
+        other.manager_ = nullptr;
+    }
+
+    Strong_handle& operator=(Strong_handle other) noexcept {
+        std::swap(manager_, other.manager_);
+        std::swap(handle_, other.handle_);
+        return *this;
+    }
+
+    ~Strong_handle() {
+        reset();
+    }
+
+    /// Drops the reference, leaving this handle empty
+    void reset() {
+        if (manager_) {
+            manager_->release(handle_);
+            manager_ = nullptr;
+        }
+    }
+
+    /// Returns the underlying plain handle
+    handle_type get() const {
+        return handle_;
+    }
+
+    explicit operator bool() const {
+        return manager_ != nullptr;
+    }
+
+private:
+    friend Manager;
+    friend class Weak_handle<Manager>;
+
+    // Adopts a reference that has already been counted
+    Strong_handle(Manager* manager, handle_type handle)
+        : manager_{manager}, handle_{handle} {}
+
+    Manager* manager_ = nullptr;
+    handle_type handle_;
+};
+
+/**
+ * @class Weak_handle
+ * @ingroup resource_group
+ * @brief A handle that observes an element without keeping it alive.
+ *
+ * @see Shared_handle_manager
+ */
+template<typename Manager>
+class Weak_handle {
+public:
+    using handle_type = typename Manager::handle_type;
+
+    Weak_handle() = default;
+
+    Weak_handle(const Strong_handle<Manager>& strong)
+        : manager_{strong.manager_}, handle_{strong.handle_} {}
+
+    /**
+     * @brief Tries to get a Strong_handle to the element.
+     * @return A Strong_handle to the element, or an empty Strong_handle if the
+     * last strong reference is already released.
+     */
+    Strong_handle<Manager> lock() const {
+        if (manager_ && manager_->try_acquire(handle_)) {
+            return Strong_handle<Manager>{manager_, handle_};
+        }
+        return Strong_handle<Manager>{};
+    }
+
+    /// Returns whether the element has been released
+    bool expired() const {
+        return !manager_ || manager_->use_count(handle_) == 0;
+    }
+
+private:
+    Manager* manager_ = nullptr;
+    handle_type handle_;
+};
+
+/**
+ * @class Shared_handle_manager
+ * @ingroup resource_group
+ * @brief A Handle_manager whose elements are shared through Strong_handle.
+ * @tparam Handle The handle type that refers to the managed data
+ * @tparam T Type of managed data
+ * @tparam capacity Maximum number of data the manager can hold
+ *
+ * Reference counts are atomic counters stored inside the manager alongside
+ * every entry, so sharing an element needs no separate control block. When the
+ * count of an element drops to zero it is pushed onto a destruction queue;
+ * the element stays valid until collect() is called at a safe point, such as
+ * the end of a frame, after which no queued draw call can still use it.
+ *
+ * Strong_handle copies and releases are thread-safe. Creating elements,
+ * Weak_handle::lock() and collect() must not run concurrently with each other.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Shared_handle_manager<Texture_handle, Texture> textures;
+ * auto atlas = textures.emplace(image);
+ * auto sprite_texture = atlas; // shares the atlas
+ * atlas.reset();
+ * sprite_texture.reset(); // the atlas is queued for destruction
+ * textures.collect(); // the atlas is destroyed
+ * @endcode
+ */
+template<typename Handle, typename T, int capacity = 4096>
+class Shared_handle_manager {
+public:
+    using handle_type = Handle;
+    using value_type = T;
+    using size_type = uint32;
+    using strong_handle = Strong_handle<Shared_handle_manager>;
+    using weak_handle = Weak_handle<Shared_handle_manager>;
+
+    Shared_handle_manager();
+
+    /// Every Strong_handle must be released before the manager is destroyed
+    ~Shared_handle_manager();
+
+    Shared_handle_manager(const Shared_handle_manager&) = delete;
+    Shared_handle_manager& operator=(const Shared_handle_manager&) = delete;
+
+    strong_handle add(value_type value);
+
+    /// Constructs a new element in place from args
+    template<typename... Args>
+    strong_handle emplace(Args&&... args);
+
+    /**
+     * @brief Gets underlying variable that a handle refer to.
+     * @return A pointer to underlying variable that a handle refer to;
+     * nullptr if the handle is empty.
+     */
+    const value_type* operator[](const strong_handle& handle) const {
+        return handle ? elems_[handle.get()] : nullptr;
+    }
+
+    /// @copydoc operator[](const strong_handle&) const
+    value_type* operator[](const strong_handle& handle) {
+        return handle ? elems_[handle.get()] : nullptr;
+    }
+
+    /// Returns the number of elements, including the ones queued for
+    /// destruction
+    size_type size() const {
+        return elems_.size();
+    }
+
+    /// Returns the number of strong references to an element
+    uint32 use_count(Handle handle) const;
+
+    /**
+     * @brief Destroys every element whose last Strong_handle was released.
+     * @return Number of destroyed elements
+     */
+    size_type collect();
+
+private:
+    friend strong_handle;
+    friend weak_handle;
+
+    Handle_manager<Handle, T, capacity> elems_;
+    std::array<std::atomic<uint32>, static_cast<std::size_t>(capacity)>
+        ref_counts_;
+
+    std::mutex pending_mutex_; // Protects pending_
+    std::vector<Handle> pending_;
+    // Reused by collect() to avoid allocating every frame
+    std::vector<Handle> collecting_;
+
+    void acquire(Handle handle);
+    bool try_acquire(Handle handle);
+    void release(Handle handle);
+};
+
+template<typename Handle, typename T, int capacity>
+Shared_handle_manager<Handle, T, capacity>::Shared_handle_manager() {
+    for (auto& count : ref_counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+template<typename Handle, typename T, int capacity>
+Shared_handle_manager<Handle, T, capacity>::~Shared_handle_manager() {
+    collect();
+    assert(elems_.size() == 0 && "Strong_handle outlives its manager");
+}
+
+template<typename Handle, typename T, int capacity>
+typename Shared_handle_manager<Handle, T, capacity>::strong_handle
+Shared_handle_manager<Handle, T, capacity>::add(T value) {
+    return emplace(std::move(value));
+}
+
+template<typename Handle, typename T, int capacity>
+template<typename... Args>
+typename Shared_handle_manager<Handle, T, capacity>::strong_handle
+Shared_handle_manager<Handle, T, capacity>::emplace(Args&&... args) {
+    const auto handle = elems_.emplace(std::forward<Args>(args)...);
+    ref_counts_[handle.index()].store(1, std::memory_order_relaxed);
+    return strong_handle{this, handle};
+}
+
+template<typename Handle, typename T, int capacity>
+uint32 Shared_handle_manager<Handle, T, capacity>::use_count(
+        Handle handle) const {
+    if (elems_[handle] == nullptr) {
+        return 0;
+    }
+    return ref_counts_[handle.index()].load(std::memory_order_relaxed);
+}
+
+template<typename Handle, typename T, int capacity>
+typename Shared_handle_manager<Handle, T, capacity>::size_type
+Shared_handle_manager<Handle, T, capacity>::collect() {
+    {
+        std::lock_guard<std::mutex> lock{pending_mutex_};
+        collecting_.swap(pending_);
+    }
+
+    const auto count = static_cast<size_type>(collecting_.size());
+    elems_.remove_n(collecting_.data(), count);
+    collecting_.clear();
+    return count;
+}
+
+template<typename Handle, typename T, int capacity>
+void Shared_handle_manager<Handle, T, capacity>::acquire(Handle handle) {
+    ref_counts_[handle.index()].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Increments the reference count unless it has already dropped to zero
+template<typename Handle, typename T, int capacity>
+bool Shared_handle_manager<Handle, T, capacity>::try_acquire(Handle handle) {
+    if (elems_[handle] == nullptr) {
+        return false;
+    }
+
+    auto& count = ref_counts_[handle.index()];
+    auto expected = count.load(std::memory_order_relaxed);
+    while (expected != 0) {
+        if (count.compare_exchange_weak(expected, expected + 1,
+                                        std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Handle, typename T, int capacity>
+void Shared_handle_manager<Handle, T, capacity>::release(Handle handle) {
+    const auto previous = ref_counts_[handle.index()].fetch_sub(
+                1, std::memory_order_acq_rel);
+    assert(previous != 0 && "Release an element without reference");
+    static_cast<void>(previous);
+    if (previous == 1) {
+        std::lock_guard<std::mutex> lock{pending_mutex_};
+        pending_.push_back(handle);
+    }
+}
+
+}} // namespace bolder::resource
@@ -0,0 +1,348 @@
+#include "ecs/archetype.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "bolder/exception.hpp"
+
+namespace bolder { namespace ecs {
+
+namespace {
+// Every column starts at this alignment so that systems can use aligned SIMD
+// loads on any column
+constexpr std::size_t column_alignment = alignof(std::max_align_t);
+
+std::size_t align_up(std::size_t offset, std::size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Moves an element and destroys the source
+void relocate(const Component_info& info, void* destination, void* source) {
+    if (info.trivial) {
+        std::memcpy(destination, source, info.size);
+    } else {
+        info.move_construct(destination, source);
+        info.destroy(source);
+    }
+}
+
+// Moves count consecutive elements and destroys the sources
+void relocate_n(const Component_info& info, Byte* destination, Byte* source,
+                uint32 count) {
+    if (info.trivial) {
+        std::memcpy(destination, source, count * info.size);
+        return;
+    }
+    for (auto i = 0u; i != count; ++i) {
+        relocate(info, destination + i * info.size, source + i * info.size);
+    }
+}
+} // anonymous namespace
+
+constexpr std::size_t Chunk::bytes;
+constexpr uint32 Archetype::npos;
+
+Archetype::Archetype(const Signature& signature)
+    : signature_{signature}, column_indices_(max_components, npos)
+{
+    std::size_t row_bytes = sizeof(Entity);
+    for (auto id = 0u; id != max_components; ++id) {
+        if (signature[id]) {
+            const auto& info = component_info(id);
+            const auto stride = info.tag || info.shared ? 0 : info.size;
+            column_indices_[id] = static_cast<uint32>(columns_.size());
+            columns_.push_back(Column{id, 0, stride, info});
+            row_bytes += stride;
+        }
+    }
+
+    // Shrink the estimate until the columns and their padding fit. The shared
+    // components of a chunk follow its columns, and all the tags share one
+    // scratch slot after them, so that writing a tag through a pointer is
+    // harmless.
+    auto capacity = Chunk::bytes / row_bytes;
+    for (;; --capacity) {
+        if (capacity == 0) {
+            throw Runtime_error {"Components of an entity exceed chunk size"};
+        }
+
+        auto offset = align_up(sizeof(Entity) * capacity, column_alignment);
+        for (auto& column : columns_) {
+            if (column.stride == 0) continue;
+            column.offset = offset;
+            offset = align_up(offset + column.stride * capacity,
+                              column_alignment);
+        }
+
+        shared_offset_ = offset;
+        for (auto& column : columns_) {
+            if (!column.info.shared) continue;
+            column.offset = offset;
+            offset = align_up(offset + column.info.size, column_alignment);
+        }
+        shared_size_ = offset - shared_offset_;
+
+        bool has_tag = false;
+        for (auto& column : columns_) {
+            if (!column.info.tag) continue;
+            column.offset = offset;
+            has_tag = true;
+        }
+        if (has_tag) offset += column_alignment;
+
+        if (offset <= Chunk::bytes) break;
+    }
+    chunk_capacity_ = static_cast<uint32>(capacity);
+}
+
+Archetype::~Archetype()
+{
+    for (auto& chunk : chunks_) {
+        for (auto column = 0u; column != column_count(); ++column) {
+            const auto& info = columns_[column].info;
+            if (info.trivial) continue;
+
+            for (auto row = 0u; row != chunk->size_; ++row) {
+                info.destroy(element(*chunk, column, row));
+            }
+        }
+    }
+}
+
+void* Archetype::component(const Entity_location& location,
+                           Component_id component) const
+{
+    const auto column = column_index(component);
+    if (column == npos) {
+        return nullptr;
+    }
+    return element(*chunks_[location.chunk], column, location.row);
+}
+
+Entity_location Archetype::allocate(Entity entity, uint32 tick,
+                                    const Byte* shared)
+{
+    uint32 count = 1;
+    return allocate_n(&entity, count, tick, shared);
+}
+
+Entity_location Archetype::allocate_n(const Entity* new_entities,
+                                      uint32& count, uint32 tick,
+                                      const Byte* shared)
+{
+    while (first_open_chunk_ != chunks_.size()
+           && chunks_[first_open_chunk_]->size_ == chunk_capacity_) {
+        ++first_open_chunk_;
+    }
+
+    const auto index = shared_size_ == 0 ? first_open_chunk_
+                                         : open_chunk(shared);
+    if (index == chunks_.size()) {
+        chunks_.push_back(std::make_unique<Chunk>());
+        chunks_.back()->ticks_.resize(columns_.size());
+    }
+
+    auto& chunk = *chunks_[index];
+    if (chunk.size_ == 0 && shared_size_ != 0) {
+        std::memcpy(chunk.data() + shared_offset_, shared, shared_size_);
+    }
+    const auto row = chunk.size_;
+    count = std::min(count, chunk_capacity_ - row);
+    std::copy(new_entities, new_entities + count, entities(chunk) + row);
+    std::fill(chunk.ticks_.begin(), chunk.ticks_.end(),
+              Column_ticks{tick, tick});
+    chunk.size_ += count;
+    size_ += count;
+    return Entity_location{this, index, row};
+}
+
+void Archetype::clone_rows(const Entity_location& location, uint32 count,
+                           const void* const* prototypes)
+{
+    auto& chunk = *chunks_[location.chunk];
+    uint32 column = 0;
+    uint32 row = 0;
+    try {
+        for (; column != column_count(); ++column) {
+            const auto& info = columns_[column].info;
+            if (columns_[column].stride == 0) continue;
+
+            auto* first = element(chunk, column, location.row);
+            if (!info.trivial) {
+                for (row = 0; row != count; ++row) {
+                    info.copy_construct(first + row * info.size,
+                                        prototypes[column]);
+                }
+                continue;
+            }
+
+            // Doubles the copied range, so that large counts take few memcpys
+            std::memcpy(first, prototypes[column], info.size);
+            for (auto copied = 1u; copied < count;) {
+                const auto batch = std::min(copied, count - copied);
+                std::memcpy(first + copied * info.size, first,
+                            batch * info.size);
+                copied += batch;
+            }
+        }
+    } catch (...) {
+        for (auto i = 0u; i <= column; ++i) {
+            const auto& info = columns_[i].info;
+            if (info.trivial) continue;
+            const auto rows = i == column ? row : count;
+            for (auto j = 0u; j != rows; ++j) {
+                info.destroy(element(chunk, i, location.row + j));
+            }
+        }
+        throw;
+    }
+}
+
+void Archetype::destroy_row(const Entity_location& location)
+{
+    auto& chunk = *chunks_[location.chunk];
+    for (auto column = 0u; column != column_count(); ++column) {
+        const auto& info = columns_[column].info;
+        if (!info.trivial) {
+            info.destroy(element(chunk, column, location.row));
+        }
+    }
+}
+
+void Archetype::move_row(const Entity_location& location, Archetype& target,
+                         const Entity_location& destination)
+{
+    auto& chunk = *chunks_[location.chunk];
+    auto& target_chunk = *target.chunks_[destination.chunk];
+    for (auto column = 0u; column != column_count(); ++column) {
+        const auto& info = columns_[column].info;
+        auto* source = element(chunk, column, location.row);
+        const auto target_column = target.column_index(
+                    columns_[column].component);
+        // The shared components of the target row are the ones of its chunk
+        if (columns_[column].stride == 0) continue;
+        if (target_column != npos) {
+            relocate(info, target.element(target_chunk, target_column,
+                                          destination.row), source);
+        } else if (!info.trivial) {
+            info.destroy(source);
+        }
+    }
+}
+
+Entity Archetype::remove_row(const Entity_location& location)
+{
+    auto& chunk = *chunks_[location.chunk];
+    auto* chunk_entities = entities(chunk);
+    const auto last = chunk.size_ - 1;
+    if (location.row != last) {
+        for (auto column = 0u; column != column_count(); ++column) {
+            if (columns_[column].stride == 0) continue;
+            relocate(columns_[column].info, element(chunk, column, location.row),
+                     element(chunk, column, last));
+        }
+        chunk_entities[location.row] = chunk_entities[last];
+    }
+
+    --chunk.size_;
+    --size_;
+    first_open_chunk_ = std::min(first_open_chunk_, location.chunk);
+    return chunk_entities[location.row];
+}
+
+Entity_location Archetype::compact(uint32& count)
+{
+    while (!chunks_.empty() && chunks_.back()->size_ == 0) {
+        chunks_.pop_back();
+    }
+    first_open_chunk_ = std::min(first_open_chunk_,
+                                 static_cast<uint32>(chunks_.size()));
+    while (first_open_chunk_ != chunks_.size()
+           && chunks_[first_open_chunk_]->size_ == chunk_capacity_) {
+        ++first_open_chunk_;
+    }
+
+    // Without shared components, the last chunk always moves into the first
+    // open one. Otherwise rows only move into a chunk of the same shared
+    // components, and only the last chunk moves into an empty one, since it is
+    // freed once empty.
+    const auto last = static_cast<uint32>(chunks_.size()) - 1;
+    for (auto source = last; source != npos && source > first_open_chunk_;
+         --source) {
+        if (chunks_[source]->size_ == 0) continue;
+
+        const auto* shared = chunks_[source]->data() + shared_offset_;
+        for (auto target = first_open_chunk_; target != source; ++target) {
+            const auto& chunk = *chunks_[target];
+            if (chunk.size_ == chunk_capacity_) continue;
+            if (chunk.size_ == 0 ? source == last : same_shared(chunk, shared)) {
+                return move_rows(source, target, count);
+            }
+        }
+    }
+
+    count = 0;
+    return Entity_location{};
+}
+
+// Moves up to count rows from the end of a chunk to the end of an earlier one
+Entity_location Archetype::move_rows(uint32 source_index, uint32 target_index,
+                                     uint32& count)
+{
+    auto& source = *chunks_[source_index];
+    auto& target = *chunks_[target_index];
+    count = std::min({count, source.size_, chunk_capacity_ - target.size_});
+    if (target.size_ == 0) {
+        std::memcpy(target.data() + shared_offset_,
+                    source.data() + shared_offset_, shared_size_);
+    }
+
+    // Moves the rows from the end of the source, so that it stays packed
+    const auto source_row = source.size_ - count;
+    const auto target_row = target.size_;
+    std::copy(entities(source) + source_row, entities(source) + source.size_,
+              entities(target) + target_row);
+    for (auto column = 0u; column != column_count(); ++column) {
+        if (columns_[column].stride != 0) {
+            relocate_n(columns_[column].info,
+                       element(target, column, target_row),
+                       element(source, column, source_row), count);
+        }
+
+        auto& ticks = target.ticks_[column];
+        ticks.added = std::max(ticks.added, source.ticks_[column].added);
+        ticks.changed = std::max(ticks.changed, source.ticks_[column].changed);
+    }
+
+    source.size_ -= count;
+    target.size_ += count;
+    if (source.size_ == 0 && source_index + 1 == chunks_.size()) {
+        chunks_.pop_back();
+    }
+    return Entity_location{this, target_index, target_row};
+}
+
+// Finds the chunk that rows with the shared components go to: the first open
+// chunk that has them, otherwise the first empty chunk, otherwise a new chunk
+uint32 Archetype::open_chunk(const Byte* shared) const
+{
+    auto empty = static_cast<uint32>(chunks_.size());
+    for (auto i = first_open_chunk_; i != chunks_.size(); ++i) {
+        const auto& chunk = *chunks_[i];
+        if (chunk.size_ == 0) {
+            empty = std::min(empty, i);
+        } else if (chunk.size_ != chunk_capacity_ && same_shared(chunk, shared)) {
+            return i;
+        }
+    }
+    return empty;
+}
+
+bool Archetype::same_shared(const Chunk& chunk, const Byte* shared) const
+{
+    return std::memcmp(chunk.data() + shared_offset_, shared,
+                       shared_size_) == 0;
+}
+
+}} // namespace bolder::ecs
@@ -0,0 +1,410 @@
+#include "ecs/command_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ecs/world.hpp"
+
+namespace bolder { namespace ecs {
+
+namespace {
+// Moves a component out of the command stream and destroys the source
+void relocate(const Component_info& info, void* destination, void* source) {
+    if (info.trivial) {
+        std::memcpy(destination, source, info.size);
+    } else {
+        info.move_construct(destination, source);
+        info.destroy(source);
+    }
+}
+
+// Moves count consecutive components, with a single memcpy if they are
+// trivially copyable
+void relocate_n(const Component_info& info, Byte* destination, Byte* source,
+                std::size_t count) {
+    if (info.trivial) {
+        std::memcpy(destination, source, count * info.size);
+        return;
+    }
+    for (std::size_t i = 0; i != count; ++i) {
+        info.move_construct(destination + i * info.size,
+                            source + i * info.size);
+        info.destroy(source + i * info.size);
+    }
+}
+
+constexpr uint32 min_staged_rows = 64;
+} // anonymous namespace
+
+constexpr std::size_t Command_buffer::alignment;
+constexpr std::size_t Command_buffer::block_size;
+
+Command_buffer::Command_buffer() = default;
+
+Command_buffer::~Command_buffer()
+{
+    clear();
+}
+
+void Command_buffer::destroy_entity(Entity entity)
+{
+    record(Command_type::destroy_entity, entity, 0, 0);
+}
+
+bool Command_buffer::empty() const
+{
+    if (command_count_ != 0) return false;
+    if (participants_ != nullptr) {
+        for (std::size_t i = 0; i != participants_->size(); ++i) {
+            if (!(*participants_)[i].empty()) return false;
+        }
+    }
+    return true;
+}
+
+Per_participant<Command_buffer>& Command_buffer::participants(
+        const Thread_pool& pool)
+{
+    if (participants_ != nullptr && participants_->size() == pool.size() + 1) {
+        return *participants_;
+    }
+
+    if (participants_ != nullptr) {
+        for (std::size_t i = 0; i != participants_->size(); ++i) {
+            if (!(*participants_)[i].empty()) {
+                throw Runtime_error {
+                    "Replace participants that have pending commands"};
+            }
+        }
+    }
+    participants_ = std::make_unique<Per_participant<Command_buffer>>(pool);
+    return *participants_;
+}
+
+void Command_buffer::playback(World& world)
+{
+    try {
+        created_.assign(created_count_, Entity{});
+        create_entities(world);
+
+        for_each_command([this, &world](Command& command) {
+            if (command.type == Command_type::played) return;
+
+            const auto entity = resolve(command.entity);
+            if (command.type == Command_type::destroy_entity) {
+                world.destroy_entity(entity);
+                command.type = Command_type::played;
+                return;
+            }
+
+            auto* in = reinterpret_cast<Byte*>(&command)
+                    + aligned(sizeof(Command));
+            const auto id = reinterpret_cast<Component_header*>(in)->component;
+            auto* source = in + aligned(sizeof(Component_header));
+            switch (command.type) {
+            case Command_type::add_component:
+                relocate(component_info(id),
+                         world.insert_component(entity, id, source), source);
+                break;
+            case Command_type::set_component: {
+                if (component_info(id).shared) {
+                    world.set_shared(entity, id, source);
+                    break;
+                }
+                auto* target = world.write_component(entity, id);
+                if (target == nullptr) {
+                    throw Runtime_error {
+                        "Set a component that the entity does not have"};
+                }
+                const auto& info = component_info(id);
+                info.destroy(target);
+                relocate(info, target, source);
+                break;
+            }
+            case Command_type::remove_component:
+                world.erase_component(entity, id);
+                break;
+            case Command_type::destroy_entity:
+            case Command_type::played:
+                break;
+            }
+            command.type = Command_type::played;
+        });
+
+        if (participants_ != nullptr) {
+            for (std::size_t i = 0; i != participants_->size(); ++i) {
+                (*participants_)[i].playback(world);
+            }
+        }
+    } catch (...) {
+        clear();
+        throw;
+    }
+    clear();
+}
+
+void Command_buffer::clear()
+{
+    for_each_command([this](Command& command) { destroy_payload(command); });
+    for (auto& block : blocks_) {
+        block.size = 0;
+    }
+    for (auto& batch : batches_) {
+        destroy_staged(batch, batch.played,
+                       static_cast<uint32>(batch.rows.size()));
+        batch.rows.clear();
+        batch.played = 0;
+    }
+    if (participants_ != nullptr) {
+        for (std::size_t i = 0; i != participants_->size(); ++i) {
+            (*participants_)[i].clear();
+        }
+    }
+    current_block_ = 0;
+    command_count_ = 0;
+    created_count_ = 0;
+}
+
+// Returns the staged component of a row, or nullptr if the component is a tag
+Byte* Command_buffer::staged_component(Creation_batch& batch, uint32 row,
+                                       Component_id component)
+{
+    for (auto& column : batch.columns) {
+        if (column.component == component) {
+            return column.data.get() + row * component_info(component).size;
+        }
+    }
+    return nullptr;
+}
+
+Command_buffer::Creation_batch& Command_buffer::creation_batch(
+        const Signature& signature)
+{
+    if (last_batch_ != batches_.size()
+            && batches_[last_batch_].signature == signature) {
+        return batches_[last_batch_];
+    }
+
+    for (last_batch_ = 0; last_batch_ != batches_.size(); ++last_batch_) {
+        if (batches_[last_batch_].signature == signature) {
+            return batches_[last_batch_];
+        }
+    }
+
+    Creation_batch batch {signature, {}, {}, 0, 0};
+    for (Component_id id = 0; id != signature.size(); ++id) {
+        if (signature.test(id) && !component_info(id).tag) {
+            batch.columns.push_back(Staged_column{id, nullptr});
+        }
+    }
+    batches_.push_back(std::move(batch));
+    return batches_.back();
+}
+
+// Returns a row of the batch with room for its components, growing the
+// columns geometrically
+uint32 Command_buffer::reserve_row(Creation_batch& batch)
+{
+    const auto row = static_cast<uint32>(batch.rows.size());
+    if (row != batch.capacity) return row;
+
+    const auto capacity = std::max(min_staged_rows, 2 * batch.capacity);
+    std::vector<std::unique_ptr<Byte[]>> grown;
+    grown.reserve(batch.columns.size());
+    for (const auto& column : batch.columns) {
+        const auto size = component_info(column.component).size;
+        grown.emplace_back(new Byte[capacity * size]);
+    }
+
+    // Moving components cannot throw, so nothing is lost past this point
+    for (std::size_t i = 0; i != batch.columns.size(); ++i) {
+        auto& column = batch.columns[i];
+        if (column.data != nullptr) {
+            relocate_n(component_info(column.component), grown[i].get(),
+                       column.data.get(), row);
+        }
+        column.data = std::move(grown[i]);
+    }
+    batch.capacity = capacity;
+    return row;
+}
+
+// Destroys the staged components of the rows in [first, last)
+void Command_buffer::destroy_staged(Creation_batch& batch, uint32 first,
+                                    uint32 last)
+{
+    for (auto& column : batch.columns) {
+        const auto& info = component_info(column.component);
+        if (info.trivial) continue;
+        for (auto row = first; row != last; ++row) {
+            info.destroy(column.data.get() + row * info.size);
+        }
+    }
+}
+
+// Returns storage for a command, keeping the commands in recording order
+Byte* Command_buffer::allocate(std::size_t size)
+{
+    for (; current_block_ != blocks_.size(); ++current_block_) {
+        auto& block = blocks_[current_block_];
+        if (block.capacity - block.size >= size) {
+            auto* result = block.data.get() + block.size;
+            block.size += size;
+            return result;
+        }
+    }
+
+    // Allocations of Byte arrays are aligned for any object that fits in them
+    const auto capacity = std::max(block_size, size);
+    blocks_.push_back(Block{std::unique_ptr<Byte[]>{new Byte[capacity]},
+                            capacity, size});
+    current_block_ = blocks_.size() - 1;
+    return blocks_.back().data.get();
+}
+
+Command_buffer::Command* Command_buffer::record(Command_type type,
+                                                Entity entity,
+                                                uint32 component_count,
+                                                std::size_t payload_size)
+{
+    const auto size = aligned(sizeof(Command)) + payload_size;
+    auto* command = new (allocate(size))
+            Command{type, component_count, entity, size};
+    ++command_count_;
+    return command;
+}
+
+template<typename Function>
+void Command_buffer::for_each_command(Function f)
+{
+    for (auto& block : blocks_) {
+        for (std::size_t offset = 0; offset != block.size;) {
+            auto& command = *reinterpret_cast<Command*>(
+                        block.data.get() + offset);
+            offset += command.size;
+            f(command);
+        }
+    }
+}
+
+// Maps the entities that this buffer creates to the entities of the World
+Entity Command_buffer::resolve(Entity entity) const
+{
+    if (entity.generation() != Entity::reserved_generation) {
+        return entity;
+    }
+    if (entity.index() >= created_.size()) {
+        throw Runtime_error {"Use an entity of another command buffer"};
+    }
+    return created_[entity.index()];
+}
+
+// Creates the entities of every archetype at once, in the order that the
+// buffer first recorded the archetypes
+void Command_buffer::create_entities(World& world)
+{
+    std::vector<Entity> entities;
+    for (auto& batch : batches_) {
+        if (batch.rows.empty()) continue;
+
+        auto& archetype = world.archetype(batch.signature);
+        entities.resize(batch.rows.size());
+        if (archetype.shared_size() == 0) {
+            create_rows(world, archetype, batch, entities);
+        } else {
+            create_shared_rows(world, archetype, batch, entities);
+        }
+
+        for (std::size_t i = 0; i != batch.rows.size(); ++i) {
+            created_[batch.rows[i]] = entities[i];
+        }
+    }
+}
+
+// Reserves the rows of all the entities of a batch, and moves every staged
+// column into each chunk that the rows span in one go
+void Command_buffer::create_rows(World& world, Archetype& archetype,
+                                 Creation_batch& batch,
+                                 std::vector<Entity>& entities)
+{
+    const auto count = static_cast<uint32>(batch.rows.size());
+    world.new_entities(archetype, count, entities.data(), nullptr);
+
+    for (auto first = 0u; first != count;) {
+        const auto& start = world.records_[entities[first].index()].location;
+        auto last = first + 1;
+        while (last != count) {
+            const auto& location =
+                    world.records_[entities[last].index()].location;
+            if (location.chunk != start.chunk
+                    || location.row != start.row + (last - first)) {
+                break;
+            }
+            ++last;
+        }
+
+        for (auto& column : batch.columns) {
+            const auto& info = component_info(column.component);
+            relocate_n(info, static_cast<Byte*>(
+                           archetype.component(start, column.component)),
+                       column.data.get() + first * info.size, last - first);
+        }
+        first = last;
+    }
+    batch.played = count;
+}
+
+// Creates the entities of a batch one at a time, since every entity goes to
+// the chunk of its own shared components
+void Command_buffer::create_shared_rows(World& world, Archetype& archetype,
+                                        Creation_batch& batch,
+                                        std::vector<Entity>& entities)
+{
+    std::vector<Byte> shared;
+    for (; batch.played != batch.rows.size(); ++batch.played) {
+        const auto row = batch.played;
+        shared.assign(archetype.shared_size(), 0);
+        for (auto& column : batch.columns) {
+            const auto& info = component_info(column.component);
+            if (info.shared) {
+                std::memcpy(shared.data() + archetype.shared_offset(
+                                archetype.column_index(column.component)),
+                            column.data.get() + row * info.size, info.size);
+            }
+        }
+
+        entities[row] = world.new_entity(archetype, shared.data());
+        const auto& location = world.records_[entities[row].index()].location;
+        for (auto& column : batch.columns) {
+            const auto& info = component_info(column.component);
+            relocate(info, archetype.component(location, column.component),
+                     column.data.get() + row * info.size);
+        }
+    }
+}
+
+// Destroys the components that a command still owns
+void Command_buffer::destroy_payload(Command& command)
+{
+    switch (command.type) {
+    case Command_type::add_component:
+    case Command_type::set_component:
+        break;
+    case Command_type::destroy_entity:
+    case Command_type::remove_component:
+    case Command_type::played:
+        return;
+    }
+
+    auto* in = reinterpret_cast<Byte*>(&command) + aligned(sizeof(Command));
+    for (auto i = 0u; i != command.component_count; ++i) {
+        const auto id = reinterpret_cast<Component_header*>(in)->component;
+        const auto& info = component_info(id);
+        in += aligned(sizeof(Component_header));
+        if (!info.trivial) info.destroy(in);
+        in += aligned(info.size);
+    }
+    command.type = Command_type::played;
+}
+
+}} // namespace bolder::ecs
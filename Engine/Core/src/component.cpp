@@ -0,0 +1,69 @@
+#include "ecs/component.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+#include "bolder/exception.hpp"
+
+/**
+  * @defgroup ecs_group ECS
+  * @ingroup core
+  * @brief Archetype based entity component system.
+  */
+
+namespace bolder { namespace ecs {
+
+namespace {
+// Entries are never moved once written, so component_info() can read a
+// registered entry without locking while other types are being registered.
+struct Component_registry {
+    std::mutex mutex;
+    std::array<Component_info, max_components> infos;
+    std::atomic<uint32> size {0};
+};
+
+Component_registry& registry() {
+    static Component_registry instance;
+    return instance;
+}
+} // anonymous namespace
+
+namespace detail {
+Component_id register_component(const Component_info& info)
+{
+    auto& components = registry();
+    std::lock_guard<std::mutex> lock {components.mutex};
+
+    const auto id = components.size.load(std::memory_order_relaxed);
+    if (id == max_components) {
+        throw Runtime_error {"Too many ECS component types"};
+    }
+    components.infos[id] = info;
+    components.size.store(id + 1, std::memory_order_release);
+    return id;
+}
+} // namespace detail
+
+const Component_info& component_info(Component_id id)
+{
+    auto& components = registry();
+    assert(id < components.size.load(std::memory_order_acquire));
+    return components.infos[id];
+}
+
+Component_id find_component(const char* name)
+{
+    auto& components = registry();
+    const auto size = components.size.load(std::memory_order_acquire);
+    for (auto id = 0u; id != size; ++id) {
+        if (std::strcmp(components.infos[id].name, name) == 0) {
+            return id;
+        }
+    }
+    return invalid_component;
+}
+
+}} // namespace bolder::ecs
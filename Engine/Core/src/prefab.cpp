@@ -0,0 +1,38 @@
+#include "ecs/prefab.hpp"
+
+namespace bolder { namespace ecs {
+
+Prefab::~Prefab()
+{
+    destroy_components();
+}
+
+Prefab& Prefab::operator=(Prefab&& other) noexcept
+{
+    destroy_components();
+    signature_ = other.signature_;
+    components_ = std::move(other.components_);
+    data_ = std::move(other.data_);
+    other.components_.clear();
+    return *this;
+}
+
+void* Prefab::find(Component_id component) const
+{
+    for (const auto& record : components_) {
+        if (record.component == component) {
+            return data_.get() + record.offset;
+        }
+    }
+    return nullptr;
+}
+
+void Prefab::destroy_components()
+{
+    for (const auto& record : components_) {
+        component_info(record.component).destroy(data_.get() + record.offset);
+    }
+    components_.clear();
+}
+
+}} // namespace bolder::ecs
@@ -18,6 +18,8 @@ const char* Resource_error::what() const noexcept {
         return "modify or remove entry that does not contain value";
     case Handle_error_type::invalid_handle:
         return "modify or remove entry with an invalid handle";
+    case Handle_error_type::invalid_snapshot:
+        return "restore resource manager from an incompatible snapshot";
     }
 }
 
@@ -0,0 +1,129 @@
+#include "ecs/scheduler.hpp"
+
+#include "bolder/thread_pool.hpp"
+#include "ecs/world.hpp"
+
+namespace bolder { namespace ecs {
+
+System::System(const Access& access) : access_{access}
+{
+
+}
+
+System::~System() {}
+
+Scheduler::Scheduler(Thread_pool& pool) : pool_{pool}
+{
+
+}
+
+Scheduler::~Scheduler() = default;
+
+Scheduler::Node::Node(std::unique_ptr<System> node_system,
+                      uint32 dependencies)
+    : system{std::move(node_system)},
+      commands{std::make_unique<Command_buffer>()},
+      dependency_count{dependencies}
+{
+
+}
+
+Scheduler::Node::~Node() = default;
+
+System& Scheduler::add_system(std::unique_ptr<System> system)
+{
+    const auto index = nodes_.size();
+    uint32 dependency_count = 0;
+    for (auto i = 0u; i != index; ++i) {
+        if (nodes_[i].system->access().conflicts_with(system->access())) {
+            nodes_[i].dependents.push_back(index);
+            ++dependency_count;
+        }
+    }
+
+    nodes_.emplace_back(std::move(system), dependency_count);
+    pending_ = std::vector<std::atomic<uint32>>(nodes_.size());
+    return *nodes_.back().system;
+}
+
+void Scheduler::run(World& world, double dt)
+{
+    if (nodes_.empty()) return;
+
+    for (auto i = 0u; i != nodes_.size(); ++i) {
+        pending_[i].store(nodes_[i].dependency_count,
+                          std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        remaining_ = nodes_.size();
+        error_ = nullptr;
+    }
+
+    for (auto i = 0u; i != nodes_.size(); ++i) {
+        if (nodes_[i].dependency_count == 0) {
+            dispatch(i, world, dt);
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock {mutex_};
+        finished_.wait(lock, [this] { return remaining_ == 0; });
+    }
+
+    try {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        // Playback and later changes happen after the last run of every
+        // system, so the next run of each system sees them
+        world.increment_change_tick();
+        for (auto& node : nodes_) {
+            node.commands->playback(world);
+        }
+    } catch (...) {
+        for (auto& node : nodes_) {
+            node.commands->clear();
+        }
+        throw;
+    }
+}
+
+void Scheduler::dispatch(std::size_t index, World& world, double dt)
+{
+    pool_.submit([this, index, &world, dt] { execute(index, world, dt); });
+}
+
+void Scheduler::execute(std::size_t index, World& world, double dt)
+{
+    auto& node = nodes_[index];
+    try {
+        const auto tick = world.increment_change_tick();
+        // The changes of the system are marked with its own tick, not with
+        // the ticks of the systems that start while it runs
+        world.set_system_tick(tick);
+        node.system->update(world, *node.commands, dt);
+        node.system->last_run_ = tick;
+    } catch (...) {
+        std::lock_guard<std::mutex> lock {mutex_};
+        if (!error_) error_ = std::current_exception();
+    }
+    world.set_system_tick(0);
+
+    // The last finished dependency dispatches a dependent; acq_rel makes the
+    // writes of every dependency visible to it
+    for (auto dependent : node.dependents) {
+        if (pending_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            dispatch(dependent, world, dt);
+        }
+    }
+
+    // Notify under the lock, so that run() cannot return and destroy the
+    // scheduler before this thread is done with it
+    std::lock_guard<std::mutex> lock {mutex_};
+    if (--remaining_ == 0) {
+        finished_.notify_all();
+    }
+}
+
+}} // namespace bolder::ecs
@@ -0,0 +1,365 @@
+#include "ecs/snapshot.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include "bolder/exception.hpp"
+#include "bolder/mapped_file.hpp"
+#include "ecs/world.hpp"
+
+namespace bolder { namespace ecs {
+
+namespace {
+constexpr uint32 snapshot_magic = 0x53574542; // "BEWS" in little endian
+constexpr uint32 snapshot_version = 1;
+constexpr uint32 byte_order_mark = 0x01020304;
+// Every section starts at this alignment, so that it can be read in place
+constexpr std::size_t section_alignment = 16;
+constexpr uint32 npos = ~0u;
+
+// Offsets are from the start of the snapshot
+struct Snapshot_header {
+    uint32 magic;
+    uint32 version;
+    uint32 byte_order;
+    uint32 change_tick;
+    uint32 component_count;
+    uint32 archetype_count;
+    uint32 column_count;
+    uint32 record_count;
+    uint32 free_count;
+    uint32 padding;
+    uint64 components;
+    uint64 archetypes;
+    uint64 columns;
+    uint64 generations;
+    uint64 free_indices;
+    uint64 size;
+};
+
+struct Snapshot_component {
+    uint64 name; ///< Offset of the null-terminated name
+    uint64 size;
+};
+
+struct Snapshot_archetype {
+    uint32 first_column; ///< Index of its first column in the column table
+    uint32 column_count;
+    uint32 size; ///< Number of rows
+    uint32 padding;
+    uint64 entities; ///< Offset of the entity of every row
+};
+
+struct Snapshot_column {
+    uint32 component; ///< Index in the component table
+    uint32 padding;
+    uint64 data; ///< Offset of the component of every row
+};
+
+// Appends sections to the end of a byte vector
+class Snapshot_writer {
+public:
+    explicit Snapshot_writer(std::vector<Byte>& out)
+        : out_{out}, start_{out.size()} {}
+
+    /// Starts a section at an aligned offset and returns the offset
+    uint64 begin_section() {
+        const auto size = out_.size() - start_;
+        out_.resize(start_ + (size + section_alignment - 1)
+                    / section_alignment * section_alignment, 0);
+        return out_.size() - start_;
+    }
+
+    void append(const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const Byte*>(data);
+        out_.insert(out_.end(), bytes, bytes + size);
+    }
+
+    /// Writes a section that contains an array
+    template<typename T>
+    uint64 write(const std::vector<T>& values) {
+        const auto offset = begin_section();
+        append(values.data(), values.size() * sizeof(T));
+        return offset;
+    }
+
+    template<typename T>
+    void overwrite(uint64 offset, const T& value) {
+        std::memcpy(out_.data() + start_ + offset, &value, sizeof(T));
+    }
+
+    uint64 size() const {
+        return out_.size() - start_;
+    }
+
+private:
+    std::vector<Byte>& out_;
+    std::size_t start_;
+};
+
+[[noreturn]] void invalid_snapshot() {
+    throw Runtime_error {"Load an invalid world snapshot"};
+}
+
+// Reads sections with bounds checks
+class Snapshot_reader {
+public:
+    Snapshot_reader(const Byte* data, std::size_t size)
+        : data_{data}, size_{size} {}
+
+    /// Returns an array of count T at offset
+    template<typename T>
+    const T* section(uint64 offset, uint64 count) const {
+        if (offset > size_ || offset % alignof(T) != 0
+                || count > (size_ - offset) / sizeof(T)) {
+            invalid_snapshot();
+        }
+        return reinterpret_cast<const T*>(data_ + offset);
+    }
+
+    /// Returns the null-terminated string at offset
+    const char* string(uint64 offset) const {
+        if (offset >= size_
+                || std::memchr(data_ + offset, 0, size_ - offset) == nullptr) {
+            invalid_snapshot();
+        }
+        return reinterpret_cast<const char*>(data_ + offset);
+    }
+
+private:
+    const Byte* data_;
+    std::size_t size_;
+};
+} // anonymous namespace
+
+void save_snapshot(const World& world, std::vector<Byte>& out)
+{
+    Snapshot_writer writer {out};
+    Snapshot_header header {};
+    writer.append(&header, sizeof(Snapshot_header));
+
+    // Only the component types of non-empty archetypes are written
+    std::vector<uint32> component_indices(max_components, npos);
+    std::vector<Snapshot_component> components;
+    std::vector<Snapshot_archetype> archetypes;
+    std::vector<Snapshot_column> columns;
+
+    for (const auto& archetype : world.archetypes()) {
+        if (archetype->size() == 0) continue;
+
+        archetypes.push_back(Snapshot_archetype{
+            static_cast<uint32>(columns.size()), archetype->column_count(),
+            archetype->size(), 0, writer.begin_section()});
+        for (auto i = 0u; i != archetype->chunk_count(); ++i) {
+            const auto& chunk = archetype->chunk(i);
+            writer.append(archetype->entities(chunk),
+                          chunk.size() * sizeof(Entity));
+        }
+
+        for (auto column = 0u; column != archetype->column_count(); ++column) {
+            const auto id = archetype->column_component(column);
+            const auto& info = component_info(id);
+            if (!info.trivial) {
+                throw Runtime_error {
+                    "Save a snapshot of a component that is not trivially "
+                    "copyable"};
+            }
+            if (info.shared) {
+                throw Runtime_error {"Save a snapshot of a shared component"};
+            }
+
+            if (component_indices[id] == npos) {
+                component_indices[id] = static_cast<uint32>(components.size());
+                const auto name = writer.begin_section();
+                writer.append(info.name, std::strlen(info.name) + 1);
+                components.push_back(Snapshot_component{name, info.size});
+            }
+
+            columns.push_back(Snapshot_column{component_indices[id], 0,
+                                              writer.begin_section()});
+            for (auto i = 0u; i != archetype->chunk_count(); ++i) {
+                auto& chunk = archetype->chunk(i);
+                writer.append(archetype->column_data(chunk, column),
+                              chunk.size() * archetype->column_stride(column));
+            }
+        }
+    }
+
+    std::vector<uint32> generations;
+    generations.reserve(world.records_.size());
+    for (const auto& record : world.records_) {
+        generations.push_back(record.generation);
+    }
+
+    header.magic = snapshot_magic;
+    header.version = snapshot_version;
+    header.byte_order = byte_order_mark;
+    header.change_tick = world.change_tick();
+    header.component_count = static_cast<uint32>(components.size());
+    header.archetype_count = static_cast<uint32>(archetypes.size());
+    header.column_count = static_cast<uint32>(columns.size());
+    header.record_count = static_cast<uint32>(generations.size());
+    header.free_count = static_cast<uint32>(world.free_indices_.size());
+    header.components = writer.write(components);
+    header.archetypes = writer.write(archetypes);
+    header.columns = writer.write(columns);
+    header.generations = writer.write(generations);
+    header.free_indices = writer.write(world.free_indices_);
+    header.size = writer.size();
+    writer.overwrite(0, header);
+}
+
+void save_snapshot(const World& world, const char* filename)
+{
+    std::vector<Byte> snapshot;
+    save_snapshot(world, snapshot);
+
+    std::ofstream file {filename, std::ios::binary};
+    file.write(reinterpret_cast<const char*>(snapshot.data()),
+               static_cast<std::streamsize>(snapshot.size()));
+    if (!file) {
+        throw Runtime_error {"Cannot write world snapshot file"};
+    }
+}
+
+void load_snapshot(World& world, const Byte* data, std::size_t size)
+{
+    if (reinterpret_cast<std::uintptr_t>(data) % section_alignment != 0) {
+        throw Runtime_error {"Load a misaligned world snapshot"};
+    }
+    if (!world.records_.empty()) {
+        throw Runtime_error {"Load a snapshot into a world that had entities"};
+    }
+
+    const Snapshot_reader reader {data, size};
+    const auto& header = *reader.section<Snapshot_header>(0, 1);
+    if (header.magic != snapshot_magic || header.version != snapshot_version
+            || header.byte_order != byte_order_mark || header.size > size) {
+        invalid_snapshot();
+    }
+
+    // Maps the component types of the snapshot to the ones of this program
+    const auto* components = reader.section<Snapshot_component>(
+                header.components, header.component_count);
+    std::vector<Component_id> ids;
+    for (auto i = 0u; i != header.component_count; ++i) {
+        const auto id = find_component(reader.string(components[i].name));
+        if (id == invalid_component) {
+            throw Runtime_error {
+                "Load a snapshot with a component type that is not registered"};
+        }
+        const auto& info = component_info(id);
+        if (info.size != components[i].size || !info.trivial || info.shared) {
+            throw Runtime_error {
+                "Load a snapshot with a component type of another layout"};
+        }
+        ids.push_back(id);
+    }
+
+    const auto* archetypes = reader.section<Snapshot_archetype>(
+                header.archetypes, header.archetype_count);
+    const auto* columns = reader.section<Snapshot_column>(
+                header.columns, header.column_count);
+    const auto* generations = reader.section<uint32>(header.generations,
+                                                     header.record_count);
+    const auto* free_indices = reader.section<uint32>(header.free_indices,
+                                                      header.free_count);
+
+    // Checks everything before touching the world, so that an invalid
+    // snapshot leaves it unchanged
+    std::vector<Signature> signatures;
+    std::vector<bool> used(header.record_count);
+    auto use_index = [&used](uint32 index) {
+        if (index >= used.size() || used[index]) invalid_snapshot();
+        used[index] = true;
+    };
+    for (auto i = 0u; i != header.archetype_count; ++i) {
+        const auto& archetype = archetypes[i];
+        if (archetype.first_column > header.column_count
+                || archetype.column_count
+                   > header.column_count - archetype.first_column) {
+            invalid_snapshot();
+        }
+
+        Signature signature;
+        for (auto j = 0u; j != archetype.column_count; ++j) {
+            const auto& column = columns[archetype.first_column + j];
+            if (column.component >= header.component_count) invalid_snapshot();
+            const auto id = ids[column.component];
+            if (signature[id]) invalid_snapshot();
+            signature.set(id);
+            const auto& info = component_info(id);
+            const auto stride = info.tag ? 0 : info.size;
+            reader.section<Byte>(column.data, uint64{archetype.size} * stride);
+        }
+        signatures.push_back(signature);
+
+        const auto* entities = reader.section<Entity>(archetype.entities,
+                                                      archetype.size);
+        for (auto row = 0u; row != archetype.size; ++row) {
+            use_index(entities[row].index());
+            if (entities[row].generation()
+                    != generations[entities[row].index()]) {
+                invalid_snapshot();
+            }
+        }
+    }
+    for (auto i = 0u; i != header.free_count; ++i) {
+        use_index(free_indices[i]);
+    }
+
+    world.change_tick_.store(header.change_tick, std::memory_order_relaxed);
+    world.records_.assign(header.record_count,
+                          World::Entity_record{Entity_location{}, 0});
+    for (auto i = 0u; i != header.record_count; ++i) {
+        world.records_[i].generation = generations[i];
+    }
+    world.free_indices_.assign(free_indices, free_indices + header.free_count);
+
+    std::vector<const Byte*> sources;
+    for (auto i = 0u; i != header.archetype_count; ++i) {
+        const auto& snapshot_archetype = archetypes[i];
+        auto& archetype = world.archetype(signatures[i]);
+
+        sources.assign(archetype.column_count(), nullptr);
+        for (auto j = 0u; j != snapshot_archetype.column_count; ++j) {
+            const auto& column = columns[snapshot_archetype.first_column + j];
+            sources[archetype.column_index(ids[column.component])] =
+                    data + column.data;
+        }
+
+        // Copies every column in bulk, as many rows as fit in a chunk at once
+        const auto* entities = reader.section<Entity>(
+                    snapshot_archetype.entities, snapshot_archetype.size);
+        for (uint32 loaded = 0; loaded != snapshot_archetype.size;) {
+            auto batch = snapshot_archetype.size - loaded;
+            auto location = archetype.allocate_n(entities + loaded, batch,
+                                                 header.change_tick, nullptr);
+            auto& chunk = archetype.chunk(location.chunk);
+            for (auto column = 0u; column != archetype.column_count();
+                 ++column) {
+                const auto element_size = archetype.column_stride(column);
+                std::memcpy(static_cast<Byte*>(
+                                archetype.column_data(chunk, column))
+                            + location.row * element_size,
+                            sources[column] + loaded * element_size,
+                            batch * element_size);
+            }
+            for (auto row = 0u; row != batch; ++row, ++location.row) {
+                world.records_[entities[loaded + row].index()].location =
+                        location;
+            }
+            loaded += batch;
+        }
+        world.size_ += snapshot_archetype.size;
+    }
+}
+
+void load_snapshot(World& world, const char* filename)
+{
+    const Mapped_file file {filename};
+    load_snapshot(world, file.data(), file.size());
+}
+
+}} // namespace bolder::ecs
@@ -0,0 +1,376 @@
+#include "ecs/world.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+#include "ecs/prefab.hpp"
+
+namespace bolder { namespace ecs {
+
+namespace {
+// The World and the tick of the system that runs on this thread, if any
+struct System_tick {
+    const World* world;
+    uint32 tick;
+};
+
+thread_local System_tick system_tick {nullptr, 0};
+} // anonymous namespace
+
+std::ostream& operator<<(std::ostream& os, Entity entity)
+{
+    const auto flags = os.flags();
+    os << "Entity " << "0x" << std::hex << std::setfill('0')
+       << std::setw(sizeof(uint32) * 2) << entity.index();
+    os.flags(flags);
+    os << " (generation " << entity.generation() << ')';
+    return os;
+}
+
+World::World() : change_tick_{1}
+{
+    archetype(Signature{});
+}
+
+World::~World() = default;
+
+uint32 World::write_tick() const
+{
+    return system_tick.world == this ? system_tick.tick : change_tick();
+}
+
+void World::set_system_tick(uint32 tick)
+{
+    system_tick = tick == 0 ? System_tick{nullptr, 0} : System_tick{this, tick};
+}
+
+Entity World::create_entity()
+{
+    return new_entity(*archetypes_.front(), nullptr);
+}
+
+void World::destroy_entity(Entity entity)
+{
+    const auto location = checked_location(entity);
+    location.archetype->destroy_row(location);
+    remove_row(location);
+
+    auto& record = records_[entity.index()];
+    record.location.archetype = nullptr;
+    if (++record.generation == Entity::reserved_generation) {
+        record.generation = 0;
+    }
+    free_indices_.push_back(entity.index());
+    --size_;
+}
+
+void World::instantiate(const Prefab& prefab, size_type count,
+                        Entity* entities)
+{
+    auto& target = archetype(prefab.signature());
+    std::vector<const void*> prototypes(target.column_count());
+    std::vector<Byte> shared(target.shared_size());
+    for (auto column = 0u; column != target.column_count(); ++column) {
+        const auto id = target.column_component(column);
+        prototypes[column] = prefab.find(id);
+        if (component_info(id).shared) {
+            std::memcpy(shared.data() + target.shared_offset(column),
+                        prototypes[column], component_info(id).size);
+        }
+    }
+
+    for (auto i = 0u; i != count; ++i) {
+        entities[i] = reserve_entity();
+    }
+
+    uint32 created = 0;
+    try {
+        while (created != count) {
+            auto batch = count - created;
+            auto location = target.allocate_n(entities + created, batch,
+                                              write_tick(), shared.data());
+            for (auto i = 0u; i != batch; ++i, ++location.row) {
+                records_[entities[created + i].index()].location = location;
+            }
+            size_ += batch;
+
+            location.row -= batch;
+            try {
+                target.clone_rows(location, batch, prototypes.data());
+            } catch (...) {
+                // Removes the rows from the last one, so that no row moves
+                for (auto i = batch; i-- != 0;) {
+                    auto& record = records_[entities[created + i].index()];
+                    remove_row(record.location);
+                    record.location.archetype = nullptr;
+                }
+                size_ -= batch;
+                throw;
+            }
+            created += batch;
+        }
+    } catch (...) {
+        for (auto i = created; i-- != 0;) {
+            destroy_entity(entities[i]);
+        }
+        for (auto i = created; i != count; ++i) {
+            free_indices_.push_back(entities[i].index());
+        }
+        throw;
+    }
+}
+
+std::vector<Entity> World::instantiate(const Prefab& prefab, size_type count)
+{
+    std::vector<Entity> entities(count);
+    instantiate(prefab, count, entities.data());
+    return entities;
+}
+
+bool World::compact(std::chrono::steady_clock::duration budget)
+{
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    for (std::size_t visited = 0; visited != archetypes_.size(); ++visited) {
+        auto& archetype = *archetypes_[compact_cursor_];
+        for (;;) {
+            auto count = archetype.chunk_capacity();
+            auto location = archetype.compact(count);
+            if (count == 0) break;
+
+            const auto* moved = archetype.entities(
+                        archetype.chunk(location.chunk)) + location.row;
+            for (auto i = 0u; i != count; ++i, ++location.row) {
+                records_[moved[i].index()].location = location;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+        }
+        compact_cursor_ = (compact_cursor_ + 1) % archetypes_.size();
+    }
+    return true;
+}
+
+bool World::alive(Entity entity) const
+{
+    if (entity.index() >= records_.size()) {
+        return false;
+    }
+
+    const auto& record = records_[entity.index()];
+    return record.generation == entity.generation()
+            && record.location.archetype != nullptr;
+}
+
+Archetype& World::archetype(const Signature& signature)
+{
+    const auto found = archetype_index_.find(signature);
+    if (found != archetype_index_.end()) {
+        return *found->second;
+    }
+
+    archetypes_.push_back(std::make_unique<Archetype>(signature));
+    auto& created = *archetypes_.back();
+    archetype_index_.emplace(signature, &created);
+
+    std::lock_guard<std::mutex> lock {query_caches_mutex_};
+    for (auto& cache : query_caches_) {
+        if (cache.second->matches(created)) {
+            cache.second->archetypes_.push_back(&created);
+        }
+    }
+    return created;
+}
+
+const Query_cache& World::query_cache(const Signature& signature)
+{
+    std::lock_guard<std::mutex> lock {query_caches_mutex_};
+    const auto found = query_caches_.find(signature);
+    if (found != query_caches_.end()) {
+        return *found->second;
+    }
+
+    auto cache = std::make_unique<Query_cache>(signature);
+    for (const auto& archetype : archetypes_) {
+        if (cache->matches(*archetype)) {
+            cache->archetypes_.push_back(archetype.get());
+        }
+    }
+    return *query_caches_.emplace(signature, std::move(cache)).first->second;
+}
+
+Entity_location& World::checked_location(Entity entity)
+{
+    if (!alive(entity)) {
+        throw Runtime_error {"Use an entity that is not alive"};
+    }
+    return records_[entity.index()].location;
+}
+
+// Creates an entity in a row of archetype, leaving its components
+// uninitialized
+Entity World::new_entity(Archetype& archetype, const Byte* shared)
+{
+    const auto entity = reserve_entity();
+    records_[entity.index()].location = archetype.allocate(
+                entity, write_tick(), shared);
+    ++size_;
+    return entity;
+}
+
+// Creates count entities in consecutive rows of archetype, leaving their
+// components uninitialized
+void World::new_entities(Archetype& archetype, uint32 count, Entity* entities,
+                         const Byte* shared)
+{
+    for (auto i = 0u; i != count; ++i) {
+        entities[i] = reserve_entity();
+    }
+
+    for (auto created = 0u; created != count;) {
+        auto batch = count - created;
+        auto location = archetype.allocate_n(entities + created, batch,
+                                             write_tick(), shared);
+        for (auto i = 0u; i != batch; ++i, ++location.row) {
+            records_[entities[created + i].index()].location = location;
+        }
+        created += batch;
+    }
+    size_ += count;
+}
+
+// Takes an unused entity index. Reuses the index of a destroyed entity if there
+// is one.
+Entity World::reserve_entity()
+{
+    uint32 index;
+    if (free_indices_.empty()) {
+        assert(records_.size() < ~0u);
+        index = static_cast<uint32>(records_.size());
+        records_.push_back(Entity_record{Entity_location{}, 0});
+    } else {
+        index = free_indices_.back();
+        free_indices_.pop_back();
+    }
+    return Entity {index, records_[index].generation};
+}
+
+void* World::insert_component(Entity entity, Component_id component,
+                              const void* value)
+{
+    const auto& location = checked_location(entity);
+    if (location.archetype->signature()[component]) {
+        throw Runtime_error {"Add a component that the entity already has"};
+    }
+
+    auto signature = location.archetype->signature();
+    signature.set(component);
+    move_entity(entity, archetype(signature), component, value);
+
+    const auto& new_location = records_[entity.index()].location;
+    return new_location.archetype->component(new_location, component);
+}
+
+void* World::find_component(Entity entity, Component_id component) const
+{
+    if (!alive(entity)) {
+        return nullptr;
+    }
+
+    const auto& location = records_[entity.index()].location;
+    return location.archetype->component(location, component);
+}
+
+// Returns a component of an entity for writing, or nullptr if it is not alive
+// or has no such component
+void* World::write_component(Entity entity, Component_id component)
+{
+    if (!alive(entity)) {
+        return nullptr;
+    }
+
+    const auto& location = records_[entity.index()].location;
+    auto& archetype = *location.archetype;
+    const auto column = archetype.column_index(component);
+    if (column == Archetype::npos) {
+        return nullptr;
+    }
+
+    archetype.mark_changed(archetype.chunk(location.chunk), column,
+                           write_tick());
+    return archetype.component(location, component);
+}
+
+void World::erase_component(Entity entity, Component_id component)
+{
+    const auto& location = checked_location(entity);
+    if (!location.archetype->signature()[component]) {
+        throw Runtime_error {"Remove a component that the entity does not have"};
+    }
+
+    auto signature = location.archetype->signature();
+    signature.reset(component);
+    move_entity(entity, archetype(signature), invalid_component, nullptr);
+}
+
+void World::set_shared(Entity entity, Component_id component,
+                       const void* value)
+{
+    const auto location = checked_location(entity);
+    auto& archetype = *location.archetype;
+    if (!archetype.signature()[component]) {
+        throw Runtime_error {"Set a component that the entity does not have"};
+    }
+
+    const auto shared = shared_values(location, archetype, component, value);
+    if (std::memcmp(shared.data(),
+                    archetype.shared_values(archetype.chunk(location.chunk)),
+                    shared.size()) != 0) {
+        move_entity(entity, archetype, component, value);
+    }
+}
+
+// Moves an entity to a row of target. If component is shared, the row goes to
+// a chunk whose component is value.
+void World::move_entity(Entity entity, Archetype& target,
+                        Component_id component, const void* value)
+{
+    const auto location = records_[entity.index()].location;
+    const auto shared = shared_values(location, target, component, value);
+    const auto destination = target.allocate(entity, write_tick(),
+                                             shared.data());
+    location.archetype->move_row(location, target, destination);
+    remove_row(location);
+    records_[entity.index()].location = destination;
+}
+
+// Removes a row and patches the location of the entity moved into it
+void World::remove_row(const Entity_location& location)
+{
+    const auto moved = location.archetype->remove_row(location);
+    records_[moved.index()].location = location;
+}
+
+// Gathers the shared components of the row of an entity in target: value for
+// component, and the ones of its current chunk for the others
+std::vector<Byte> World::shared_values(const Entity_location& location,
+                                       const Archetype& target,
+                                       Component_id component,
+                                       const void* value) const
+{
+    std::vector<Byte> shared(target.shared_size());
+    for (auto column = 0u; column != target.column_count(); ++column) {
+        const auto id = target.column_component(column);
+        const auto& info = component_info(id);
+        if (!info.shared) continue;
+
+        const auto* source = id == component
+                ? value : location.archetype->component(location, id);
+        std::memcpy(shared.data() + target.shared_offset(column), source,
+                    info.size);
+    }
+    return shared;
+}
+
+}} // namespace bolder::ecs
@@ -0,0 +1,170 @@
+#include "bolder/ecs/command_buffer.hpp"
+#include "bolder/ecs/query.hpp"
+#include "bolder/ecs/world.hpp"
+#include "bolder/thread_pool.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+
+namespace {
+struct Position {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y;
+};
+
+struct Name {
+    std::string value;
+};
+} // anonymous namespace
+
+TEST_CASE("ECS Command_buffer") {
+    ecs::World world;
+    ecs::Command_buffer commands;
+    const auto existing = world.create_entity(Position{1, 2});
+
+    SUBCASE("Records nothing until playback") {
+        commands.create_entity(Position{3, 4});
+        commands.destroy_entity(existing);
+        REQUIRE_FALSE(commands.empty());
+        REQUIRE_EQ(world.size(), 1);
+        REQUIRE(world.alive(existing));
+
+        commands.playback(world);
+        REQUIRE(commands.empty());
+        REQUIRE_EQ(world.size(), 1);
+        REQUIRE_FALSE(world.alive(existing));
+    }
+
+    SUBCASE("Creates entities with their components") {
+        std::vector<ecs::Entity> pending;
+        for (int i = 0; i != 3000; ++i) {
+            const auto x = static_cast<float>(i);
+            pending.push_back(i % 3 == 0
+                    ? commands.create_entity(Position{x, 0}, Velocity{1, 0})
+                    : commands.create_entity(Position{x, 0}));
+        }
+        commands.create_entity(Name{"a name that does not fit in small buffer"});
+        commands.add_component(pending[1], Velocity{2, 0});
+        commands.playback(world);
+
+        REQUIRE_EQ(world.size(), 3002);
+        float sum = 0;
+        int count = 0;
+        ecs::Query<const Position, const Velocity>{world}.each(
+                    [&](const Position& position, const Velocity& velocity) {
+            sum += position.x * velocity.x;
+            ++count;
+        });
+        REQUIRE_EQ(count, 1001);
+        // Sum of multiples of 3 below 3000, plus 2 for the added Velocity
+        REQUIRE_EQ(sum, 1498500.f + 2.f);
+
+        int names = 0;
+        ecs::Query<const Name>{world}.each([&names](const Name& name) {
+            REQUIRE_EQ(name.value, "a name that does not fit in small buffer");
+            ++names;
+        });
+        REQUIRE_EQ(names, 1);
+    }
+
+    SUBCASE("Moves components of many entities into several chunks") {
+        for (int i = 0; i != 2000; ++i) {
+            commands.create_entity(Name{std::to_string(i)
+                                        + " does not fit in small buffer"},
+                                   Position{static_cast<float>(i), 0});
+        }
+        commands.playback(world);
+
+        int count = 0;
+        ecs::Query<const Name, const Position>{world}.each(
+                    [&count](const Name& name, const Position& position) {
+            REQUIRE_EQ(name.value, std::to_string(static_cast<int>(position.x))
+                       + " does not fit in small buffer");
+            ++count;
+        });
+        REQUIRE_EQ(count, 2000);
+    }
+
+    SUBCASE("Throws on duplicated component types") {
+        REQUIRE_THROWS_AS(commands.create_entity(Position{1, 2}, Position{3, 4}),
+                          Runtime_error);
+        REQUIRE(commands.empty());
+    }
+
+    SUBCASE("Plays back the commands of the participants") {
+        Thread_pool pool {3};
+        for (int i = 0; i != 1000; ++i) {
+            world.create_entity(Velocity{static_cast<float>(i), 0});
+        }
+
+        commands.destroy_entity(existing);
+        ecs::Query<const Velocity>{world}.par_each(
+                    pool, commands.participants(pool),
+                    [](ecs::Command_buffer& commands, const Velocity& velocity) {
+            const auto entity = commands.create_entity(Position{velocity.x, 0});
+            commands.add_component(entity, Name{"spawned"});
+        });
+        REQUIRE_FALSE(commands.empty());
+        REQUIRE_EQ(world.size(), 1001);
+
+        commands.playback(world);
+        REQUIRE(commands.empty());
+        REQUIRE_FALSE(world.alive(existing));
+        float sum = 0;
+        ecs::Query<const Position, const Name>{world}.each(
+                    [&sum](const Position& position, const Name&) {
+            sum += position.x;
+        });
+        REQUIRE_EQ(sum, 499500.f);
+        REQUIRE_EQ(world.size(), 2000);
+    }
+
+    SUBCASE("Adds, sets and removes components in order") {
+        commands.add_component(existing, Velocity{5, 6});
+        commands.set_component(existing, Position{7, 8});
+        commands.remove_component<Velocity>(existing);
+        commands.add_component(existing, Name{"existing"});
+        commands.playback(world);
+
+        REQUIRE_EQ(world.get_component<Position>(existing)->x, 7);
+        REQUIRE_FALSE(world.has_component<Velocity>(existing));
+        REQUIRE_EQ(world.get_component<Name>(existing)->value, "existing");
+    }
+
+    SUBCASE("Throws on invalid command and discards the rest") {
+        world.destroy_entity(existing);
+        commands.add_component(existing, Name{"lost"});
+        commands.create_entity(Name{"dropped"});
+        REQUIRE_THROWS_AS(commands.playback(world), Runtime_error);
+        REQUIRE(commands.empty());
+
+        // The buffer is still usable
+        const auto entity = commands.create_entity(Name{"kept"});
+        commands.set_component(entity, Name{"renamed"});
+        commands.playback(world);
+        REQUIRE_EQ(world.size(), 2);
+    }
+
+    SUBCASE("Destroys components that are not played back") {
+        auto shared = std::make_shared<int>(0);
+        {
+            ecs::Command_buffer discarded;
+            discarded.create_entity(shared);
+            discarded.add_component(existing, shared);
+            REQUIRE_EQ(shared.use_count(), 3);
+
+            Thread_pool pool {1};
+            discarded.participants(pool)[1].create_entity(shared);
+            REQUIRE_EQ(shared.use_count(), 4);
+        }
+        REQUIRE_EQ(shared.use_count(), 1);
+    }
+}
@@ -0,0 +1,88 @@
+#include "bolder/handle.hpp"
+#include "bolder/concurrent_handle_manager.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+using Test_handle = resource::Handle<12>;
+
+TEST_CASE("Concurrent_handle_manager on a single thread") {
+    resource::Concurrent_handle_manager<Test_handle, int, 2> handles;
+    auto handle0 = handles.add(1);
+    auto handle1 = handles.add(2);
+
+    REQUIRE_EQ(handles.size(), 2);
+    REQUIRE_EQ(*handles[handle0], 1);
+    REQUIRE_EQ(*handles[handle1], 2);
+
+    SUBCASE("Throw exception when add too many entries") {
+        REQUIRE_THROWS_AS(handles.add(3), const resource::Resource_error&);
+    }
+
+    SUBCASE("Remove entries") {
+        handles.remove(handle0);
+        REQUIRE_EQ(handles.size(), 1);
+        REQUIRE_EQ(handles[handle0], nullptr);
+
+        REQUIRE_THROWS_AS(handles.remove(handle0),
+                          const resource::Resource_error&);
+
+        auto handle2 = handles.add(3);
+        REQUIRE_EQ(handle2.index(), handle0.index());
+        REQUIRE_NE(handle2.generation(), handle0.generation());
+        REQUIRE_EQ(handles[handle0], nullptr);
+        REQUIRE_EQ(*handles[handle2], 3);
+
+        REQUIRE_THROWS_AS(handles.remove(handle0),
+                          const resource::Resource_error&);
+    }
+}
+
+TEST_CASE("Concurrent_handle_manager stress test") {
+    constexpr int thread_count = 4;
+    constexpr int iterations = 20000;
+    constexpr int handles_per_thread = 64;
+
+    using Manager = resource::Concurrent_handle_manager<Test_handle, int>;
+    auto handles = std::make_unique<Manager>();
+    std::atomic<int> errors {0};
+
+    // Every thread repeatedly fills its own batch of handles and releases them,
+    // so that all threads keep racing on the shared free list.
+    auto worker = [&](int id) {
+        std::vector<Test_handle> owned;
+        for (int i = 0; i != iterations; ++i) {
+            const int value = id * iterations + i;
+            owned.push_back(handles->add(value));
+            const auto* resolved = (*handles)[owned.back()];
+            if (!resolved || *resolved != value) ++errors;
+
+            if (owned.size() == handles_per_thread) {
+                for (auto handle : owned) {
+                    handles->remove(handle);
+                    if ((*handles)[handle] != nullptr) ++errors;
+                }
+                owned.clear();
+            }
+        }
+        for (auto handle : owned) {
+            handles->remove(handle);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id != thread_count; ++id) {
+        threads.emplace_back(worker, id);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE_EQ(errors.load(), 0);
+    REQUIRE_EQ(handles->size(), 0);
+}
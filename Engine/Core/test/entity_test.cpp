@@ -1,89 +1,31 @@
-#include <cstdint>
-#include <cassert>
-#include <stdexcept>
-#include <iomanip>
-
-#include "doctest.h"
-
-using ID = std::uint32_t;
-
-class World;
-
-class Entity {
-public:
-    ID index() const {
-        return index_;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const Entity& entity);
-
-private:
-    friend class World;
-
-    Entity(ID index, const World* world)
-        : index_{index},
-          world_{world} {
-    }
-
-    const ID index_;
-    const World* world_;
-};
-
-class World {
-public:
-    /// Creates an entity and return that entity
-    Entity create_entity();
-
-    /// Distory entity with a certain id
-    void destory_entity(ID id);
-
-private:
-    ID count_ = 0;
-};
-
-inline bool operator==(Entity lhs, Entity rhs) {
-    return lhs.index() == rhs.index();
-}
-
-inline bool operator!=(Entity lhs, Entity rhs) {
-    return lhs.index() != rhs.index();
-}
+#include "bolder/ecs/world.hpp"
 
+#include <sstream>
+#include <vector>
 
-std::ostream& operator<<(std::ostream& os, const Entity& entity) {
-    os << "Entity " << "0x" << std::hex << std::setfill('0') <<
-          std::setw(sizeof(ID) * 2) << entity.index();
-    return os;
-}
-
-
-Entity World::create_entity()
-{
-    assert(count_ != (ID{0} - 1));
-    return Entity {count_++, this};
-}
-
-void World::destory_entity(ID id)
-{
-    if (id >= count_) {
-        throw std::runtime_error{"Trying to delete not exist entities\n"};
-    }
+#include "doctest.h"
 
-    // Todo: destory all the components
-}
+using namespace bolder;
 
 SCENARIO("World class") {
-    World world;
+    ecs::World world;
     const auto entity0 = world.create_entity();
     const auto entity1 = world.create_entity();
 
     SUBCASE("Create entity from factory") {
         REQUIRE_EQ(entity0.index(), 0);
         REQUIRE_EQ(entity1.index(), 1);
+        REQUIRE_EQ(world.size(), 2);
+        REQUIRE(world.alive(entity0));
     }
 
-    SUBCASE("Cannot destory entity that have ID larger then created entities") {
-        REQUIRE_THROWS_AS(world.destory_entity(2), std::runtime_error);
+    SUBCASE("Cannot destroy entity that is not alive") {
+        world.destroy_entity(entity1);
+        REQUIRE_FALSE(world.alive(entity1));
+        REQUIRE(world.alive(entity0));
+        REQUIRE_EQ(world.size(), 1);
+        REQUIRE_THROWS_AS(world.destroy_entity(entity1), Runtime_error);
+        REQUIRE_THROWS_AS(world.destroy_entity(ecs::Entity{}), Runtime_error);
     }
 
     SUBCASE("Compare entity: ==") {
@@ -91,4 +33,43 @@ SCENARIO("World class") {
         REQUIRE_NE(entity0, entity1);
     }
 
+    SUBCASE("Print entity") {
+        std::stringstream ss;
+        ss << entity1;
+        REQUIRE_EQ(ss.str(), "Entity 0x00000001 (generation 0)");
+    }
+}
+
+TEST_CASE("World recycles entity indices") {
+    ecs::World world;
+    const auto entity0 = world.create_entity();
+    world.destroy_entity(entity0);
+
+    const auto entity1 = world.create_entity();
+    REQUIRE_EQ(entity1.index(), entity0.index());
+    REQUIRE_NE(entity1.generation(), entity0.generation());
+    REQUIRE_NE(entity1, entity0);
+
+    SUBCASE("Destroyed entity stays dead after its index is reused") {
+        REQUIRE_FALSE(world.alive(entity0));
+        REQUIRE(world.alive(entity1));
+        REQUIRE_THROWS_AS(world.destroy_entity(entity0), Runtime_error);
+        REQUIRE(world.alive(entity1));
+    }
+
+    SUBCASE("Indices stay dense under churn") {
+        std::vector<ecs::Entity> entities;
+        for (int round = 0; round != 100; ++round) {
+            for (int i = 0; i != 100; ++i) {
+                entities.push_back(world.create_entity());
+            }
+            for (auto entity : entities) {
+                world.destroy_entity(entity);
+            }
+            entities.clear();
+        }
+
+        REQUIRE_LT(world.create_entity().index(), 101);
+        REQUIRE_EQ(world.size(), 2);
+    }
 }
@@ -2,9 +2,14 @@
 
 #include "bolder/event.hpp"
 
+#include <atomic>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include "doctest.h"
 
+#include "bolder/exception.hpp"
+
 using namespace bolder;
 
 struct Test_event {
@@ -39,3 +44,79 @@ TEST_CASE("Event system") {
         REQUIRE_EQ(ss.str(), "Event received: 456");
     }
 }
+
+namespace {
+struct Counted_event {
+    int value;
+};
+
+struct Counting_handler : event::Handler_trait<Counted_event> {
+    std::atomic<int> sum {0};
+
+    void operator()(const event_type& event) {
+        sum += event.value;
+    }
+};
+
+// Adds another handler and removes itself while it handles an event
+class Replacing_handler : public event::Handler_trait<Counted_event> {
+public:
+    Replacing_handler(event::Channel& channel, Counting_handler& replacement)
+        : channel_{channel}, replacement_{replacement} {}
+
+    void operator()(const event_type&) {
+        channel_.add_handler<Counted_event>(replacement_);
+        channel_.remove_handler<Counted_event>(*this);
+    }
+
+private:
+    event::Channel& channel_;
+    Counting_handler& replacement_;
+};
+}
+
+TEST_CASE("Event channel changes handlers") {
+    event::Channel channel;
+    Counting_handler counter;
+
+    SUBCASE("Handlers added or removed during a broadcast take effect at the "
+            "next broadcast") {
+        Replacing_handler replacer {channel, counter};
+        channel.add_handler<Counted_event>(replacer);
+        channel.broadcast(Counted_event{1});
+        CHECK_EQ(counter.sum, 0);
+        channel.broadcast(Counted_event{2});
+        CHECK_EQ(counter.sum, 2);
+        channel.remove_handler<Counted_event>(counter);
+    }
+
+    SUBCASE("Throws when removing a handler that was not added") {
+        CHECK_THROWS_AS(channel.remove_handler<Counted_event>(counter),
+                        Runtime_error);
+    }
+
+    SUBCASE("Broadcasts while other threads add and remove handlers") {
+        channel.add_handler<Counted_event>(counter);
+        std::atomic<bool> done {false};
+        std::vector<std::thread> threads;
+        for (int i = 0; i != 2; ++i) {
+            threads.emplace_back([&channel, &done] {
+                Counting_handler temporary;
+                while (!done) {
+                    channel.add_handler<Counted_event>(temporary);
+                    channel.remove_handler<Counted_event>(temporary);
+                }
+            });
+        }
+
+        constexpr int broadcasts = 10000;
+        for (int i = 0; i != broadcasts; ++i) {
+            channel.broadcast(Counted_event{1});
+        }
+        done = true;
+        for (auto& thread : threads) thread.join();
+        channel.remove_handler<Counted_event>(counter);
+
+        CHECK_EQ(counter.sum, broadcasts);
+    }
+}
@@ -1,6 +1,12 @@
 #include "bolder/handle.hpp"
 #include "bolder/handle_manager.hpp"
 
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <vector>
+
 #include "doctest.h"
 
 using namespace bolder;
@@ -67,5 +73,200 @@ TEST_CASE("Multiple entry Handle_manager") {
                           const resource::Resource_error&);
     }
 
+    SUBCASE("Iterates over live elements in insertion order") {
+        std::vector<int> visited;
+        handles.for_each([&visited](int value) { visited.push_back(value); });
+        REQUIRE_EQ(visited, std::vector<int>{1, 2, 3});
+    }
+
+    SUBCASE("Elements stay packed after removal") {
+        handles.remove(handle0);
+        REQUIRE_EQ(handles.end() - handles.begin(), 2);
+        REQUIRE_EQ(std::accumulate(handles.begin(), handles.end(), 0), 5);
+        REQUIRE_EQ(*handles[handle1], 2);
+        REQUIRE_EQ(*handles[handle2], 3);
+
+        auto handle3 = handles.add(4);
+        REQUIRE_EQ(std::accumulate(handles.begin(), handles.end(), 0), 9);
+        REQUIRE_EQ(*handles[handle3], 4);
+    }
+}
+
+namespace {
+// Counts live instances; has neither default nor copy constructor
+struct Tracked {
+    static int alive;
+
+    explicit Tracked(int v) : value{std::make_unique<int>(v)} { ++alive; }
+    Tracked(Tracked&& other) noexcept : value{std::move(other.value)} {
+        ++alive;
+    }
+    // Removal must not need assignment
+    Tracked& operator=(Tracked&& other) = delete;
+    ~Tracked() { --alive; }
+
+    std::unique_ptr<int> value;
+};
+
+int Tracked::alive = 0;
+}
+
+TEST_CASE("Handle_manager with move-only elements") {
+    {
+        resource::Handle_manager<Test_handle, Tracked, 16> handles;
+
+        SUBCASE("Constructs no element up front") {
+            REQUIRE_EQ(Tracked::alive, 0);
+        }
+
+        auto handle0 = handles.emplace(1);
+        auto handle1 = handles.add(Tracked{2});
+        REQUIRE_EQ(Tracked::alive, 2);
+        REQUIRE_EQ(*handles[handle0]->value, 1);
+        REQUIRE_EQ(*handles[handle1]->value, 2);
+
+        SUBCASE("Destroys element on remove") {
+            handles.remove(handle0);
+            REQUIRE_EQ(Tracked::alive, 1);
+            REQUIRE_EQ(*handles[handle1]->value, 2);
+        }
+
+        SUBCASE("Elements can be modified through handles") {
+            *handles[handle0]->value = 10;
+            REQUIRE_EQ(*handles[handle0]->value, 10);
+        }
+    }
+
+    REQUIRE_EQ(Tracked::alive, 0);
+}
+
+TEST_CASE("Batched operations of Handle_manager") {
+    resource::Handle_manager<Test_handle, int, 8> handles;
+    const int values[] = {1, 2, 3, 4, 5};
+    Test_handle added[5];
+    handles.add_n(values, 5, added);
+    REQUIRE_EQ(handles.size(), 5);
+
+    SUBCASE("Resolves a batch of handles") {
+        const int* resolved[5];
+        REQUIRE_EQ(handles.resolve_n(added, 5, resolved), 5);
+        for (auto i = 0u; i != 5; ++i) {
+            REQUIRE_EQ(*resolved[i], values[i]);
+        }
+    }
+
+    SUBCASE("Throw exception without adding anything when batch is too big") {
+        REQUIRE_THROWS_AS(handles.add_n(values, 4, added),
+                          const resource::Resource_error&);
+        REQUIRE_EQ(handles.size(), 5);
+    }
+
+    SUBCASE("Removes a batch of handles") {
+        const Test_handle removed[] = {added[0], added[3]};
+        handles.remove_n(removed, 2);
+        REQUIRE_EQ(handles.size(), 3);
 
+        const int* resolved[5];
+        REQUIRE_EQ(handles.resolve_n(added, 5, resolved), 3);
+        REQUIRE_EQ(resolved[0], nullptr);
+        REQUIRE_EQ(*resolved[1], 2);
+        REQUIRE_EQ(*resolved[2], 3);
+        REQUIRE_EQ(resolved[3], nullptr);
+        REQUIRE_EQ(*resolved[4], 5);
+
+        SUBCASE("Throw exception without removing anything for stale handle") {
+            REQUIRE_THROWS_AS(handles.remove_n(added, 5),
+                              const resource::Resource_error&);
+            REQUIRE_EQ(handles.size(), 3);
+        }
+    }
+
+    SUBCASE("Removes a repeated handle once") {
+        const Test_handle removed[] = {added[1], added[1], added[2]};
+        handles.remove_n(removed, 3);
+        REQUIRE_EQ(handles.size(), 3);
+
+        // The free list holds each entry once, so new handles are distinct
+        const int values[] = {6, 7};
+        Test_handle readded[2];
+        handles.add_n(values, 2, readded);
+        REQUIRE_NE(readded[0].index(), readded[1].index());
+        REQUIRE_EQ(*handles[readded[0]], 6);
+        REQUIRE_EQ(*handles[readded[1]], 7);
+        REQUIRE_EQ(handles.size(), 5);
+    }
+}
+
+TEST_CASE("Snapshot and restore of Handle_manager") {
+    resource::Handle_manager<Test_handle, int, 8> handles;
+    auto handle0 = handles.add(1);
+    auto handle1 = handles.add(2);
+    auto handle2 = handles.add(3);
+    handles.remove(handle1);
+
+    std::vector<Byte> snapshot;
+    handles.snapshot(snapshot);
+    REQUIRE_EQ(snapshot.size(), handles.snapshot_size());
+
+    SUBCASE("Restores handles and values after modification") {
+        *handles[handle0] = 10;
+        handles.remove(handle2);
+        auto handle3 = handles.add(4);
+        auto handle4 = handles.add(5);
+
+        handles.restore(snapshot.data(), snapshot.size());
+        REQUIRE_EQ(handles.size(), 2);
+        REQUIRE_EQ(*handles[handle0], 1);
+        REQUIRE_EQ(*handles[handle2], 3);
+        REQUIRE_EQ(handles[handle1], nullptr);
+        REQUIRE_EQ(handles[handle3], nullptr);
+        REQUIRE_EQ(handles[handle4], nullptr);
+        REQUIRE_EQ(std::accumulate(handles.begin(), handles.end(), 0), 4);
+
+        SUBCASE("Free list is restored") {
+            auto handle5 = handles.add(6);
+            REQUIRE_EQ(handle5.index(), handle1.index());
+            REQUIRE_NE(handle5.generation(), handle1.generation());
+            REQUIRE_EQ(*handles[handle5], 6);
+            handles.remove(handle0);
+            REQUIRE_EQ(*handles[handle2], 3);
+        }
+    }
+
+    SUBCASE("Throw exception without changing anything for invalid snapshot") {
+        auto handle3 = handles.add(4);
+
+        REQUIRE_THROWS_AS(handles.restore(snapshot.data(), snapshot.size() - 1),
+                          const resource::Resource_error&);
+
+        std::vector<Byte> corrupted = snapshot;
+        corrupted[0] ^= 0xFF;
+        REQUIRE_THROWS_AS(handles.restore(corrupted.data(), corrupted.size()),
+                          const resource::Resource_error&);
+
+        resource::Handle_manager<Test_handle, int, 16> bigger;
+        REQUIRE_THROWS_AS(bigger.restore(snapshot.data(), snapshot.size()),
+                          const resource::Resource_error&);
+
+        // Free list that starts outside of the entries
+        using Header = resource::detail::Handle_snapshot_header;
+        corrupted = snapshot;
+        const uint32 outside = 8;
+        std::memcpy(corrupted.data() + offsetof(Header, first_free_entry),
+                    &outside, sizeof(outside));
+        REQUIRE_THROWS_AS(handles.restore(corrupted.data(), corrupted.size()),
+                          const resource::Resource_error&);
+
+        // Dense element that claims a free entry
+        corrupted = snapshot;
+        const uint32 free_entry = 7;
+        std::memcpy(corrupted.data() + corrupted.size()
+                        - 2 * (sizeof(uint32) + sizeof(int)),
+                    &free_entry, sizeof(free_entry));
+        REQUIRE_THROWS_AS(handles.restore(corrupted.data(), corrupted.size()),
+                          const resource::Resource_error&);
+
+        REQUIRE_EQ(handles.size(), 3);
+        REQUIRE_EQ(*handles[handle3], 4);
+    }
 }
@@ -0,0 +1,187 @@
+#include "bolder/handle.hpp"
+#include "bolder/paged_handle_manager.hpp"
+
+#include <memory>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+using Test_handle = resource::Handle<12>;
+
+namespace {
+// Can be moved into a new object, but not assigned
+struct Unassignable {
+    explicit Unassignable(int v) : value{std::make_unique<int>(v)} {}
+    Unassignable(Unassignable&&) noexcept = default;
+    Unassignable& operator=(Unassignable&&) = delete;
+
+    std::unique_ptr<int> value;
+};
+}
+
+TEST_CASE("Paged_handle_manager") {
+    resource::Paged_handle_manager<Test_handle, int, 4> handles;
+
+    SUBCASE("Allocates no page up front") {
+        REQUIRE_EQ(handles.capacity(), 0);
+        REQUIRE_EQ(handles.size(), 0);
+    }
+
+    auto handle0 = handles.add(1);
+    auto handle1 = handles.add(2);
+
+    SUBCASE("Gets correct values from multiple entries") {
+        REQUIRE_EQ(handles.size(), 2);
+        REQUIRE_EQ(handles.capacity(), 4);
+        REQUIRE_EQ(*handles[handle0], 1);
+        REQUIRE_EQ(*handles[handle1], 2);
+    }
+
+    SUBCASE("Grows a new page when the allocated pages are full") {
+        std::vector<Test_handle> more;
+        for (int i = 0; i != 6; ++i) {
+            more.push_back(handles.add(10 + i));
+        }
+        REQUIRE_EQ(handles.size(), 8);
+        REQUIRE_EQ(handles.capacity(), 8);
+        for (int i = 0; i != 6; ++i) {
+            REQUIRE_EQ(*handles[more[static_cast<size_t>(i)]], 10 + i);
+        }
+        REQUIRE_EQ(*handles[handle0], 1);
+    }
+
+    SUBCASE("Iterates over live elements") {
+        for (auto& value : handles) {
+            value *= 10;
+        }
+        REQUIRE_EQ(*handles[handle0], 10);
+        REQUIRE_EQ(*handles[handle1], 20);
+
+        int sum = 0;
+        handles.for_each([&sum](int value) { sum += value; });
+        REQUIRE_EQ(sum, 30);
+    }
+
+    SUBCASE("Remove entries") {
+        handles.remove(handle0);
+
+        SUBCASE("null if entry removed") {
+            REQUIRE_EQ(handles[handle0], nullptr);
+            REQUIRE_EQ(*handles[handle1], 2);
+            REQUIRE_EQ(handles.end() - handles.begin(), 1);
+            REQUIRE_EQ(*handles.begin(), 2);
+        }
+
+        SUBCASE("Throw exception when remove none exist entries") {
+            REQUIRE_THROWS_AS(handles.remove(handle0),
+                              const resource::Resource_error&);
+        }
+
+        SUBCASE("Reuses freed slot before growing") {
+            auto handle2 = handles.add(3);
+            REQUIRE_EQ(handle2.index(), handle0.index());
+            REQUIRE_NE(handle2.generation(), handle0.generation());
+            REQUIRE_EQ(handles[handle0], nullptr);
+            REQUIRE_EQ(*handles[handle2], 3);
+            REQUIRE_EQ(handles.capacity(), 4);
+        }
+
+        SUBCASE("Stale handle stays invalid after its page is emptied") {
+            handles.remove(handle1);
+            REQUIRE_EQ(handles.size(), 0);
+            auto handle2 = handles.add(4);
+            REQUIRE_EQ(handles[handle0], nullptr);
+            REQUIRE_EQ(handles[handle1], nullptr);
+            REQUIRE_EQ(*handles[handle2], 4);
+        }
+    }
+}
+
+TEST_CASE("Paged_handle_manager releases element memory on demand") {
+    resource::Paged_handle_manager<Test_handle, int, 4> handles;
+    std::vector<Test_handle> added;
+    for (int i = 0; i != 100; ++i) {
+        added.push_back(handles.add(i));
+    }
+    for (std::size_t i = 0; i != 98; ++i) {
+        handles.remove(added[i]);
+    }
+
+    handles.shrink_to_fit();
+    REQUIRE_EQ(handles.size(), 2);
+    REQUIRE_EQ(handles[added[0]], nullptr);
+    REQUIRE_EQ(*handles[added[98]], 98);
+    REQUIRE_EQ(*handles[added[99]], 99);
+
+    // Entries keep their generations, so stale handles stay invalid
+    REQUIRE_EQ(handles.capacity(), 100);
+    auto reused = handles.add(100);
+    REQUIRE_EQ(handles[added[reused.index()]], nullptr);
+    REQUIRE_EQ(*handles[reused], 100);
+}
+
+TEST_CASE("Paged_handle_manager grows up to the handle index limit") {
+    using Small_handle = resource::Handle<3>;
+    resource::Paged_handle_manager<Small_handle, int, 4> handles;
+    for (int i = 0; i != 8; ++i) {
+        handles.add(i);
+    }
+
+    REQUIRE_EQ(handles.capacity(), 8);
+    REQUIRE_THROWS_AS(handles.add(8), const resource::Resource_error&);
+}
+
+TEST_CASE("Paged_handle_manager with move-only elements") {
+    resource::Paged_handle_manager<Test_handle, std::unique_ptr<int>, 4> handles;
+    auto handle0 = handles.emplace(new int{1});
+    auto handle1 = handles.add(std::make_unique<int>(2));
+
+    handles.remove(handle0);
+    REQUIRE_EQ(handles[handle0], nullptr);
+    REQUIRE_EQ(**handles[handle1], 2);
+
+    **handles[handle1] = 3;
+    REQUIRE_EQ(**handles[handle1], 3);
+}
+
+TEST_CASE("Paged_handle_manager with elements that cannot be assigned") {
+    resource::Paged_handle_manager<Test_handle, Unassignable, 4> handles;
+    auto handle0 = handles.emplace(1);
+    auto handle1 = handles.emplace(2);
+    auto handle2 = handles.emplace(3);
+
+    handles.remove(handle0);
+    REQUIRE_EQ(handles.size(), 2);
+    REQUIRE_EQ(*handles[handle1]->value, 2);
+    REQUIRE_EQ(*handles[handle2]->value, 3);
+}
+
+TEST_CASE("Batched operations of Paged_handle_manager") {
+    resource::Paged_handle_manager<Test_handle, int, 4> handles;
+    const int values[] = {1, 2, 3, 4, 5, 6};
+    Test_handle added[6];
+    handles.add_n(values, 6, added);
+    REQUIRE_EQ(handles.size(), 6);
+    REQUIRE_EQ(handles.capacity(), 8);
+
+    const Test_handle removed[] = {added[1], added[4]};
+    handles.remove_n(removed, 2);
+
+    const int* resolved[6];
+    REQUIRE_EQ(handles.resolve_n(added, 6, resolved), 4);
+    REQUIRE_EQ(*resolved[0], 1);
+    REQUIRE_EQ(resolved[1], nullptr);
+    REQUIRE_EQ(*resolved[5], 6);
+    REQUIRE_THROWS_AS(handles.remove_n(removed, 2),
+                      const resource::Resource_error&);
+
+    const Test_handle repeated[] = {added[2], added[2]};
+    handles.remove_n(repeated, 2);
+    REQUIRE_EQ(handles.size(), 3);
+    const auto first = handles.add(7);
+    const auto second = handles.add(8);
+    REQUIRE_NE(first.index(), second.index());
+    REQUIRE_EQ(*handles[first], 7);
+    REQUIRE_EQ(*handles[second], 8);
+}
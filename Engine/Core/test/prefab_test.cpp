@@ -0,0 +1,94 @@
+#include "bolder/ecs/prefab.hpp"
+#include "bolder/ecs/query.hpp"
+#include "bolder/ecs/world.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+
+namespace {
+struct Position {
+    float x, y;
+};
+
+struct Name {
+    std::string value;
+};
+
+// Throws on the copy after a given number of copies
+struct Fragile {
+    static int copies_left;
+    static int instances;
+
+    Fragile() { ++instances; }
+    Fragile(const Fragile&) {
+        if (copies_left-- == 0) throw std::runtime_error{"Copy"};
+        ++instances;
+    }
+    Fragile(Fragile&&) noexcept { ++instances; }
+    ~Fragile() { --instances; }
+};
+
+int Fragile::copies_left = 0;
+int Fragile::instances = 0;
+} // anonymous namespace
+
+TEST_CASE("ECS Prefab") {
+    ecs::World world;
+    ecs::Prefab prefab {Position{1, 2}, Name{"enemy"}};
+    REQUIRE_EQ(prefab.signature(), ecs::make_signature<Name, Position>());
+    REQUIRE_EQ(prefab.get_component<Name>()->value, "enemy");
+    REQUIRE_EQ(prefab.get_component<Fragile>(), nullptr);
+
+    SUBCASE("Instantiates copies of the prefab") {
+        prefab.get_component<Position>()->x = 10;
+        constexpr ecs::World::size_type count = 5000;
+        const auto entities = world.instantiate(prefab, count);
+        REQUIRE_EQ(entities.size(), count);
+        REQUIRE_EQ(world.size(), count);
+
+        for (auto entity : entities) {
+            REQUIRE(world.alive(entity));
+            REQUIRE_EQ(world.get_component<Position>(entity)->x, 10);
+            REQUIRE_EQ(world.get_component<Position>(entity)->y, 2);
+            REQUIRE_EQ(world.get_component<Name>(entity)->value, "enemy");
+        }
+
+        int visited = 0;
+        ecs::Query<const Position, const Name>{world}.each(
+                    [&visited](const Position&, const Name&) { ++visited; });
+        REQUIRE_EQ(visited, count);
+    }
+
+    SUBCASE("Instances are independent of each other and of the prefab") {
+        const auto entities = world.instantiate(prefab, 2);
+        world.get_component<Name>(entities[0])->value = "boss";
+        REQUIRE_EQ(world.get_component<Name>(entities[1])->value, "enemy");
+        REQUIRE_EQ(prefab.get_component<Name>()->value, "enemy");
+    }
+
+    SUBCASE("A failed copy creates no entity") {
+        const auto existing = world.create_entity(Position{0, 0});
+        const ecs::Prefab fragile {Position{0, 0}, Fragile{}};
+        REQUIRE_EQ(Fragile::instances, 1);
+
+        Fragile::copies_left = 3000;
+        REQUIRE_THROWS_AS(world.instantiate(fragile, 5000),
+                          std::runtime_error);
+        REQUIRE_EQ(Fragile::instances, 1);
+        REQUIRE_EQ(world.size(), 1);
+        REQUIRE(world.alive(existing));
+
+        Fragile::copies_left = 10;
+        const auto entities = world.instantiate(fragile, 10);
+        REQUIRE_EQ(Fragile::instances, 11);
+        REQUIRE_EQ(world.size(), 11);
+        for (auto entity : entities) {
+            REQUIRE(world.has_component<Fragile>(entity));
+        }
+    }
+}
@@ -0,0 +1,252 @@
+#include "bolder/ecs/query.hpp"
+#include "bolder/ecs/scheduler.hpp"
+#include "bolder/ecs/world.hpp"
+#include "bolder/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+
+namespace {
+struct Position {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y;
+};
+
+class Function_system : public ecs::System {
+public:
+    Function_system(const ecs::Access& access, std::function<void()> function)
+        : System{access}, function_{std::move(function)} {}
+
+    void update(ecs::World&, ecs::Command_buffer&, double) override {
+        function_();
+    }
+
+private:
+    std::function<void()> function_;
+};
+} // anonymous namespace
+
+TEST_CASE("Access of ECS systems") {
+    const auto write_position = ecs::make_access<Position>();
+    const auto read_position = ecs::make_access<const Position>();
+    const auto read_both = ecs::make_access<const Position, const Velocity>();
+    const auto write_velocity = ecs::make_access<const Position, Velocity>();
+
+    REQUIRE(write_position.conflicts_with(read_position));
+    REQUIRE(read_position.conflicts_with(write_position));
+    REQUIRE_FALSE(read_position.conflicts_with(read_both));
+    REQUIRE(read_both.conflicts_with(write_velocity));
+    REQUIRE_FALSE(write_position.conflicts_with(ecs::make_access<Velocity>()));
+}
+
+TEST_CASE("ECS Scheduler") {
+    Thread_pool pool {4};
+    ecs::Scheduler scheduler {pool};
+    ecs::World world;
+
+    SUBCASE("Runs conflicting systems in the order they are added") {
+        std::vector<int> order;
+        for (int i = 0; i != 8; ++i) {
+            const auto access = i % 2 == 0 ? ecs::make_access<Position>()
+                                           : ecs::make_access<const Position>();
+            scheduler.emplace_system<Function_system>(
+                        access, [&order, i] { order.push_back(i); });
+        }
+
+        for (int frame = 0; frame != 10; ++frame) {
+            order.clear();
+            scheduler.run(world, 0.01);
+            REQUIRE_EQ(order.size(), 8);
+            for (int i = 0; i != 8; i += 2) {
+                const auto ith = static_cast<std::size_t>(i);
+                REQUIRE_EQ(order[ith], i);
+            }
+        }
+    }
+
+    SUBCASE("Runs systems that do not conflict at the same time") {
+        // Both systems wait until the other one has started
+        std::atomic<int> started {0};
+        std::atomic<bool> overlapped {true};
+        auto rendezvous = [&] {
+            ++started;
+            const auto deadline = std::chrono::steady_clock::now()
+                    + std::chrono::seconds{5};
+            while (started.load() != 2) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    overlapped = false;
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        };
+        scheduler.emplace_system<Function_system>(
+                    ecs::make_access<const Position, Velocity>(), rendezvous);
+        scheduler.emplace_system<Function_system>(
+                    ecs::make_access<const Position>(), rendezvous);
+
+        scheduler.run(world, 0.01);
+        REQUIRE(overlapped.load());
+    }
+
+    SUBCASE("Plays back commands of systems after they finish") {
+        ecs::Command_buffer* recorded = nullptr;
+        class Spawner : public ecs::System {
+        public:
+            explicit Spawner(ecs::Command_buffer*& recorded)
+                : System{ecs::make_access<const Position>()},
+                  recorded_{recorded} {}
+
+            void update(ecs::World& world, ecs::Command_buffer& commands,
+                        double) override {
+                for (int i = 0; i != 100; ++i) {
+                    commands.create_entity(Position{0, 0});
+                }
+                recorded_ = &commands;
+                REQUIRE_EQ(world.size(), 0);
+            }
+
+        private:
+            ecs::Command_buffer*& recorded_;
+        };
+        scheduler.emplace_system<Spawner>(recorded);
+
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(world.size(), 100);
+        REQUIRE(recorded->empty());
+    }
+
+    SUBCASE("Systems see what changed since they last ran") {
+        class Counter : public ecs::System {
+        public:
+            explicit Counter(int& visited)
+                : System{ecs::make_access<const Position>()},
+                  visited_{visited} {}
+
+            void update(ecs::World& world, ecs::Command_buffer&,
+                        double) override {
+                ecs::Query<const Position> query {world};
+                query.changed<Position>().since(last_run()).each(
+                            [this](const Position&) { ++visited_; });
+            }
+
+        private:
+            int& visited_;
+        };
+        int visited = 0;
+        scheduler.emplace_system<Counter>(visited);
+        const auto entity = world.create_entity(Position{0, 0});
+        world.create_entity(Position{0, 0});
+
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 2);
+
+        visited = 0;
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 0);
+
+        world.get_component<Position>(entity)->x = 1;
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 2);
+    }
+
+    SUBCASE("Systems do not see their own changes while others run") {
+        std::atomic<bool> other_started {false};
+        class Mover : public ecs::System {
+        public:
+            Mover(int& visited, std::atomic<bool>& other_started)
+                : System{ecs::make_access<Position>()},
+                  visited_{visited}, other_started_{other_started} {}
+
+            void update(ecs::World& world, ecs::Command_buffer&,
+                        double) override {
+                // Advances the tick of the World while this system runs
+                while (!other_started_.load()) {}
+                ecs::Query<Position> query {world};
+                query.changed<Position>().since(last_run()).each(
+                            [this](Position& position) {
+                    position.x += 1;
+                    ++visited_;
+                });
+            }
+
+        private:
+            int& visited_;
+            std::atomic<bool>& other_started_;
+        };
+        int visited = 0;
+        scheduler.emplace_system<Mover>(visited, other_started);
+        scheduler.emplace_system<Function_system>(
+                    ecs::make_access<Velocity>(),
+                    [&other_started] { other_started = true; });
+        world.create_entity(Position{0, 0});
+
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 1);
+
+        other_started = false;
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 1);
+    }
+
+    SUBCASE("Systems see the entities that their commands created") {
+        class Spawner : public ecs::System {
+        public:
+            explicit Spawner(int& visited)
+                : System{ecs::make_access<const Position>()},
+                  visited_{visited} {}
+
+            void update(ecs::World& world, ecs::Command_buffer& commands,
+                        double) override {
+                ecs::Query<const Position> query {world};
+                query.added<Position>().since(last_run()).each(
+                            [this](const Position&) { ++visited_; });
+                if (!spawned_) {
+                    commands.create_entity(Position{0, 0});
+                    spawned_ = true;
+                }
+            }
+
+        private:
+            int& visited_;
+            bool spawned_ = false;
+        };
+        int visited = 0;
+        scheduler.emplace_system<Spawner>(visited);
+
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 0);
+
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 1);
+
+        scheduler.run(world, 0.01);
+        REQUIRE_EQ(visited, 1);
+    }
+
+    SUBCASE("Rethrows exception of a system after all systems finish") {
+        std::atomic<int> count {0};
+        scheduler.emplace_system<Function_system>(
+                    ecs::make_access<Position>(),
+                    [] { throw std::runtime_error{"system failed"}; });
+        scheduler.emplace_system<Function_system>(
+                    ecs::make_access<Position>(), [&count] { ++count; });
+        scheduler.emplace_system<Function_system>(
+                    ecs::make_access<Velocity>(), [&count] { ++count; });
+
+        REQUIRE_THROWS_AS(scheduler.run(world, 0.01), std::runtime_error);
+        REQUIRE_EQ(count.load(), 2);
+    }
+}
@@ -0,0 +1,75 @@
+#include "bolder/handle.hpp"
+#include "bolder/shared_handle_manager.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+using Test_handle = resource::Handle<12>;
+using Test_manager = resource::Shared_handle_manager<Test_handle, int, 16>;
+
+TEST_CASE("Shared_handle_manager") {
+    Test_manager handles;
+    auto handle = handles.add(42);
+
+    REQUIRE_EQ(handles.size(), 1);
+    REQUIRE_EQ(*handles[handle], 42);
+    REQUIRE_EQ(handles.use_count(handle.get()), 1);
+
+    SUBCASE("Copies share the same element") {
+        auto copy = handle;
+        REQUIRE_EQ(handles.use_count(handle.get()), 2);
+        REQUIRE_EQ(*handles[copy], 42);
+
+        handle.reset();
+        REQUIRE_EQ(handles.collect(), 0);
+        REQUIRE_EQ(*handles[copy], 42);
+    }
+
+    SUBCASE("Destruction is deferred until collect") {
+        const auto plain = handle.get();
+        resource::Weak_handle<Test_manager> weak {handle};
+        handle.reset();
+
+        REQUIRE_EQ(handles.size(), 1);
+        REQUIRE(weak.expired());
+        REQUIRE_FALSE(weak.lock());
+
+        REQUIRE_EQ(handles.collect(), 1);
+        REQUIRE_EQ(handles.size(), 0);
+        REQUIRE_EQ(handles.use_count(plain), 0);
+        REQUIRE_FALSE(weak.lock());
+    }
+
+    SUBCASE("Weak handle can be promoted while the element is alive") {
+        resource::Weak_handle<Test_manager> weak {handle};
+        REQUIRE_FALSE(weak.expired());
+
+        auto locked = weak.lock();
+        REQUIRE(locked);
+        REQUIRE_EQ(handles.use_count(handle.get()), 2);
+        REQUIRE_EQ(*handles[locked], 42);
+    }
+
+    SUBCASE("Handles released from several threads are collected once") {
+        std::vector<Test_manager::strong_handle> copies(64, handle);
+        handle.reset();
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i != 4; ++i) {
+            threads.emplace_back([&copies, i]() {
+                for (auto j = static_cast<size_t>(i); j < copies.size(); j += 4) {
+                    copies[j].reset();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        REQUIRE_EQ(handles.collect(), 1);
+        REQUIRE_EQ(handles.size(), 0);
+    }
+}
@@ -0,0 +1,142 @@
+#include "bolder/ecs/snapshot.hpp"
+#include "bolder/ecs/query.hpp"
+#include "bolder/ecs/world.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+
+// Snapshots identify component types by name, which types of anonymous
+// namespaces in other files can share
+namespace snapshot_test {
+struct Position {
+    float x, y;
+};
+
+struct Health {
+    int value;
+};
+
+// Components can refer to other entities
+struct Target {
+    ecs::Entity entity;
+};
+
+struct Name {
+    std::string value;
+};
+} // namespace snapshot_test
+
+using namespace snapshot_test;
+
+namespace {
+
+// Aligned like the sections of a snapshot that is mapped from a file
+std::unique_ptr<Byte[]> aligned_copy(const std::vector<Byte>& bytes) {
+    std::unique_ptr<Byte[]> copy {new Byte[bytes.size()]};
+    std::copy(bytes.begin(), bytes.end(), copy.get());
+    return copy;
+}
+
+void check_loaded(ecs::World& loaded, const std::vector<ecs::Entity>& entities,
+                  int count) {
+    REQUIRE_EQ(loaded.size(), static_cast<ecs::World::size_type>(count) / 2);
+    for (int i = 0; i != count; ++i) {
+        const auto entity = entities[static_cast<std::size_t>(i)];
+        if (i % 2 == 1) {
+            REQUIRE_FALSE(loaded.alive(entity));
+            continue;
+        }
+
+        REQUIRE(loaded.alive(entity));
+        REQUIRE_EQ(loaded.get_component<Position>(entity)->x,
+                   static_cast<float>(i));
+        if (i % 4 == 0) {
+            REQUIRE_EQ(loaded.get_component<Health>(entity)->value, i);
+            REQUIRE_EQ(loaded.get_component<Target>(entity)->entity,
+                       entities[0]);
+        } else {
+            REQUIRE_FALSE(loaded.has_component<Health>(entity));
+        }
+    }
+}
+} // anonymous namespace
+
+TEST_CASE("ECS World snapshot") {
+    constexpr int count = 3000;
+    ecs::World world;
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i != count; ++i) {
+        const auto x = static_cast<float>(i);
+        entities.push_back(i % 4 == 0
+                ? world.create_entity(Position{x, 0}, Health{i}, Target{})
+                : world.create_entity(Position{x, 0}));
+    }
+    for (int i = 0; i < count; i += 4) {
+        world.get_component<Target>(entities[static_cast<std::size_t>(i)])
+                ->entity = entities[0];
+    }
+    for (int i = 1; i < count; i += 2) {
+        world.destroy_entity(entities[static_cast<std::size_t>(i)]);
+    }
+
+    std::vector<Byte> bytes;
+    ecs::save_snapshot(world, bytes);
+
+    SUBCASE("Round trips through memory") {
+        const auto snapshot = aligned_copy(bytes);
+        ecs::World loaded;
+        ecs::load_snapshot(loaded, snapshot.get(), bytes.size());
+        check_loaded(loaded, entities, count);
+
+        // Destroyed indices are reused with their next generation
+        const auto created = loaded.create_entity(Position{1, 1});
+        REQUIRE_EQ(created, world.create_entity(Position{1, 1}));
+
+        int visited = 0;
+        ecs::Query<const Position, const Health>{loaded}.each(
+                    [&visited](const Position&, const Health&) { ++visited; });
+        REQUIRE_EQ(visited, count / 4);
+    }
+
+    SUBCASE("Round trips through a mapped file") {
+        const auto filename = "world_snapshot_test.bin";
+        ecs::save_snapshot(world, filename);
+        ecs::World loaded;
+        ecs::load_snapshot(loaded, filename);
+        std::remove(filename);
+        check_loaded(loaded, entities, count);
+    }
+
+    SUBCASE("Only loads into a world that never had entities") {
+        const auto snapshot = aligned_copy(bytes);
+        REQUIRE_THROWS_AS(ecs::load_snapshot(world, snapshot.get(),
+                                             bytes.size()),
+                          Runtime_error);
+    }
+
+    SUBCASE("Rejects invalid snapshots") {
+        auto snapshot = aligned_copy(bytes);
+        ecs::World loaded;
+        REQUIRE_THROWS_AS(ecs::load_snapshot(loaded, snapshot.get(), 16),
+                          Runtime_error);
+
+        snapshot[0] = 0;
+        REQUIRE_THROWS_AS(ecs::load_snapshot(loaded, snapshot.get(),
+                                             bytes.size()),
+                          Runtime_error);
+        REQUIRE_EQ(loaded.size(), 0);
+    }
+
+    SUBCASE("Components must be trivially copyable") {
+        world.create_entity(Name{"player"});
+        bytes.clear();
+        REQUIRE_THROWS_AS(ecs::save_snapshot(world, bytes), Runtime_error);
+    }
+}
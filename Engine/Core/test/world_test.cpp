@@ -0,0 +1,461 @@
+#include "bolder/ecs/world.hpp"
+#include "bolder/ecs/command_buffer.hpp"
+#include "bolder/ecs/prefab.hpp"
+#include "bolder/ecs/query.hpp"
+#include "bolder/thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+
+namespace {
+struct Position {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y;
+};
+
+// Counts live instances to check that components are destroyed
+struct Tracked {
+    static int instances;
+
+    explicit Tracked(int v) : value{v} { ++instances; }
+    Tracked(const Tracked& other) : value{other.value} { ++instances; }
+    Tracked(Tracked&& other) noexcept : value{other.value} { ++instances; }
+    ~Tracked() { --instances; }
+
+    int value;
+};
+
+int Tracked::instances = 0;
+
+struct Enemy {};
+
+struct Material {
+    uint32 texture;
+};
+} // anonymous namespace
+
+namespace bolder { namespace ecs {
+template<> struct is_shared_component<Material> : std::true_type {};
+}} // namespace bolder::ecs
+
+TEST_CASE("Components of ECS World") {
+    ecs::World world;
+    auto entity0 = world.create_entity(Position{1, 2});
+    auto entity1 = world.create_entity(Position{3, 4}, Velocity{1, 0});
+
+    SUBCASE("Gets components") {
+        REQUIRE_EQ(world.get_component<Position>(entity0)->x, 1);
+        REQUIRE_EQ(world.get_component<Position>(entity1)->y, 4);
+        REQUIRE_EQ(world.get_component<Velocity>(entity0), nullptr);
+        REQUIRE(world.has_component<Velocity>(entity1));
+        REQUIRE_EQ(world.archetypes().size(), 3);
+    }
+
+    SUBCASE("Adds a component and keeps the others") {
+        world.add_component(entity0, Velocity{5, 6});
+        REQUIRE_EQ(world.get_component<Position>(entity0)->y, 2);
+        REQUIRE_EQ(world.get_component<Velocity>(entity0)->x, 5);
+        REQUIRE_EQ(world.get_component<Position>(entity1)->x, 3);
+        REQUIRE_THROWS_AS(world.add_component(entity0, Velocity{}),
+                          Runtime_error);
+    }
+
+    SUBCASE("Removes a component and keeps the others") {
+        world.remove_component<Velocity>(entity1);
+        REQUIRE_FALSE(world.has_component<Velocity>(entity1));
+        REQUIRE_EQ(world.get_component<Position>(entity1)->x, 3);
+        REQUIRE_THROWS_AS(world.remove_component<Velocity>(entity1),
+                          Runtime_error);
+    }
+
+    SUBCASE("No component for destroyed entity") {
+        world.destroy_entity(entity0);
+        REQUIRE_EQ(world.get_component<Position>(entity0), nullptr);
+        REQUIRE_THROWS_AS(world.add_component(entity0, Velocity{}),
+                          Runtime_error);
+    }
+}
+
+TEST_CASE("ECS World destroys non-trivial components") {
+    {
+        ecs::World world;
+        std::vector<ecs::Entity> entities;
+        for (int i = 0; i != 10; ++i) {
+            entities.push_back(world.create_entity(Tracked{i}));
+        }
+        REQUIRE_EQ(Tracked::instances, 10);
+
+        world.destroy_entity(entities[2]);
+        REQUIRE_EQ(Tracked::instances, 9);
+        REQUIRE_EQ(world.get_component<Tracked>(entities[9])->value, 9);
+
+        world.add_component(entities[3], Position{});
+        REQUIRE_EQ(Tracked::instances, 9);
+        REQUIRE_EQ(world.get_component<Tracked>(entities[3])->value, 3);
+
+        world.remove_component<Tracked>(entities[4]);
+        REQUIRE_EQ(Tracked::instances, 8);
+    }
+    REQUIRE_EQ(Tracked::instances, 0);
+}
+
+TEST_CASE("ECS Query") {
+    ecs::World world;
+    constexpr int count = 5000;
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i != count; ++i) {
+        const auto x = static_cast<float>(i);
+        entities.push_back(i % 2 == 0
+                           ? world.create_entity(Position{x, 0}, Velocity{1, 2})
+                           : world.create_entity(Position{x, 0}));
+    }
+
+    SUBCASE("Visits only matching entities") {
+        ecs::Query<Position, const Velocity> query {world};
+        int visited = 0;
+        query.each([&visited](Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            ++visited;
+        });
+        REQUIRE_EQ(visited, count / 2);
+        REQUIRE_EQ(world.get_component<Position>(entities[10])->x, 11);
+        REQUIRE_EQ(world.get_component<Position>(entities[11])->x, 11);
+    }
+
+    SUBCASE("Visits contiguous columns of chunks") {
+        ecs::Query<const Position> query {world};
+        int chunks = 0;
+        int visited = 0;
+        query.each_chunk([&](const ecs::Query<const Position>::chunk_view& view) {
+            ++chunks;
+            const auto* positions = view.column<const Position>();
+            for (auto i = 0u; i != view.size(); ++i) {
+                const auto* position =
+                        world.get_component<Position>(view.entities()[i]);
+                REQUIRE_EQ(position, positions + i);
+            }
+            visited += static_cast<int>(view.size());
+        });
+        REQUIRE_EQ(visited, count);
+        REQUIRE_GT(chunks, 2);
+    }
+
+    SUBCASE("Destroyed entities are not visited") {
+        for (int i = 0; i < count; i += 3) {
+            world.destroy_entity(entities[static_cast<std::size_t>(i)]);
+        }
+        int visited = 0;
+        ecs::Query<Position>{world}.each([&visited](Position&) { ++visited; });
+        REQUIRE_EQ(visited, count - (count + 2) / 3);
+        REQUIRE_EQ(world.size(), visited);
+    }
+
+    SUBCASE("Parallel iteration visits every matching entity once") {
+        Thread_pool pool {4};
+        ecs::Query<Position, const Velocity> query {world};
+        query.par_each(pool, [](Position& position, const Velocity& velocity) {
+            position.y += velocity.y;
+        });
+
+        // Counts the entities that were updated as expected
+        const auto counts = ecs::Query<const Position>{world}.par_each(
+                    pool, 0, [](int& visited, const Position& position) {
+            const auto even = static_cast<int>(position.x) % 2 == 0;
+            if (position.y == (even ? 2.f : 0.f)) ++visited;
+        });
+        REQUIRE_EQ(counts.size(), pool.size() + 1);
+        int visited = 0;
+        for (auto count : counts) visited += count;
+        REQUIRE_EQ(visited, count);
+
+        // Threads write their own bool, which std::vector<bool> would pack
+        const auto seen = ecs::Query<const Position>{world}.par_each(
+                    pool, false, [](bool& any, const Position&) { any = true; });
+        REQUIRE_EQ(seen.size(), pool.size() + 1);
+        REQUIRE(std::find(seen.begin(), seen.end(), true) != seen.end());
+    }
+
+    SUBCASE("Queries share the cache of a signature") {
+        const auto& cache = world.query_cache(ecs::make_signature<Position>());
+        REQUIRE_EQ(&world.query_cache(ecs::make_signature<Position>()), &cache);
+        REQUIRE_EQ(cache.archetypes().size(), 2);
+        REQUIRE_EQ(world.query_cache(ecs::make_signature<Velocity>())
+                   .archetypes().size(), 1);
+    }
+
+    SUBCASE("Persistent query visits archetypes created after it") {
+        ecs::Query<const Position> query {world};
+        world.add_component(entities[1], Tracked{1});
+        world.create_entity(Velocity{0, 0});
+
+        int visited = 0;
+        query.each([&visited](const Position&) { ++visited; });
+        REQUIRE_EQ(visited, count);
+        REQUIRE_EQ(world.query_cache(ecs::make_signature<Position>())
+                   .archetypes().size(), 3);
+    }
+}
+
+TEST_CASE("ECS change tracking") {
+    ecs::World world;
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i != 3000; ++i) {
+        entities.push_back(world.create_entity(Position{0, 0}, Velocity{1, 1}));
+    }
+
+    auto count_chunks = [&world](uint32 since, bool added) {
+        ecs::Query<const Position> query {world};
+        if (added) {
+            query.added<Position>();
+        } else {
+            query.changed<Position>();
+        }
+        int chunks = 0;
+        query.since(since).each_chunk(
+                    [&chunks](const ecs::Query<const Position>::chunk_view&) {
+            ++chunks;
+        });
+        return chunks;
+    };
+
+    const auto all_chunks = count_chunks(0, false);
+    REQUIRE_GT(all_chunks, 1);
+    REQUIRE_EQ(count_chunks(0, true), all_chunks);
+
+    const auto since = world.change_tick();
+    world.increment_change_tick();
+
+    SUBCASE("Skips unchanged chunks") {
+        REQUIRE_EQ(count_chunks(since, false), 0);
+        REQUIRE_EQ(count_chunks(since, true), 0);
+    }
+
+    SUBCASE("Reading does not count as change") {
+        ecs::Query<const Position, const Velocity>{world}.each(
+                    [](const Position&, const Velocity&) {});
+        static_cast<const ecs::World&>(world).get_component<Position>(
+                    entities[0]);
+        REQUIRE_EQ(count_chunks(since, false), 0);
+    }
+
+    SUBCASE("Writing a component marks its chunk") {
+        world.get_component<Position>(entities[0])->x = 1;
+        REQUIRE_EQ(count_chunks(since, false), 1);
+        REQUIRE_EQ(count_chunks(since, true), 0);
+
+        ecs::Query<Velocity>{world}.each([](Velocity&) {});
+        REQUIRE_EQ(count_chunks(since, false), 1);
+    }
+
+    SUBCASE("Writing query marks the chunks it visits") {
+        ecs::Query<Position>{world}.each([](Position&) {});
+        REQUIRE_EQ(count_chunks(since, false), all_chunks);
+    }
+
+    SUBCASE("Adding rows marks the chunk as added") {
+        world.create_entity(Position{0, 0}, Velocity{1, 1});
+        REQUIRE_EQ(count_chunks(since, true), 1);
+        REQUIRE_EQ(count_chunks(since, false), 1);
+    }
+}
+
+TEST_CASE("ECS World compaction") {
+    ecs::World world;
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i != 3000; ++i) {
+        const auto x = static_cast<float>(i);
+        entities.push_back(i % 2 == 0
+                ? world.create_entity(Position{x, 0}, Tracked{i})
+                : world.create_entity(Position{x, 0}));
+    }
+    for (int i = 0; i != 3000; ++i) {
+        if (i % 3 != 0) {
+            world.destroy_entity(entities[static_cast<std::size_t>(i)]);
+        }
+    }
+
+    auto chunk_count = [&world]() {
+        std::size_t count = 0;
+        for (const auto& archetype : world.archetypes()) {
+            count += archetype->chunk_count();
+        }
+        return count;
+    };
+    const auto fragmented = chunk_count();
+
+    SUBCASE("Frees chunks and keeps every entity") {
+        REQUIRE(world.compact(std::chrono::seconds{10}));
+        REQUIRE_LT(chunk_count(), fragmented);
+        for (const auto& archetype : world.archetypes()) {
+            for (auto i = 0u; i + 1 < archetype->chunk_count(); ++i) {
+                REQUIRE_EQ(archetype->chunk(i).size(),
+                           archetype->chunk_capacity());
+            }
+        }
+
+        REQUIRE_EQ(world.size(), 1000);
+        REQUIRE_EQ(Tracked::instances, 500);
+        for (int i = 0; i < 3000; i += 3) {
+            const auto entity = entities[static_cast<std::size_t>(i)];
+            REQUIRE_EQ(world.get_component<Position>(entity)->x,
+                       static_cast<float>(i));
+            if (i % 2 == 0) {
+                REQUIRE_EQ(world.get_component<Tracked>(entity)->value, i);
+            }
+        }
+        REQUIRE(world.compact(std::chrono::seconds{0}));
+    }
+
+    SUBCASE("Resumes within a budget") {
+        REQUIRE_FALSE(world.compact(std::chrono::seconds{0}));
+        while (!world.compact(std::chrono::seconds{0})) {}
+        REQUIRE_LT(chunk_count(), fragmented);
+        REQUIRE_EQ(world.size(), 1000);
+    }
+
+    SUBCASE("Moved rows keep their changes") {
+        const auto since = world.change_tick();
+        world.increment_change_tick();
+        world.get_component<Position>(entities[2997])->x = -1;
+        REQUIRE(world.compact(std::chrono::seconds{10}));
+
+        int changed = 0;
+        ecs::Query<const Position>{world}.changed<Position>().since(since).each(
+                    [&changed](const Position& position) {
+            if (position.x == -1) ++changed;
+        });
+        REQUIRE_EQ(changed, 1);
+    }
+}
+
+TEST_CASE("ECS tag components") {
+    ecs::World world;
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i != 3000; ++i) {
+        const auto x = static_cast<float>(i);
+        entities.push_back(i % 2 == 0
+                ? world.create_entity(Position{x, 0}, Enemy{})
+                : world.create_entity(Position{x, 0}));
+    }
+
+    const auto& archetypes =
+            world.query_cache(ecs::make_signature<Enemy>()).archetypes();
+    REQUIRE_EQ(archetypes.size(), 1);
+    const auto& archetype = *archetypes.front();
+    REQUIRE_EQ(archetype.column_stride(
+                   archetype.column_index(ecs::component_id<Enemy>())), 0);
+
+    SUBCASE("Tags take no memory in chunks") {
+        // Except for the scratch slot that all the tags of a chunk share
+        ecs::Archetype without_tag {ecs::make_signature<Position>()};
+        REQUIRE_GE(archetype.chunk_capacity() + 2,
+                   without_tag.chunk_capacity());
+    }
+
+    SUBCASE("Queries filter by tags") {
+        int visited = 0;
+        ecs::Query<const Position>{world}.with<Enemy>().each(
+                    [&visited](const Position& position) {
+            REQUIRE_EQ(static_cast<int>(position.x) % 2, 0);
+            ++visited;
+        });
+        REQUIRE_EQ(visited, 1500);
+    }
+
+    SUBCASE("Adds and removes tags") {
+        world.add_component(entities[1], Enemy{});
+        REQUIRE(world.has_component<Enemy>(entities[1]));
+        REQUIRE_EQ(world.get_component<Position>(entities[1])->x, 1);
+
+        world.remove_component<Enemy>(entities[0]);
+        REQUIRE_FALSE(world.has_component<Enemy>(entities[0]));
+        REQUIRE_EQ(world.get_component<Position>(entities[0])->x, 0);
+    }
+}
+
+TEST_CASE("ECS shared components") {
+    ecs::World world;
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i != 3000; ++i) {
+        const auto x = static_cast<float>(i);
+        entities.push_back(world.create_entity(
+                Position{x, 0}, Material{static_cast<uint32>(i % 3)}));
+    }
+
+    // Maps every texture to its number of entities, checking that every chunk
+    // only has the entities of its texture
+    auto count_textures = [&world]() {
+        std::vector<int> counts(4);
+        ecs::Query<const Position> query {world};
+        query.with<Material>().each_chunk([&counts](
+                const ecs::Query<const Position>::chunk_view& view) {
+            const auto texture = view.shared<Material>().texture;
+            for (auto row = 0u; row != view.size(); ++row) {
+                REQUIRE_EQ(static_cast<uint32>(view.column<const Position>()
+                                               [row].x) % 3, texture % 3);
+            }
+            counts[texture] += static_cast<int>(view.size());
+        });
+        return counts;
+    };
+
+    SUBCASE("Splits chunks by value") {
+        REQUIRE_EQ(count_textures(), std::vector<int>{1000, 1000, 1000, 0});
+        REQUIRE_EQ(world.get_component<Material>(entities[4])->texture, 1);
+    }
+
+    SUBCASE("Setting a shared component moves the entity") {
+        world.set_shared_component(entities[3], Material{1});
+        world.get_component<Position>(entities[3])->x = 1;
+        REQUIRE_EQ(count_textures(), std::vector<int>{999, 1001, 1000, 0});
+        REQUIRE_EQ(world.get_component<Material>(entities[3])->texture, 1);
+        REQUIRE_EQ(world.get_component<Position>(entities[6])->x, 6);
+    }
+
+    SUBCASE("Writing a shared component changes its chunk") {
+        const auto* material = world.get_component<Material>(entities[0]);
+        world.get_component<Material>(entities[0])->texture = 3;
+        REQUIRE_EQ(material->texture, 3);
+        REQUIRE_EQ(world.get_component<Material>(entities[3])->texture, 3);
+    }
+
+    SUBCASE("Adds and removes shared components") {
+        const auto entity = world.create_entity(Position{2, 0});
+        world.add_component(entity, Material{2});
+        REQUIRE_EQ(count_textures(), std::vector<int>{1000, 1000, 1001, 0});
+
+        world.remove_component<Material>(entity);
+        REQUIRE_FALSE(world.has_component<Material>(entity));
+        REQUIRE_EQ(count_textures(), std::vector<int>{1000, 1000, 1000, 0});
+    }
+
+    SUBCASE("Command buffers and prefabs use the chunks of their values") {
+        ecs::Command_buffer commands;
+        commands.create_entity(Position{3, 0}, Material{3});
+        commands.create_entity(Position{1, 0}, Material{1});
+        commands.set_component(entities[0], Material{3});
+        commands.playback(world);
+        world.instantiate(ecs::Prefab{Position{3, 0}, Material{3}}, 10);
+        REQUIRE_EQ(count_textures(), std::vector<int>{999, 1001, 1000, 12});
+    }
+
+    SUBCASE("Compaction keeps chunks of different values apart") {
+        for (int i = 0; i != 3000; ++i) {
+            if (i % 5 != 0) {
+                world.destroy_entity(entities[static_cast<std::size_t>(i)]);
+            }
+        }
+        REQUIRE(world.compact(std::chrono::seconds{10}));
+        REQUIRE_EQ(count_textures(), std::vector<int>{200, 200, 200, 0});
+    }
+}
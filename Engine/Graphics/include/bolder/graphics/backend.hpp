@@ -21,6 +21,9 @@ void clear();
 
 void render(const Context& context, Draw_call draw_call);
 
+/// Render count draw calls, resolving their handles in batches
+void render(const Context& context, const Draw_call* draw_calls, uint32 count);
+
 /// Sets the viewport
 void set_view_port(int x, int y, int width, int height);
 
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "bolder/affine.hpp"
+#include "bolder/angle.hpp"
+#include "bolder/integer.hpp"
+#include "bolder/vector.hpp"
+
+namespace bolder { namespace graphics {
+
+/// Position, scale and rotation of a node relative to its parent
+struct Transform2 {
+    math::Vec2 position {0, 0};
+    math::Vec2 scale {1, 1};
+    math::Radian rotation;
+};
+
+/**
+ * @brief A forest of 2D transforms that computes the world transform of every
+ * node from its parents.
+ *
+ * The nodes are stored in flat arrays sorted in depth-first order, so that
+ * every parent comes before its children and the descendants of a node are the
+ * contiguous range after it. update() computes the world transforms in one
+ * linear pass that skips clean nodes and recomputes a changed node together
+ * with its whole subtree, composing the cached local matrices with SIMD.
+ *
+ * Nodes are identified by ids that stay valid until they are removed, while
+ * their positions in the arrays change. Structural changes only mark the order
+ * as stale; it is sorted again once, at the next update() or remove().
+ *
+ * A hierarchy can be a component of an entity, such as the rig of a sprite
+ * that is made of several parts.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Transform_hierarchy hierarchy;
+ * auto body = hierarchy.add(Transform2{{100, 100}, {1, 1}, {}});
+ * auto arm = hierarchy.add(Transform2{{10, 0}, {1, 1}, {}}, body);
+ * hierarchy.update();
+ * draw(arm_sprite, hierarchy.world(arm).to_mat4());
+ * @endcode
+ */
+class Transform_hierarchy {
+public:
+    using Node_id = uint32;
+
+    /// The parent of the root nodes
+    static constexpr Node_id no_parent = ~0u;
+
+    Transform_hierarchy();
+    ~Transform_hierarchy();
+
+    Transform_hierarchy(Transform_hierarchy&&) = default;
+    Transform_hierarchy& operator=(Transform_hierarchy&&) = default;
+
+    /// Returns the number of nodes
+    std::size_t size() const {
+        return ids_.size();
+    }
+
+    /// Whether a node id refers to an existing node
+    bool contains(Node_id node) const {
+        return node < positions_.size() && positions_[node] != npos;
+    }
+
+    /**
+     * @brief Adds a node as the last child of parent, or as a root node.
+     * @throw Runtime_error if parent is not a node of the hierarchy
+     */
+    Node_id add(const Transform2& local, Node_id parent = no_parent);
+
+    /**
+     * @brief Removes a node together with all of its descendants.
+     * @throw Runtime_error if node is not a node of the hierarchy
+     */
+    void remove(Node_id node);
+
+    /// Returns the parent of a node, or no_parent for a root node
+    Node_id parent(Node_id node) const;
+
+    /**
+     * @brief Moves a node with its subtree under another parent.
+     * @throw Runtime_error if either node is not a node of the hierarchy, or if
+     * parent is in the subtree of node
+     */
+    void set_parent(Node_id node, Node_id parent);
+
+    /// Returns the transform of a node relative to its parent
+    const Transform2& local(Node_id node) const;
+
+    /// Sets the transform of a node relative to its parent
+    void set_local(Node_id node, const Transform2& local);
+
+    /**
+     * @brief Returns the transform of a node relative to the world.
+     * @note It is only up to date after update().
+     */
+    const math::Affine2& world(Node_id node) const;
+
+    /// Computes the world transforms of every node that changed since the
+    /// previous update, and of their descendants
+    void update();
+
+private:
+    static constexpr uint32 npos = ~0u;
+
+    // Per id; the position of a node in the arrays below, or npos
+    std::vector<uint32> positions_;
+    std::vector<Node_id> free_ids_;
+
+    // Per position, in depth-first order when order_stale_ is false
+    std::vector<Node_id> ids_;
+    std::vector<uint32> parents_; ///< Positions of the parents, or npos
+    std::vector<uint32> subtree_sizes_; ///< Only valid in depth-first order
+    std::vector<Transform2> locals_;
+    std::vector<math::Affine2> local_matrices_;
+    std::vector<math::Affine2> worlds_;
+    std::vector<uint8> dirty_;
+
+    bool order_stale_ = false;
+
+    uint32 checked_position(Node_id node) const;
+    void sort();
+
+    template<typename T>
+    static void permute(std::vector<T>& values,
+                        const std::vector<uint32>& order);
+};
+
+}} // namespace bolder::graphics
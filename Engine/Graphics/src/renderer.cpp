@@ -1,4 +1,4 @@
-#include <queue>
+#include <vector>
 
 #include "renderer.hpp"
 #include "backend.hpp"
@@ -22,7 +22,7 @@ public:
 struct Renderer::Impl {
     event::Handler_raii<Window_resize_handler> window_resize_handler;
     backend::Context* context;
-    std::queue<Draw_call> draw_calls;
+    std::vector<Draw_call> draw_calls;
 
     Index_buffer_handle rect_ibo;
     Texture_handle texture;
@@ -59,13 +59,12 @@ struct Renderer::Impl {
     }
 
     void render() {
-        draw_calls.push(Draw_call{rect_ibo, texture});
+        draw_calls.push_back(Draw_call{rect_ibo, texture});
 
         backend::clear();
-        while (!draw_calls.empty()) {
-            backend::render(*context, draw_calls.front());
-            draw_calls.pop();
-        }
+        backend::render(*context, draw_calls.data(),
+                        static_cast<uint32>(draw_calls.size()));
+        draw_calls.clear();
 
     }
 };
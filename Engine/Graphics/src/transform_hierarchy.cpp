@@ -0,0 +1,249 @@
+#include "transform_hierarchy.hpp"
+
+#include "bolder/exception.hpp"
+
+namespace bolder { namespace graphics {
+
+constexpr Transform_hierarchy::Node_id Transform_hierarchy::no_parent;
+constexpr uint32 Transform_hierarchy::npos;
+
+Transform_hierarchy::Transform_hierarchy() = default;
+
+Transform_hierarchy::~Transform_hierarchy() = default;
+
+Transform_hierarchy::Node_id Transform_hierarchy::add(const Transform2& local,
+                                                      Node_id parent)
+{
+    const auto parent_position = parent == no_parent ? npos
+                                                     : checked_position(parent);
+    const auto position = static_cast<uint32>(ids_.size());
+
+    Node_id id;
+    if (free_ids_.empty()) {
+        id = static_cast<Node_id>(positions_.size());
+        positions_.push_back(position);
+    } else {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+        positions_[id] = position;
+    }
+
+    ids_.push_back(id);
+    parents_.push_back(parent_position);
+    subtree_sizes_.push_back(1);
+    locals_.push_back(local);
+    local_matrices_.push_back(math::Affine2::from_trs(local.position,
+                                                      local.rotation,
+                                                      local.scale));
+    worlds_.emplace_back();
+    dirty_.push_back(1);
+
+    // Appending stays in depth-first order if the subtree of the parent ends
+    // at the back, which is the case when a hierarchy is built top down
+    if (parent_position != npos && !order_stale_) {
+        if (parent_position + subtree_sizes_[parent_position] == position) {
+            for (auto p = parent_position; p != npos; p = parents_[p]) {
+                ++subtree_sizes_[p];
+            }
+        } else {
+            order_stale_ = true;
+        }
+    }
+    return id;
+}
+
+void Transform_hierarchy::remove(Node_id node)
+{
+    checked_position(node);
+    if (order_stale_) sort();
+
+    const auto position = positions_[node];
+    const auto count = subtree_sizes_[position];
+    const auto last = position + count;
+    for (auto p = parents_[position]; p != npos; p = parents_[p]) {
+        subtree_sizes_[p] -= count;
+    }
+    for (auto i = position; i != last; ++i) {
+        positions_[ids_[i]] = npos;
+        free_ids_.push_back(ids_[i]);
+    }
+
+    const auto erase = [position, last](auto& values) {
+        values.erase(values.begin() + position, values.begin() + last);
+    };
+    erase(ids_);
+    erase(parents_);
+    erase(subtree_sizes_);
+    erase(locals_);
+    erase(local_matrices_);
+    erase(worlds_);
+    erase(dirty_);
+
+    for (auto i = position; i != ids_.size(); ++i) {
+        positions_[ids_[i]] = i;
+        if (parents_[i] != npos && parents_[i] >= last) {
+            parents_[i] -= count;
+        }
+    }
+}
+
+Transform_hierarchy::Node_id Transform_hierarchy::parent(Node_id node) const
+{
+    const auto parent = parents_[checked_position(node)];
+    return parent == npos ? no_parent : ids_[parent];
+}
+
+void Transform_hierarchy::set_parent(Node_id node, Node_id parent)
+{
+    checked_position(node);
+    if (parent != no_parent) checked_position(parent);
+    if (order_stale_) sort();
+
+    const auto position = positions_[node];
+    auto parent_position = npos;
+    if (parent != no_parent) {
+        parent_position = positions_[parent];
+        if (parent_position >= position
+                && parent_position < position + subtree_sizes_[position]) {
+            throw Runtime_error {"Parent a node to its own subtree"};
+        }
+    }
+
+    parents_[position] = parent_position;
+    dirty_[position] = 1;
+    order_stale_ = true;
+}
+
+const Transform2& Transform_hierarchy::local(Node_id node) const
+{
+    return locals_[checked_position(node)];
+}
+
+void Transform_hierarchy::set_local(Node_id node, const Transform2& local)
+{
+    const auto position = checked_position(node);
+    locals_[position] = local;
+    local_matrices_[position] = math::Affine2::from_trs(local.position,
+                                                        local.rotation,
+                                                        local.scale);
+    dirty_[position] = 1;
+}
+
+const math::Affine2& Transform_hierarchy::world(Node_id node) const
+{
+    return worlds_[checked_position(node)];
+}
+
+void Transform_hierarchy::update()
+{
+    if (order_stale_) sort();
+
+    // A parent always comes before its children, so its world transform is
+    // already computed when they are reached
+    const auto count = static_cast<uint32>(ids_.size());
+    for (auto i = 0u; i != count;) {
+        if (!dirty_[i]) {
+            ++i;
+            continue;
+        }
+
+        const auto last = i + subtree_sizes_[i];
+        for (auto j = i; j != last; ++j) {
+            const auto parent = parents_[j];
+            worlds_[j] = parent == npos ? local_matrices_[j]
+                                        : worlds_[parent] * local_matrices_[j];
+            dirty_[j] = 0;
+        }
+        i = last;
+    }
+}
+
+uint32 Transform_hierarchy::checked_position(Node_id node) const
+{
+    if (!contains(node)) {
+        throw Runtime_error {"Use a node that is not in the hierarchy"};
+    }
+    return positions_[node];
+}
+
+// Sorts the nodes in depth-first order, keeping siblings in their current order
+void Transform_hierarchy::sort()
+{
+    const auto count = static_cast<uint32>(ids_.size());
+
+    // Children of every node, as ranges of one array
+    std::vector<uint32> offsets(count + 1, 0);
+    std::vector<uint32> roots;
+    for (auto i = 0u; i != count; ++i) {
+        if (parents_[i] == npos) {
+            roots.push_back(i);
+        } else {
+            ++offsets[parents_[i] + 1];
+        }
+    }
+    for (auto i = 0u; i != count; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32> children(count);
+    std::vector<uint32> cursors(offsets.begin(), offsets.end() - 1);
+    for (auto i = 0u; i != count; ++i) {
+        if (parents_[i] != npos) {
+            children[cursors[parents_[i]]++] = i;
+        }
+    }
+
+    std::vector<uint32> order;
+    order.reserve(count);
+    std::vector<uint32> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty()) {
+        const auto i = stack.back();
+        stack.pop_back();
+        order.push_back(i);
+        for (auto child = offsets[i + 1]; child != offsets[i]; --child) {
+            stack.push_back(children[child - 1]);
+        }
+    }
+
+    std::vector<uint32> new_positions(count);
+    for (auto i = 0u; i != count; ++i) {
+        new_positions[order[i]] = i;
+    }
+    std::vector<uint32> parents(count);
+    for (auto i = 0u; i != count; ++i) {
+        const auto parent = parents_[order[i]];
+        parents[i] = parent == npos ? npos : new_positions[parent];
+    }
+    parents_.swap(parents);
+
+    permute(ids_, order);
+    permute(locals_, order);
+    permute(local_matrices_, order);
+    permute(worlds_, order);
+    permute(dirty_, order);
+
+    for (auto i = 0u; i != count; ++i) {
+        positions_[ids_[i]] = i;
+    }
+
+    subtree_sizes_.assign(count, 1);
+    for (auto i = count; i != 0; --i) {
+        const auto parent = parents_[i - 1];
+        if (parent != npos) subtree_sizes_[parent] += subtree_sizes_[i - 1];
+    }
+
+    order_stale_ = false;
+}
+
+template<typename T>
+void Transform_hierarchy::permute(std::vector<T>& values,
+                                  const std::vector<uint32>& order)
+{
+    std::vector<T> result;
+    result.reserve(values.size());
+    for (auto i : order) {
+        result.push_back(values[i]);
+    }
+    values.swap(result);
+}
+
+}} // namespace bolder::graphics
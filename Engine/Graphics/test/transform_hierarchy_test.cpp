@@ -0,0 +1,123 @@
+#include <vector>
+#include "doctest.h"
+
+#include "bolder/exception.hpp"
+#include "bolder/graphics/transform_hierarchy.hpp"
+
+using namespace bolder;
+using namespace bolder::graphics;
+using bolder::math::Vec2;
+
+namespace {
+Transform2 translation(float x, float y) {
+    Transform2 transform;
+    transform.position = Vec2{x, y};
+    return transform;
+}
+
+Vec2 world_position(const Transform_hierarchy& hierarchy,
+                    Transform_hierarchy::Node_id node) {
+    return hierarchy.world(node).translation();
+}
+} // anonymous namespace
+
+TEST_CASE("Transform hierarchy") {
+    Transform_hierarchy hierarchy;
+    const auto root = hierarchy.add(translation(100, 0));
+    const auto child = hierarchy.add(translation(10, 0), root);
+    const auto grandchild = hierarchy.add(translation(1, 0), child);
+    const auto other_root = hierarchy.add(translation(0, 100));
+    hierarchy.update();
+
+    REQUIRE_EQ(hierarchy.size(), 4);
+    REQUIRE_EQ(hierarchy.parent(grandchild), child);
+    REQUIRE_EQ(hierarchy.parent(root), Transform_hierarchy::no_parent);
+
+    SUBCASE("World transforms compose the transforms of the ancestors") {
+        REQUIRE_EQ(world_position(hierarchy, root), Vec2{100, 0});
+        REQUIRE_EQ(world_position(hierarchy, child), Vec2{110, 0});
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{111, 0});
+        REQUIRE_EQ(world_position(hierarchy, other_root), Vec2{0, 100});
+    }
+
+    SUBCASE("Changing a node updates its subtree") {
+        auto transform = translation(10, 0);
+        transform.scale = Vec2{2, 2};
+        hierarchy.set_local(child, transform);
+        hierarchy.update();
+
+        REQUIRE_EQ(world_position(hierarchy, root), Vec2{100, 0});
+        REQUIRE_EQ(world_position(hierarchy, child), Vec2{110, 0});
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{112, 0});
+        REQUIRE_EQ(hierarchy.local(child).scale, Vec2{2, 2});
+    }
+
+    SUBCASE("World transforms are only updated by update()") {
+        hierarchy.set_local(root, translation(200, 0));
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{111, 0});
+        hierarchy.update();
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{211, 0});
+    }
+
+    SUBCASE("Add children after other nodes") {
+        const auto late_child = hierarchy.add(translation(0, 5), root);
+        const auto late_grandchild = hierarchy.add(translation(0, 5),
+                                                   late_child);
+        hierarchy.update();
+
+        REQUIRE_EQ(world_position(hierarchy, late_grandchild), Vec2{100, 10});
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{111, 0});
+        REQUIRE_EQ(world_position(hierarchy, other_root), Vec2{0, 100});
+    }
+
+    SUBCASE("Reparent a subtree") {
+        hierarchy.set_parent(child, other_root);
+        hierarchy.update();
+
+        REQUIRE_EQ(hierarchy.parent(child), other_root);
+        REQUIRE_EQ(world_position(hierarchy, child), Vec2{10, 100});
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{11, 100});
+
+        hierarchy.set_parent(child, Transform_hierarchy::no_parent);
+        hierarchy.update();
+        REQUIRE_EQ(world_position(hierarchy, grandchild), Vec2{11, 0});
+    }
+
+    SUBCASE("Cannot parent a node to its own subtree") {
+        REQUIRE_THROWS_AS(hierarchy.set_parent(root, grandchild),
+                          Runtime_error);
+        REQUIRE_THROWS_AS(hierarchy.set_parent(root, root), Runtime_error);
+    }
+
+    SUBCASE("Remove a subtree") {
+        hierarchy.remove(child);
+
+        REQUIRE_EQ(hierarchy.size(), 2);
+        REQUIRE_FALSE(hierarchy.contains(child));
+        REQUIRE_FALSE(hierarchy.contains(grandchild));
+        REQUIRE_THROWS_AS(hierarchy.world(grandchild), Runtime_error);
+
+        hierarchy.set_local(other_root, translation(0, 50));
+        const auto new_node = hierarchy.add(translation(1, 1), other_root);
+        hierarchy.update();
+        REQUIRE_EQ(world_position(hierarchy, root), Vec2{100, 0});
+        REQUIRE_EQ(world_position(hierarchy, new_node), Vec2{1, 51});
+    }
+}
+
+TEST_CASE("Transform hierarchy with many nodes") {
+    // A chain of nodes, each one added before its parent in the arrays
+    Transform_hierarchy hierarchy;
+    std::vector<Transform_hierarchy::Node_id> nodes;
+    for (auto i = 0; i != 100; ++i) {
+        nodes.push_back(hierarchy.add(translation(1, 0)));
+    }
+    for (auto i = 99; i != 0; --i) {
+        hierarchy.set_parent(nodes[static_cast<std::size_t>(i - 1)],
+                             nodes[static_cast<std::size_t>(i)]);
+    }
+    hierarchy.update();
+
+    REQUIRE_EQ(world_position(hierarchy, nodes[0]), Vec2{100, 0});
+    REQUIRE_EQ(world_position(hierarchy, nodes[99]), Vec2{1, 0});
+}
@@ -25,7 +25,7 @@ struct Index_buffer {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
     }
 
-    void unbind() const noexcept {
+    static void unbind() noexcept {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 };
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cmath>
@@ -15,7 +16,7 @@
 #include "bolder/exception.hpp"
 #include "bolder/file_util.hpp"
 #include "bolder/transform.hpp"
-#include "bolder/handle_manager.hpp"
+#include "bolder/paged_handle_manager.hpp"
 
 /** @defgroup opengl OpenGL
  * @brief This module provides the graphics backend that use OpenGL.
@@ -78,9 +79,9 @@ void check_gl_error() {
 }
 
 struct Context {
-    Handle_manager<Index_buffer_handle, Index_buffer> ibos;
-    Handle_manager<Vertex_buffer_handle, Vertex_buffer> vbos;
-    Handle_manager<Texture_handle, Texture2d> textures_;
+    Paged_handle_manager<Index_buffer_handle, Index_buffer> ibos;
+    Paged_handle_manager<Vertex_buffer_handle, Vertex_buffer> vbos;
+    Paged_handle_manager<Texture_handle, Texture2d> textures_;
 
     Vertex_array vao;
     Program shader_program;
@@ -115,21 +116,50 @@ void clear() {
 
 void render(const Context& context, Draw_call draw_call)
 {
+    render(context, &draw_call, 1);
+}
+
+void render(const Context& context, const Draw_call* draw_calls, uint32 count)
+{
+    // Handles are resolved batch_size at a time with stack buffers
+    constexpr uint32 batch_size = 256;
+    std::array<Index_buffer_handle, batch_size> ibo_handles;
+    std::array<Texture_handle, batch_size> texture_handles;
+    std::array<const Index_buffer*, batch_size> ibos;
+    std::array<const Texture2d*, batch_size> textures;
+
     auto projection = math::orthographic(-1, 1, -1, 1, -1, 1);
 
     context.shader_program.use();
     context.shader_program.set_uniform("projection", projection);
+    context.vao.bind();
+
+    for (uint32 first = 0; first < count; first += batch_size) {
+        const auto batch = std::min(batch_size, count - first);
+        for (uint32 i = 0; i != batch; ++i) {
+            ibo_handles[i] = draw_calls[first + i].ibo_handle;
+            texture_handles[i] = draw_calls[first + i].texture_handle;
+        }
 
-    auto ibo = *context.ibos[draw_call.ibo_handle];
-    auto texture = *context.textures_[draw_call.texture_handle];
+        context.ibos.resolve_n(ibo_handles.data(), batch, ibos.data());
+        context.textures_.resolve_n(texture_handles.data(), batch,
+                                    textures.data());
 
-    context.vao.bind();
-    ibo.bind();
-    texture.bind();
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ibo.size),
-                   GL_UNSIGNED_INT, nullptr);
-    ibo.unbind();
-    texture.unbind();
+        for (uint32 i = 0; i != batch; ++i) {
+            if (!ibos[i] || !textures[i]) {
+                BOLDER_LOG_WARNING << "Skip a draw call with invalid handles";
+                continue;
+            }
+
+            ibos[i]->bind();
+            textures[i]->bind();
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ibos[i]->size),
+                           GL_UNSIGNED_INT, nullptr);
+        }
+    }
+
+    Index_buffer::unbind();
+    Texture2d::unbind();
     context.vao.unbind();
 
 #ifndef NDEBUG
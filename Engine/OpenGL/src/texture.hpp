@@ -15,7 +15,7 @@ struct Texture2d {
         glBindTexture(GL_TEXTURE_2D, id);
     }
 
-    void unbind() const noexcept {
+    static void unbind() noexcept {
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
@@ -0,0 +1,75 @@
+// Step time of pyramids of boxes that rest on the ground, against the 10 ms
+// update of the engine
+//
+// Known limitation: bodies never sleep, so resting pyramids pay for every
+// solver iteration on every step. On a single core the median step fits the
+// budget with room to spare, but single steps can exceed it, on any step
+// rather than while the pyramids settle, when the thread is preempted.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "bolder/thread_pool.hpp"
+#include "bolder/physics/system.hpp"
+
+using namespace bolder;
+using namespace bolder::physics;
+
+namespace {
+
+constexpr int pyramid_count = 64;
+constexpr int pyramid_base = 10;
+constexpr float dt = 0.01f;
+constexpr int step_count = 500;
+
+template<typename Function>
+double milliseconds(Function f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+}
+
+int main() {
+    Thread_pool pool;
+    System system {pool};
+
+    Body_def ground;
+    ground.position = math::Vec2{0, -1};
+    ground.shape = Shape::box(pyramid_count * pyramid_base * 1.5f, 1);
+    ground.density = 0;
+    system.add_body(ground);
+
+    for (int pyramid = 0; pyramid != pyramid_count; ++pyramid) {
+        const auto left = static_cast<float>(pyramid * pyramid_base) * 1.5f;
+        for (int row = 0; row != pyramid_base; ++row) {
+            for (int column = 0; column != pyramid_base - row; ++column) {
+                // Boxes a little apart, so that a row has no side contacts
+                const auto x = (static_cast<float>(column) + 0.5f * row) * 1.1f;
+                Body_def box;
+                box.position = math::Vec2{left + x,
+                                          0.5f + static_cast<float>(row)};
+                system.add_body(box);
+            }
+        }
+    }
+
+    std::vector<double> times;
+    for (int i = 0; i != step_count; ++i) {
+        times.push_back(milliseconds([&system] { system.step(dt); }));
+    }
+    std::sort(times.begin(), times.end());
+
+    std::cout << system.size() << " bodies, " << system.contact_count()
+              << " contacts, " << system.island_count() << " islands, "
+              << pool.size() << " workers\n"
+              << "median step: " << times[times.size() / 2] << " ms\n"
+              << "99th percentile step: " << times[times.size() * 99 / 100]
+              << " ms\n"
+              << "slowest step: " << times.back() << " ms\n";
+}
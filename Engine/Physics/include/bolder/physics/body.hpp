@@ -0,0 +1,57 @@
+#pragma once
+
+#include "bolder/angle.hpp"
+#include "bolder/integer.hpp"
+#include "bolder/vector.hpp"
+
+namespace bolder { namespace physics {
+
+/// Identifies a body of a physics System, until it is removed
+using Body_id = uint32;
+
+enum class Shape_type : uint8 {
+    circle,
+    box
+};
+
+/// Collision shape of a body, centered on the position of the body
+struct Shape {
+    Shape_type type;
+    math::Vec2 half_extents; ///< Of a box
+    float radius; ///< Of a circle
+
+    static Shape circle(float radius) {
+        return Shape{Shape_type::circle, math::Vec2{0, 0}, radius};
+    }
+
+    static Shape box(float half_width, float half_height) {
+        return Shape{Shape_type::box, math::Vec2{half_width, half_height}, 0};
+    }
+};
+
+/// Describes a body to add to a physics System
+struct Body_def {
+    math::Vec2 position {0, 0};
+    math::Radian angle;
+    math::Vec2 velocity {0, 0};
+    float angular_velocity = 0;
+    Shape shape = Shape::box(0.5f, 0.5f);
+    /// Mass per unit of area; a density of 0 makes a static body, which never
+    /// moves
+    float density = 1;
+    float friction = 0.5f;
+};
+
+/**
+ * @brief Component that links an entity to a body of a physics System.
+ *
+ * The system writes the position and angle of the body into the component
+ * after every step, for the systems that draw or otherwise follow the entity.
+ */
+struct Rigid_body {
+    Body_id body;
+    math::Vec2 position {0, 0};
+    math::Radian angle;
+};
+
+}} // namespace bolder::physics
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "bolder/aabb.hpp"
+#include "bolder/integer.hpp"
+#include "bolder/vector.hpp"
+
+#include "body.hpp"
+
+namespace bolder { namespace physics {
+
+/// Position and rotation of a shape
+struct Pose {
+    math::Vec2 position;
+    float angle; ///< In radians
+};
+
+/// A point where two shapes touch
+struct Contact_point {
+    math::Vec2 position;
+    /// Distance between the shapes along the normal, negative when they
+    /// overlap
+    float separation;
+    /// Identifies the edges that made the point, so that the point can be
+    /// matched with the same point of the previous step
+    uint32 feature;
+};
+
+/// Where two shapes touch
+struct Manifold {
+    math::Vec2 normal; ///< Unit vector that points from the first shape
+    Contact_point points[2];
+    int count = 0;
+};
+
+/// Returns the axis-aligned box that contains a shape
+math::Aabb2 bounds(const Shape& shape, const Pose& pose);
+
+/**
+ * @brief Finds the points where two shapes overlap.
+ *
+ * Boxes that overlap along an edge touch at the two ends of the overlap, which
+ * lets a box rest on another without rocking. The clipping follows Erin
+ * Catto's Box2D Lite.
+ */
+Manifold collide(const Shape& a, const Pose& pose_a,
+                 const Shape& b, const Pose& pose_b);
+
+}} // namespace bolder::physics
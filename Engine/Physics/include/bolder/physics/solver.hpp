@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "bolder/integer.hpp"
+#include "bolder/vector.hpp"
+
+namespace bolder { namespace physics {
+
+/// Velocities of the bodies of an island, indexed by their slots in the island
+struct Island_velocities {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> angular;
+
+    void resize(std::size_t count) {
+        x.resize(count);
+        y.resize(count);
+        angular.resize(count);
+    }
+};
+
+/// A contact point between two bodies of an island
+struct Solver_contact {
+    uint32 a; ///< Slot of the first body
+    uint32 b; ///< Slot of the second body
+    math::Vec2 normal; ///< Unit vector from a to b
+    math::Vec2 offset_a; ///< From the center of a to the contact point
+    math::Vec2 offset_b; ///< From the center of b to the contact point
+    float inverse_mass_a;
+    float inverse_inertia_a;
+    float inverse_mass_b;
+    float inverse_inertia_b;
+    float separation;
+    float friction;
+    /// Accumulated impulses: the ones of the previous step before solve(),
+    /// which warm start the solver, and the new ones after
+    float normal_impulse;
+    float tangent_impulse;
+};
+
+/**
+ * @brief Sequential impulse solver for the contacts of an island.
+ *
+ * The contacts are packed into batches of four that share no body, and each
+ * batch is solved at once with SIMD, one contact per lane: the lanes gather
+ * the velocities of their bodies, compute their impulses side by side, and
+ * scatter the velocities back. Since no two lanes touch the same body, this
+ * gives the same result as solving the four contacts one after the other.
+ *
+ * Contacts with static bodies use a slot whose velocity is zero and stays
+ * zero, which may appear in any number of lanes; padding lanes use it too.
+ *
+ * Keep a solver across steps to reuse its memory.
+ */
+class Island_solver {
+public:
+    /**
+     * @brief Applies the impulses that stop the contacts from closing.
+     * @param empty_slot Slot of the velocities that is zero, for the static
+     * bodies
+     */
+    void solve(std::vector<Solver_contact>& contacts,
+               Island_velocities& velocities, uint32 empty_slot,
+               float dt, int iterations);
+
+private:
+    static constexpr std::size_t lanes = 4;
+
+    // Contacts in lanes, with the values that stay the same during a step
+    struct Batch {
+        uint32 a[lanes];
+        uint32 b[lanes];
+        uint32 contact[lanes]; ///< Index in the contacts, for used lanes
+        float normal_x[lanes];
+        float normal_y[lanes];
+        float offset_ax[lanes];
+        float offset_ay[lanes];
+        float offset_bx[lanes];
+        float offset_by[lanes];
+        float inverse_mass_a[lanes];
+        float inverse_inertia_a[lanes];
+        float inverse_mass_b[lanes];
+        float inverse_inertia_b[lanes];
+        float normal_mass[lanes];
+        float tangent_mass[lanes];
+        float bias[lanes];
+        float friction[lanes];
+        float normal_impulse[lanes];
+        float tangent_impulse[lanes];
+        std::size_t used;
+    };
+
+    std::vector<Batch> batches_;
+    // Batches that have free lanes
+    std::vector<std::size_t> open_;
+
+    void pack(const std::vector<Solver_contact>& contacts, uint32 empty_slot,
+              float dt);
+    void solve_batch(Batch& batch, Island_velocities& velocities) const;
+};
+
+}} // namespace bolder::physics
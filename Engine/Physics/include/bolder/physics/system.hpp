@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "bolder/angle.hpp"
+#include "bolder/integer.hpp"
+#include "bolder/sweep_and_prune.hpp"
+#include "bolder/vector.hpp"
+#include "bolder/ecs/scheduler.hpp"
+
+#include "body.hpp"
+#include "solver.hpp"
+
+namespace bolder {
+
+class Thread_pool;
+
+namespace physics {
+
+/**
+ * @brief Simulates 2D rigid bodies that collide with each other.
+ *
+ * Bodies are stored in flat arrays per attribute, and a step goes through
+ * them in passes:
+ * 1. Gravity is added to the velocities of the dynamic bodies.
+ * 2. A sweep and prune broadphase finds the bodies whose bounds overlap, and
+ *    the contact points of each pair are computed into flat contact arrays.
+ * 3. Each contact starts from the impulses of the same contact in the previous
+ *    step, looked up by the bodies and the edges that made it. Resting bodies
+ *    need few iterations since their impulses barely change.
+ * 4. Contacts are split into islands, the groups of dynamic bodies that touch
+ *    each other through contacts. Islands are solved in parallel on a
+ *    Thread_pool, each by an Island_solver that copies the velocities of its
+ *    bodies into compact arrays, and solves its contacts four at a time with
+ *    SIMD.
+ * 5. The velocities move the dynamic bodies.
+ *
+ * As an ecs::System, update() steps the simulation and writes the position
+ * and angle of the bodies into the Rigid_body components of their entities.
+ * Add and remove bodies, and read their state, outside of Scheduler::run().
+ *
+ * Bodies never sleep: a resting body costs as much per step as a moving one.
+ *
+ * @par Example
+ * @code{.cpp}
+ * auto& physics = engine.scheduler().emplace_system<physics::System>(pool);
+ * Body_def ground;
+ * ground.shape = Shape::box(50, 1);
+ * ground.density = 0;
+ * physics.add_body(ground);
+ * Body_def crate;
+ * crate.position = math::Vec2{0, 10};
+ * Rigid_body body;
+ * body.body = physics.add_body(crate);
+ * auto entity = world.create_entity(body);
+ * @endcode
+ */
+class System : public ecs::System {
+public:
+    explicit System(Thread_pool& pool);
+    ~System() override;
+
+    /// Returns the number of bodies
+    std::size_t size() const {
+        return ids_.size();
+    }
+
+    /// Whether an id refers to a body of the system
+    bool contains(Body_id body) const {
+        return body < indices_.size() && indices_[body] != npos;
+    }
+
+    /**
+     * @brief Adds a body.
+     * @throw Runtime_error if the shape or the density is not positive
+     */
+    Body_id add_body(const Body_def& def);
+
+    /**
+     * @brief Removes a body.
+     * @throw Runtime_error if body is not a body of the system
+     */
+    void remove_body(Body_id body);
+
+    math::Vec2 position(Body_id body) const;
+    math::Radian angle(Body_id body) const;
+    math::Vec2 velocity(Body_id body) const;
+    float angular_velocity(Body_id body) const;
+
+    /// Sets the velocity of a dynamic body; static bodies never move
+    void set_velocity(Body_id body, math::Vec2 velocity,
+                      float angular_velocity);
+
+    math::Vec2 gravity() const {
+        return gravity_;
+    }
+
+    void set_gravity(math::Vec2 gravity) {
+        gravity_ = gravity;
+    }
+
+    /// Sets the number of times that the contacts are solved per step
+    void set_iterations(int iterations) {
+        iterations_ = iterations;
+    }
+
+    /// Returns the number of contact points found in the last step
+    std::size_t contact_count() const {
+        return contact_a_.size();
+    }
+
+    /// Returns the number of islands solved in the last step
+    std::size_t island_count() const {
+        return island_offsets_.empty() ? 0 : island_offsets_.size() - 1;
+    }
+
+    /// Advances the simulation by dt seconds
+    void step(float dt);
+
+    /// Steps by dt and writes the poses into the Rigid_body components
+    void update(ecs::World& world, ecs::Command_buffer& commands,
+                double dt) override;
+
+private:
+    static constexpr uint32 npos = ~0u;
+
+    // Impulses of a contact point at the end of a step, to warm start it
+    struct Cached_impulse {
+        uint64 bodies; ///< Ids of both bodies
+        uint32 feature;
+        float normal;
+        float tangent;
+    };
+
+    // Scratch memory of a thread that solves islands
+    struct Island_scratch {
+        std::vector<Solver_contact> contacts;
+        Island_velocities velocities;
+        Island_solver solver;
+    };
+
+    Thread_pool& pool_;
+    math::Vec2 gravity_ {0, -10};
+    int iterations_ = 10;
+
+    // Per id; the index of a body in the arrays below, or npos
+    std::vector<uint32> indices_;
+    std::vector<Body_id> free_ids_;
+
+    // Per body
+    std::vector<Body_id> ids_;
+    std::vector<Shape> shapes_;
+    std::vector<float> position_x_;
+    std::vector<float> position_y_;
+    std::vector<float> angle_;
+    std::vector<float> velocity_x_;
+    std::vector<float> velocity_y_;
+    std::vector<float> angular_velocity_;
+    std::vector<float> inverse_mass_; ///< 0 for static bodies
+    std::vector<float> inverse_inertia_;
+    std::vector<float> friction_;
+
+    math::Sweep_and_prune broadphase_;
+    std::vector<math::Sweep_and_prune::Pair> pairs_;
+
+    // Per contact point of the current step
+    std::vector<uint32> contact_a_; ///< Index of the first body
+    std::vector<uint32> contact_b_; ///< Index of the second body
+    std::vector<uint32> contact_feature_;
+    std::vector<float> contact_x_;
+    std::vector<float> contact_y_;
+    std::vector<float> contact_normal_x_;
+    std::vector<float> contact_normal_y_;
+    std::vector<float> contact_separation_;
+    std::vector<float> contact_normal_impulse_;
+    std::vector<float> contact_tangent_impulse_;
+
+    // Sorted by bodies and feature, like the contacts
+    std::vector<Cached_impulse> cache_;
+
+    // Union-find forest of the dynamic bodies that touch, by body index
+    std::vector<uint32> island_parents_;
+    // Island of every body, and its slot in the velocities of the island
+    std::vector<uint32> body_islands_;
+    std::vector<uint32> slots_;
+    // Contacts and bodies of island i are in [offsets[i], offsets[i + 1])
+    std::vector<uint32> island_contacts_;
+    std::vector<uint32> island_offsets_;
+    std::vector<uint32> island_bodies_;
+    std::vector<uint32> island_body_offsets_;
+    std::vector<Island_scratch> scratch_;
+
+    uint32 checked_index(Body_id body) const;
+    void find_contacts();
+    void warm_start();
+    void build_islands();
+    void solve_island(std::size_t island, Island_scratch& scratch, float dt);
+    void store_impulses();
+    uint32 find_root(uint32 body);
+};
+
+}} // namespace bolder::physics
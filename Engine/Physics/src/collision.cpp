@@ -0,0 +1,343 @@
+#include "collision.hpp"
+
+#include <cmath>
+
+namespace bolder { namespace physics {
+
+namespace {
+using math::Vec2;
+
+// Rotation matrix whose columns are the x and y axes of a rotated shape
+struct Rotation {
+    float c;
+    float s;
+
+    explicit Rotation(float angle) : c{std::cos(angle)}, s{std::sin(angle)} {}
+
+    Vec2 x_axis() const {
+        return Vec2{c, s};
+    }
+
+    Vec2 y_axis() const {
+        return Vec2{-s, c};
+    }
+
+    Vec2 apply(Vec2 v) const {
+        return Vec2{c * v.x - s * v.y, s * v.x + c * v.y};
+    }
+
+    Vec2 apply_inverse(Vec2 v) const {
+        return Vec2{c * v.x + s * v.y, c * v.y - s * v.x};
+    }
+};
+
+// Edges of a box, counterclockwise from the top one
+enum Edge : uint8 {
+    no_edge = 0,
+    top_edge,
+    left_edge,
+    bottom_edge,
+    right_edge
+};
+
+// The edges of the reference and of the incident box that a clipped point
+// lies on
+struct Feature {
+    uint8 in_reference = no_edge;
+    uint8 out_reference = no_edge;
+    uint8 in_incident = no_edge;
+    uint8 out_incident = no_edge;
+
+    // Swaps the boxes, for when the reference face is on the second box
+    Feature flipped() const {
+        return Feature{in_incident, out_incident, in_reference, out_reference};
+    }
+
+    uint32 packed() const {
+        return uint32{in_reference} | uint32{out_reference} << 8
+                | uint32{in_incident} << 16 | uint32{out_incident} << 24;
+    }
+};
+
+struct Clip_vertex {
+    Vec2 position;
+    Feature feature;
+};
+
+// Finds the edge of a box that is the most antiparallel to a normal
+void incident_edge(Clip_vertex (&edge)[2], Vec2 half_extents,
+                   const Pose& pose, const Rotation& rotation, Vec2 normal)
+{
+    const auto n = -rotation.apply_inverse(normal);
+    const auto h = half_extents;
+    auto set = [&edge](int i, Vec2 position, uint8 in, uint8 out) {
+        edge[i].position = position;
+        edge[i].feature.in_incident = in;
+        edge[i].feature.out_incident = out;
+    };
+
+    if (std::abs(n.x) > std::abs(n.y)) {
+        if (n.x > 0) {
+            set(0, Vec2{h.x, -h.y}, bottom_edge, right_edge);
+            set(1, Vec2{h.x, h.y}, right_edge, top_edge);
+        } else {
+            set(0, Vec2{-h.x, h.y}, top_edge, left_edge);
+            set(1, Vec2{-h.x, -h.y}, left_edge, bottom_edge);
+        }
+    } else {
+        if (n.y > 0) {
+            set(0, Vec2{h.x, h.y}, right_edge, top_edge);
+            set(1, Vec2{-h.x, h.y}, top_edge, left_edge);
+        } else {
+            set(0, Vec2{-h.x, -h.y}, left_edge, bottom_edge);
+            set(1, Vec2{h.x, -h.y}, bottom_edge, right_edge);
+        }
+    }
+    for (auto& vertex : edge) {
+        vertex.position = pose.position + rotation.apply(vertex.position);
+    }
+}
+
+// Keeps the part of a segment behind the line dot(normal, x) = offset, and
+// returns the number of points left
+int clip_segment(Clip_vertex (&out)[2], const Clip_vertex (&in)[2],
+                 Vec2 normal, float offset, uint8 clip_edge)
+{
+    int count = 0;
+    const auto distance0 = dot(normal, in[0].position) - offset;
+    const auto distance1 = dot(normal, in[1].position) - offset;
+    if (distance0 <= 0) out[count++] = in[0];
+    if (distance1 <= 0) out[count++] = in[1];
+
+    if (distance0 * distance1 < 0) {
+        const auto t = distance0 / (distance0 - distance1);
+        out[count].position = in[0].position
+                + (in[1].position - in[0].position) * t;
+        if (distance0 > 0) {
+            out[count].feature = in[0].feature;
+            out[count].feature.in_reference = clip_edge;
+            out[count].feature.in_incident = no_edge;
+        } else {
+            out[count].feature = in[1].feature;
+            out[count].feature.out_reference = clip_edge;
+            out[count].feature.out_incident = no_edge;
+        }
+        ++count;
+    }
+    return count;
+}
+
+Manifold collide_boxes(Vec2 half_a, const Pose& pose_a,
+                       Vec2 half_b, const Pose& pose_b)
+{
+    Manifold manifold;
+    const Rotation rotation_a {pose_a.angle};
+    const Rotation rotation_b {pose_b.angle};
+    const auto offset = pose_b.position - pose_a.position;
+    const auto offset_a = rotation_a.apply_inverse(offset);
+    const auto offset_b = rotation_b.apply_inverse(offset);
+
+    // Absolute values of the rotation from the frame of b to the frame of a
+    const auto c11 = std::abs(dot(rotation_a.x_axis(), rotation_b.x_axis()));
+    const auto c12 = std::abs(dot(rotation_a.x_axis(), rotation_b.y_axis()));
+    const auto c21 = std::abs(dot(rotation_a.y_axis(), rotation_b.x_axis()));
+    const auto c22 = std::abs(dot(rotation_a.y_axis(), rotation_b.y_axis()));
+
+    // Separations along the axes of both boxes
+    const Vec2 face_a {
+        std::abs(offset_a.x) - half_a.x - (c11 * half_b.x + c12 * half_b.y),
+        std::abs(offset_a.y) - half_a.y - (c21 * half_b.x + c22 * half_b.y)};
+    const Vec2 face_b {
+        std::abs(offset_b.x) - (c11 * half_a.x + c21 * half_a.y) - half_b.x,
+        std::abs(offset_b.y) - (c12 * half_a.x + c22 * half_a.y) - half_b.y};
+    if (face_a.x > 0 || face_a.y > 0 || face_b.x > 0 || face_b.y > 0) {
+        return manifold;
+    }
+
+    // Picks the axis of least penetration, preferring the faces of a and the
+    // x axes, so that the choice does not flicker between steps
+    enum class Axis { a_x, a_y, b_x, b_y };
+    constexpr float relative_tolerance = 0.95f;
+    constexpr float absolute_tolerance = 0.01f;
+    auto axis = Axis::a_x;
+    auto separation = face_a.x;
+    auto normal = offset_a.x > 0 ? rotation_a.x_axis() : -rotation_a.x_axis();
+    auto prefer = [&](float face, float half_extent, Axis candidate,
+                      Vec2 candidate_axis, float side) {
+        if (face > relative_tolerance * separation
+                   + absolute_tolerance * half_extent) {
+            axis = candidate;
+            separation = face;
+            normal = side > 0 ? candidate_axis : -candidate_axis;
+        }
+    };
+    prefer(face_a.y, half_a.y, Axis::a_y, rotation_a.y_axis(), offset_a.y);
+    prefer(face_b.x, half_b.x, Axis::b_x, rotation_b.x_axis(), offset_b.x);
+    prefer(face_b.y, half_b.y, Axis::b_y, rotation_b.y_axis(), offset_b.y);
+
+    // The reference face is the face of the axis, and the incident edge is the
+    // edge of the other box that faces it
+    Vec2 front_normal = normal;
+    Vec2 side_normal {0, 0};
+    float front = 0;
+    float side_extent = 0;
+    uint8 negative_edge = no_edge;
+    uint8 positive_edge = no_edge;
+    Clip_vertex incident[2];
+    switch (axis) {
+    case Axis::a_x:
+    case Axis::a_y: {
+        const auto on_x = axis == Axis::a_x;
+        front = dot(pose_a.position, front_normal)
+                + (on_x ? half_a.x : half_a.y);
+        side_normal = on_x ? rotation_a.y_axis() : rotation_a.x_axis();
+        side_extent = on_x ? half_a.y : half_a.x;
+        negative_edge = on_x ? bottom_edge : left_edge;
+        positive_edge = on_x ? top_edge : right_edge;
+        incident_edge(incident, half_b, pose_b, rotation_b, front_normal);
+        break;
+    }
+    case Axis::b_x:
+    case Axis::b_y: {
+        const auto on_x = axis == Axis::b_x;
+        front_normal = -normal;
+        front = dot(pose_b.position, front_normal)
+                + (on_x ? half_b.x : half_b.y);
+        side_normal = on_x ? rotation_b.y_axis() : rotation_b.x_axis();
+        side_extent = on_x ? half_b.y : half_b.x;
+        negative_edge = on_x ? bottom_edge : left_edge;
+        positive_edge = on_x ? top_edge : right_edge;
+        incident_edge(incident, half_a, pose_a, rotation_a, front_normal);
+        break;
+    }
+    }
+    const auto side = dot(axis == Axis::a_x || axis == Axis::a_y
+                          ? pose_a.position : pose_b.position, side_normal);
+
+    // Clips the incident edge to the sides of the reference face
+    Clip_vertex clipped1[2];
+    Clip_vertex clipped2[2];
+    if (clip_segment(clipped1, incident, -side_normal,
+                     side_extent - side, negative_edge) < 2) {
+        return manifold;
+    }
+    if (clip_segment(clipped2, clipped1, side_normal,
+                     side_extent + side, positive_edge) < 2) {
+        return manifold;
+    }
+
+    manifold.normal = normal;
+    const auto flip = axis == Axis::b_x || axis == Axis::b_y;
+    for (const auto& vertex : clipped2) {
+        const auto distance = dot(front_normal, vertex.position) - front;
+        if (distance > 0) continue;
+
+        // Moves the point onto the reference face
+        auto& point = manifold.points[manifold.count++];
+        point.position = vertex.position - front_normal * distance;
+        point.separation = distance;
+        point.feature = (flip ? vertex.feature.flipped() : vertex.feature)
+                .packed();
+    }
+    return manifold;
+}
+
+// The normal points from the box to the circle
+Manifold collide_box_circle(Vec2 half_extents, const Pose& box,
+                            Vec2 center, float radius)
+{
+    Manifold manifold;
+    const Rotation rotation {box.angle};
+    const auto local = rotation.apply_inverse(center - box.position);
+    const Vec2 clamped {
+        std::max(-half_extents.x, std::min(local.x, half_extents.x)),
+        std::max(-half_extents.y, std::min(local.y, half_extents.y))};
+
+    Vec2 local_normal {0, 0};
+    Vec2 surface = clamped;
+    float separation;
+    if (clamped == local) {
+        // The center is inside the box, and leaves through the closest face
+        const auto depth_x = half_extents.x - std::abs(local.x);
+        const auto depth_y = half_extents.y - std::abs(local.y);
+        if (depth_x < depth_y) {
+            local_normal.x = local.x < 0 ? -1.f : 1.f;
+            surface.x = local_normal.x * half_extents.x;
+            separation = -depth_x - radius;
+        } else {
+            local_normal.y = local.y < 0 ? -1.f : 1.f;
+            surface.y = local_normal.y * half_extents.y;
+            separation = -depth_y - radius;
+        }
+    } else {
+        const auto offset = local - clamped;
+        const auto distance = offset.length();
+        if (distance > radius) return manifold;
+        local_normal = offset / distance;
+        separation = distance - radius;
+    }
+
+    manifold.normal = rotation.apply(local_normal);
+    manifold.points[0] = Contact_point{box.position + rotation.apply(surface),
+                                       separation, 0};
+    manifold.count = 1;
+    return manifold;
+}
+
+Manifold collide_circles(Vec2 center_a, float radius_a,
+                         Vec2 center_b, float radius_b)
+{
+    Manifold manifold;
+    const auto offset = center_b - center_a;
+    const auto radii = radius_a + radius_b;
+    if (offset.length_square() > radii * radii) return manifold;
+
+    const auto distance = offset.length();
+    manifold.normal = distance > 0 ? offset / distance : Vec2{0, 1};
+    const auto separation = distance - radii;
+    // Halfway between the surfaces
+    manifold.points[0] = Contact_point{
+            center_a + manifold.normal * (radius_a + separation / 2),
+            separation, 0};
+    manifold.count = 1;
+    return manifold;
+}
+} // anonymous namespace
+
+math::Aabb2 bounds(const Shape& shape, const Pose& pose)
+{
+    if (shape.type == Shape_type::circle) {
+        return math::Aabb2::from_circle(pose.position, shape.radius);
+    }
+
+    const Rotation rotation {pose.angle};
+    const auto c = std::abs(rotation.c);
+    const auto s = std::abs(rotation.s);
+    const auto& h = shape.half_extents;
+    const Vec2 extent {c * h.x + s * h.y, s * h.x + c * h.y};
+    return math::Aabb2{pose.position - extent, pose.position + extent};
+}
+
+Manifold collide(const Shape& a, const Pose& pose_a,
+                 const Shape& b, const Pose& pose_b)
+{
+    const auto a_box = a.type == Shape_type::box;
+    const auto b_box = b.type == Shape_type::box;
+    if (a_box && b_box) {
+        return collide_boxes(a.half_extents, pose_a, b.half_extents, pose_b);
+    }
+    if (a_box) {
+        return collide_box_circle(a.half_extents, pose_a, pose_b.position,
+                                  b.radius);
+    }
+    if (b_box) {
+        auto manifold = collide_box_circle(b.half_extents, pose_b,
+                                           pose_a.position, a.radius);
+        manifold.normal = -manifold.normal;
+        return manifold;
+    }
+    return collide_circles(pose_a.position, a.radius,
+                           pose_b.position, b.radius);
+}
+
+}} // namespace bolder::physics
@@ -0,0 +1,222 @@
+#include "solver.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "bolder/simd.hpp"
+
+namespace bolder { namespace physics {
+
+namespace {
+using simd::Float4;
+
+// Fraction of the overlap that is pushed apart per second times the step
+constexpr float bias_factor = 0.2f;
+// Overlap that is allowed, so that resting contacts do not jitter
+constexpr float allowed_penetration = 0.01f;
+// Number of most recently opened batches that a contact tries to join
+constexpr std::size_t open_batch_search = 8;
+
+float cross(math::Vec2 lhs, math::Vec2 rhs)
+{
+    return lhs.x * rhs.y - lhs.y * rhs.x;
+}
+
+// Returns the effective mass of a contact along a direction
+float effective_mass(const Solver_contact& contact, math::Vec2 direction)
+{
+    const auto rotation_a = cross(contact.offset_a, direction);
+    const auto rotation_b = cross(contact.offset_b, direction);
+    const auto k = contact.inverse_mass_a + contact.inverse_mass_b
+            + contact.inverse_inertia_a * rotation_a * rotation_a
+            + contact.inverse_inertia_b * rotation_b * rotation_b;
+    return k > 0 ? 1 / k : 0;
+}
+
+Float4 gather(const std::vector<float>& values, const uint32 (&slots)[4])
+{
+    return Float4{values[slots[0]], values[slots[1]], values[slots[2]],
+                  values[slots[3]]};
+}
+
+void scatter(std::vector<float>& values, const uint32 (&slots)[4],
+             Float4 lanes)
+{
+    float stored[4];
+    lanes.store(stored);
+    for (auto lane = 0; lane != 4; ++lane) values[slots[lane]] = stored[lane];
+}
+} // anonymous namespace
+
+constexpr std::size_t Island_solver::lanes;
+
+void Island_solver::solve(std::vector<Solver_contact>& contacts,
+                          Island_velocities& velocities, uint32 empty_slot,
+                          float dt, int iterations)
+{
+    // Warm starts with the impulses of the previous step
+    for (const auto& contact : contacts) {
+        const math::Vec2 tangent {contact.normal.y, -contact.normal.x};
+        const auto impulse = contact.normal * contact.normal_impulse
+                + tangent * contact.tangent_impulse;
+        velocities.x[contact.a] -= contact.inverse_mass_a * impulse.x;
+        velocities.y[contact.a] -= contact.inverse_mass_a * impulse.y;
+        velocities.angular[contact.a] -= contact.inverse_inertia_a
+                * cross(contact.offset_a, impulse);
+        velocities.x[contact.b] += contact.inverse_mass_b * impulse.x;
+        velocities.y[contact.b] += contact.inverse_mass_b * impulse.y;
+        velocities.angular[contact.b] += contact.inverse_inertia_b
+                * cross(contact.offset_b, impulse);
+    }
+
+    pack(contacts, empty_slot, dt);
+    for (auto i = 0; i != iterations; ++i) {
+        for (auto& batch : batches_) solve_batch(batch, velocities);
+    }
+
+    for (const auto& batch : batches_) {
+        for (std::size_t lane = 0; lane != batch.used; ++lane) {
+            auto& contact = contacts[batch.contact[lane]];
+            contact.normal_impulse = batch.normal_impulse[lane];
+            contact.tangent_impulse = batch.tangent_impulse[lane];
+        }
+    }
+}
+
+// Puts every contact in the first recently opened batch that has none of its
+// bodies, or in a new batch
+void Island_solver::pack(const std::vector<Solver_contact>& contacts,
+                         uint32 empty_slot, float dt)
+{
+    batches_.clear();
+    open_.clear();
+
+    for (std::size_t i = 0; i != contacts.size(); ++i) {
+        const auto& contact = contacts[i];
+        auto uses = [&contact, empty_slot](const Batch& batch) {
+            for (std::size_t lane = 0; lane != batch.used; ++lane) {
+                for (auto slot : {batch.a[lane], batch.b[lane]}) {
+                    if (slot != empty_slot
+                            && (slot == contact.a || slot == contact.b)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        };
+
+        auto open = open_.size();
+        const auto first = open_.size() > open_batch_search
+                ? open_.size() - open_batch_search : 0;
+        while (open != first && uses(batches_[open_[open - 1]])) --open;
+        if (open == first) {
+            // Unused lanes only touch the empty slot, with zero masses
+            Batch batch {};
+            std::fill(std::begin(batch.a), std::end(batch.a), empty_slot);
+            std::fill(std::begin(batch.b), std::end(batch.b), empty_slot);
+            batches_.push_back(batch);
+            open_.push_back(batches_.size() - 1);
+            open = open_.size();
+        }
+
+        auto& batch = batches_[open_[open - 1]];
+        const auto lane = batch.used++;
+        if (batch.used == lanes) {
+            open_.erase(open_.begin() + static_cast<std::ptrdiff_t>(open - 1));
+        }
+
+        const math::Vec2 tangent {contact.normal.y, -contact.normal.x};
+        batch.a[lane] = contact.a;
+        batch.b[lane] = contact.b;
+        batch.contact[lane] = static_cast<uint32>(i);
+        batch.normal_x[lane] = contact.normal.x;
+        batch.normal_y[lane] = contact.normal.y;
+        batch.offset_ax[lane] = contact.offset_a.x;
+        batch.offset_ay[lane] = contact.offset_a.y;
+        batch.offset_bx[lane] = contact.offset_b.x;
+        batch.offset_by[lane] = contact.offset_b.y;
+        batch.inverse_mass_a[lane] = contact.inverse_mass_a;
+        batch.inverse_inertia_a[lane] = contact.inverse_inertia_a;
+        batch.inverse_mass_b[lane] = contact.inverse_mass_b;
+        batch.inverse_inertia_b[lane] = contact.inverse_inertia_b;
+        batch.normal_mass[lane] = effective_mass(contact, contact.normal);
+        batch.tangent_mass[lane] = effective_mass(contact, tangent);
+        batch.bias[lane] = -bias_factor / dt
+                * std::min(0.f, contact.separation + allowed_penetration);
+        batch.friction[lane] = contact.friction;
+        batch.normal_impulse[lane] = contact.normal_impulse;
+        batch.tangent_impulse[lane] = contact.tangent_impulse;
+    }
+}
+
+void Island_solver::solve_batch(Batch& batch,
+                                Island_velocities& velocities) const
+{
+    auto velocity_ax = gather(velocities.x, batch.a);
+    auto velocity_ay = gather(velocities.y, batch.a);
+    auto angular_a = gather(velocities.angular, batch.a);
+    auto velocity_bx = gather(velocities.x, batch.b);
+    auto velocity_by = gather(velocities.y, batch.b);
+    auto angular_b = gather(velocities.angular, batch.b);
+
+    const auto normal_x = Float4::load(batch.normal_x);
+    const auto normal_y = Float4::load(batch.normal_y);
+    const auto offset_ax = Float4::load(batch.offset_ax);
+    const auto offset_ay = Float4::load(batch.offset_ay);
+    const auto offset_bx = Float4::load(batch.offset_bx);
+    const auto offset_by = Float4::load(batch.offset_by);
+    const auto mass_a = Float4::load(batch.inverse_mass_a);
+    const auto inertia_a = Float4::load(batch.inverse_inertia_a);
+    const auto mass_b = Float4::load(batch.inverse_mass_b);
+    const auto inertia_b = Float4::load(batch.inverse_inertia_b);
+
+    // Relative velocity of the contact points along a direction
+    auto relative_velocity = [&](Float4 direction_x, Float4 direction_y) {
+        const auto x = velocity_bx - angular_b * offset_by
+                - velocity_ax + angular_a * offset_ay;
+        const auto y = velocity_by + angular_b * offset_bx
+                - velocity_ay - angular_a * offset_ax;
+        return x * direction_x + y * direction_y;
+    };
+    auto apply = [&](Float4 x, Float4 y) {
+        velocity_ax = velocity_ax - mass_a * x;
+        velocity_ay = velocity_ay - mass_a * y;
+        angular_a = angular_a - inertia_a * (offset_ax * y - offset_ay * x);
+        velocity_bx = velocity_bx + mass_b * x;
+        velocity_by = velocity_by + mass_b * y;
+        angular_b = angular_b + inertia_b * (offset_bx * y - offset_by * x);
+    };
+
+    // Friction, bounded by the normal impulse of the previous iteration
+    const auto tangent_x = normal_y;
+    const auto tangent_y = Float4::splat(0) - normal_x;
+    const auto normal_impulse = Float4::load(batch.normal_impulse);
+    const auto max_friction = Float4::load(batch.friction) * normal_impulse;
+    const auto old_tangent = Float4::load(batch.tangent_impulse);
+    const auto tangent_impulse = max(
+                Float4::splat(0) - max_friction,
+                min(old_tangent - Float4::load(batch.tangent_mass)
+                    * relative_velocity(tangent_x, tangent_y), max_friction));
+    const auto tangent_delta = tangent_impulse - old_tangent;
+    apply(tangent_x * tangent_delta, tangent_y * tangent_delta);
+    tangent_impulse.store(batch.tangent_impulse);
+
+    // Non-penetration, which can push but never pull
+    const auto new_normal = max(
+                normal_impulse + Float4::load(batch.normal_mass)
+                * (Float4::load(batch.bias)
+                   - relative_velocity(normal_x, normal_y)),
+                Float4::splat(0));
+    const auto normal_delta = new_normal - normal_impulse;
+    apply(normal_x * normal_delta, normal_y * normal_delta);
+    new_normal.store(batch.normal_impulse);
+
+    scatter(velocities.x, batch.a, velocity_ax);
+    scatter(velocities.y, batch.a, velocity_ay);
+    scatter(velocities.angular, batch.a, angular_a);
+    scatter(velocities.x, batch.b, velocity_bx);
+    scatter(velocities.y, batch.b, velocity_by);
+    scatter(velocities.angular, batch.b, angular_b);
+}
+
+}} // namespace bolder::physics
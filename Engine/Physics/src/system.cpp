@@ -0,0 +1,450 @@
+#include "bolder/physics/system.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "bolder/exception.hpp"
+#include "bolder/thread_pool.hpp"
+#include "bolder/ecs/query.hpp"
+#include "bolder/ecs/world.hpp"
+
+#include "collision.hpp"
+
+namespace bolder { namespace physics {
+
+namespace {
+constexpr float pi = 3.14159265358979f;
+
+uint64 body_pair(Body_id a, Body_id b)
+{
+    return uint64{a} << 32 | b;
+}
+
+// Order of contacts by their bodies, then their feature
+bool precedes(uint64 bodies, uint32 feature, uint64 other_bodies,
+              uint32 other_feature)
+{
+    return bodies < other_bodies
+            || (bodies == other_bodies && feature < other_feature);
+}
+
+bool valid(const Shape& shape)
+{
+    switch (shape.type) {
+    case Shape_type::circle:
+        return shape.radius > 0;
+    case Shape_type::box:
+        return shape.half_extents.x > 0 && shape.half_extents.y > 0;
+    }
+    return false;
+}
+} // anonymous namespace
+
+constexpr uint32 System::npos;
+
+System::System(Thread_pool& pool)
+    : ecs::System{ecs::make_access<Rigid_body>()}, pool_{pool},
+      scratch_(pool.size() + 1)
+{
+}
+
+System::~System() = default;
+
+Body_id System::add_body(const Body_def& def)
+{
+    if (!valid(def.shape)) {
+        throw Runtime_error {"Add a body whose shape has no area"};
+    }
+    if (!(def.density >= 0)) {
+        throw Runtime_error {"Add a body with a negative density"};
+    }
+
+    Body_id id;
+    if (free_ids_.empty()) {
+        id = static_cast<Body_id>(indices_.size());
+        indices_.push_back(npos);
+    } else {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+    }
+    indices_[id] = static_cast<uint32>(ids_.size());
+
+    float mass, inertia;
+    const auto& shape = def.shape;
+    if (shape.type == Shape_type::circle) {
+        mass = def.density * pi * shape.radius * shape.radius;
+        inertia = mass * shape.radius * shape.radius / 2;
+    } else {
+        const auto& half = shape.half_extents;
+        mass = def.density * 4 * half.x * half.y;
+        inertia = mass * (half.x * half.x + half.y * half.y) / 3;
+    }
+    const auto is_static = mass == 0;
+
+    ids_.push_back(id);
+    shapes_.push_back(shape);
+    position_x_.push_back(def.position.x);
+    position_y_.push_back(def.position.y);
+    angle_.push_back(def.angle.value());
+    velocity_x_.push_back(is_static ? 0 : def.velocity.x);
+    velocity_y_.push_back(is_static ? 0 : def.velocity.y);
+    angular_velocity_.push_back(is_static ? 0 : def.angular_velocity);
+    inverse_mass_.push_back(is_static ? 0 : 1 / mass);
+    inverse_inertia_.push_back(is_static ? 0 : 1 / inertia);
+    friction_.push_back(def.friction);
+
+    const Pose pose {def.position, def.angle.value()};
+    broadphase_.insert(id, bounds(shape, pose));
+    return id;
+}
+
+void System::remove_body(Body_id body)
+{
+    if (!contains(body)) {
+        throw Runtime_error {"Remove a body that the system does not contain"};
+    }
+
+    // Moves the last body into the place of the removed one
+    const auto index = indices_[body];
+    const auto last = ids_.size() - 1;
+    auto move_last = [index, last](auto& values) {
+        values[index] = values[last];
+        values.pop_back();
+    };
+    indices_[ids_[last]] = index;
+    move_last(ids_);
+    move_last(shapes_);
+    move_last(position_x_);
+    move_last(position_y_);
+    move_last(angle_);
+    move_last(velocity_x_);
+    move_last(velocity_y_);
+    move_last(angular_velocity_);
+    move_last(inverse_mass_);
+    move_last(inverse_inertia_);
+    move_last(friction_);
+
+    indices_[body] = npos;
+    free_ids_.push_back(body);
+    broadphase_.erase(body);
+
+    // A new body may reuse the id, and must not start from these impulses
+    cache_.erase(std::remove_if(cache_.begin(), cache_.end(),
+                                [body](const Cached_impulse& cached) {
+        return cached.bodies >> 32 == body
+                || (cached.bodies & 0xffffffffu) == body;
+    }), cache_.end());
+}
+
+uint32 System::checked_index(Body_id body) const
+{
+    if (!contains(body)) {
+        throw Runtime_error {"Access a body that the system does not contain"};
+    }
+    return indices_[body];
+}
+
+math::Vec2 System::position(Body_id body) const
+{
+    const auto index = checked_index(body);
+    return math::Vec2{position_x_[index], position_y_[index]};
+}
+
+math::Radian System::angle(Body_id body) const
+{
+    return math::Radian{angle_[checked_index(body)]};
+}
+
+math::Vec2 System::velocity(Body_id body) const
+{
+    const auto index = checked_index(body);
+    return math::Vec2{velocity_x_[index], velocity_y_[index]};
+}
+
+float System::angular_velocity(Body_id body) const
+{
+    return angular_velocity_[checked_index(body)];
+}
+
+void System::set_velocity(Body_id body, math::Vec2 velocity,
+                          float angular_velocity)
+{
+    const auto index = checked_index(body);
+    if (inverse_mass_[index] == 0) return;
+    velocity_x_[index] = velocity.x;
+    velocity_y_[index] = velocity.y;
+    angular_velocity_[index] = angular_velocity;
+}
+
+void System::step(float dt)
+{
+    const auto count = ids_.size();
+    for (std::size_t i = 0; i != count; ++i) {
+        if (inverse_mass_[i] == 0) continue;
+        velocity_x_[i] += gravity_.x * dt;
+        velocity_y_[i] += gravity_.y * dt;
+    }
+
+    find_contacts();
+    warm_start();
+    build_islands();
+
+    parallel_for(pool_, island_count(),
+                 [this, dt](std::size_t participant, std::size_t island) {
+        solve_island(island, scratch_[participant], dt);
+    });
+
+    for (std::size_t i = 0; i != count; ++i) {
+        if (inverse_mass_[i] == 0) continue;
+        position_x_[i] += velocity_x_[i] * dt;
+        position_y_[i] += velocity_y_[i] * dt;
+        angle_[i] += angular_velocity_[i] * dt;
+        const math::Vec2 position {position_x_[i], position_y_[i]};
+        const Pose pose {position, angle_[i]};
+        broadphase_.update(ids_[i], bounds(shapes_[i], pose));
+    }
+
+    store_impulses();
+}
+
+void System::update(ecs::World& world, ecs::Command_buffer& /*commands*/,
+                    double dt)
+{
+    step(static_cast<float>(dt));
+
+    ecs::Query<Rigid_body> query {world};
+    query.each([this](Rigid_body& rigid_body) {
+        if (!contains(rigid_body.body)) return;
+        const auto index = indices_[rigid_body.body];
+        rigid_body.position = math::Vec2{position_x_[index],
+                                         position_y_[index]};
+        rigid_body.angle = math::Radian{angle_[index]};
+    });
+}
+
+void System::find_contacts()
+{
+    contact_a_.clear();
+    contact_b_.clear();
+    contact_feature_.clear();
+    contact_x_.clear();
+    contact_y_.clear();
+    contact_normal_x_.clear();
+    contact_normal_y_.clear();
+    contact_separation_.clear();
+
+    // Keeps the contacts sorted like the impulse cache, and their order
+    // independent of the broadphase
+    broadphase_.find_pairs(pairs_);
+    std::sort(pairs_.begin(), pairs_.end());
+    for (const auto& pair : pairs_) {
+        const auto a = indices_[pair.first];
+        const auto b = indices_[pair.second];
+        if (inverse_mass_[a] == 0 && inverse_mass_[b] == 0) continue;
+
+        const Pose pose_a {math::Vec2{position_x_[a], position_y_[a]},
+                           angle_[a]};
+        const Pose pose_b {math::Vec2{position_x_[b], position_y_[b]},
+                           angle_[b]};
+        auto manifold = collide(shapes_[a], pose_a, shapes_[b], pose_b);
+        if (manifold.count == 2
+                && manifold.points[1].feature < manifold.points[0].feature) {
+            std::swap(manifold.points[0], manifold.points[1]);
+        }
+        for (auto i = 0; i != manifold.count; ++i) {
+            const auto& point = manifold.points[i];
+            contact_a_.push_back(a);
+            contact_b_.push_back(b);
+            contact_feature_.push_back(point.feature);
+            contact_x_.push_back(point.position.x);
+            contact_y_.push_back(point.position.y);
+            contact_normal_x_.push_back(manifold.normal.x);
+            contact_normal_y_.push_back(manifold.normal.y);
+            contact_separation_.push_back(point.separation);
+        }
+    }
+}
+
+// Starts the contacts that existed in the last step from their impulses, by
+// merging the sorted contacts with the sorted cache
+void System::warm_start()
+{
+    const auto count = contact_a_.size();
+    contact_normal_impulse_.assign(count, 0);
+    contact_tangent_impulse_.assign(count, 0);
+
+    auto cached = cache_.begin();
+    for (std::size_t i = 0; i != count && cached != cache_.end(); ++i) {
+        const auto bodies = body_pair(ids_[contact_a_[i]], ids_[contact_b_[i]]);
+        const auto feature = contact_feature_[i];
+        while (cached != cache_.end()
+               && precedes(cached->bodies, cached->feature, bodies, feature)) {
+            ++cached;
+        }
+        if (cached != cache_.end() && cached->bodies == bodies
+                && cached->feature == feature) {
+            contact_normal_impulse_[i] = cached->normal;
+            contact_tangent_impulse_[i] = cached->tangent;
+        }
+    }
+}
+
+uint32 System::find_root(uint32 body)
+{
+    while (island_parents_[body] != body) {
+        // Path halving
+        island_parents_[body] = island_parents_[island_parents_[body]];
+        body = island_parents_[body];
+    }
+    return body;
+}
+
+// Groups the contacts and the dynamic bodies that they touch by island, with
+// counting sorts
+void System::build_islands()
+{
+    const auto body_count = static_cast<uint32>(ids_.size());
+    const auto contact_count = contact_a_.size();
+
+    island_parents_.resize(body_count);
+    for (uint32 i = 0; i != body_count; ++i) island_parents_[i] = i;
+
+    // Static bodies do not join islands, since they carry no velocity
+    auto dynamic = [this](uint32 body) { return inverse_mass_[body] != 0; };
+    for (std::size_t i = 0; i != contact_count; ++i) {
+        const auto a = contact_a_[i];
+        const auto b = contact_b_[i];
+        if (!dynamic(a) || !dynamic(b)) continue;
+        const auto root_a = find_root(a);
+        const auto root_b = find_root(b);
+        if (root_a != root_b) island_parents_[root_a] = root_b;
+    }
+
+    // Numbers the islands; slots_ holds the island of each root until the
+    // bodies get their slots
+    slots_.assign(body_count, npos);
+    island_offsets_.assign(1, 0);
+    auto island_of = [this, &dynamic](std::size_t contact) {
+        const auto a = contact_a_[contact];
+        return find_root(dynamic(a) ? a : contact_b_[contact]);
+    };
+    for (std::size_t i = 0; i != contact_count; ++i) {
+        auto& island = slots_[island_of(i)];
+        if (island == npos) {
+            island = static_cast<uint32>(island_offsets_.size() - 1);
+            island_offsets_.push_back(0);
+        }
+        ++island_offsets_[island + 1];
+    }
+    const auto islands = island_offsets_.size() - 1;
+
+    island_body_offsets_.assign(islands + 1, 0);
+    for (uint32 i = 0; i != body_count; ++i) {
+        if (!dynamic(i)) continue;
+        const auto island = slots_[find_root(i)];
+        if (island != npos) ++island_body_offsets_[island + 1];
+    }
+
+    for (std::size_t i = 0; i != islands; ++i) {
+        island_offsets_[i + 1] += island_offsets_[i];
+        island_body_offsets_[i + 1] += island_body_offsets_[i];
+    }
+
+    island_contacts_.resize(contact_count);
+    auto next = island_offsets_;
+    for (std::size_t i = 0; i != contact_count; ++i) {
+        island_contacts_[next[slots_[island_of(i)]]++] = static_cast<uint32>(i);
+    }
+
+    body_islands_.resize(body_count);
+    for (uint32 i = 0; i != body_count; ++i) {
+        body_islands_[i] = dynamic(i) ? slots_[find_root(i)] : npos;
+    }
+    island_bodies_.resize(island_body_offsets_.back());
+    next = island_body_offsets_;
+    for (uint32 i = 0; i != body_count; ++i) {
+        const auto island = body_islands_[i];
+        if (island == npos) {
+            slots_[i] = npos;
+            continue;
+        }
+        slots_[i] = next[island] - island_body_offsets_[island];
+        island_bodies_[next[island]++] = i;
+    }
+}
+
+void System::solve_island(std::size_t island, Island_scratch& scratch,
+                          float dt)
+{
+    const auto first_body = island_body_offsets_[island];
+    const auto body_count = island_body_offsets_[island + 1] - first_body;
+    const auto empty_slot = body_count;
+
+    auto& velocities = scratch.velocities;
+    velocities.resize(body_count + 1);
+    for (uint32 slot = 0; slot != body_count; ++slot) {
+        const auto body = island_bodies_[first_body + slot];
+        velocities.x[slot] = velocity_x_[body];
+        velocities.y[slot] = velocity_y_[body];
+        velocities.angular[slot] = angular_velocity_[body];
+    }
+    velocities.x[empty_slot] = 0;
+    velocities.y[empty_slot] = 0;
+    velocities.angular[empty_slot] = 0;
+
+    auto& contacts = scratch.contacts;
+    contacts.clear();
+    for (auto i = island_offsets_[island]; i != island_offsets_[island + 1];
+         ++i) {
+        const auto index = island_contacts_[i];
+        const auto a = contact_a_[index];
+        const auto b = contact_b_[index];
+        const math::Vec2 point {contact_x_[index], contact_y_[index]};
+
+        Solver_contact contact;
+        contact.a = slots_[a] == npos ? empty_slot : slots_[a];
+        contact.b = slots_[b] == npos ? empty_slot : slots_[b];
+        contact.normal = math::Vec2{contact_normal_x_[index],
+                                    contact_normal_y_[index]};
+        contact.offset_a = point - math::Vec2{position_x_[a], position_y_[a]};
+        contact.offset_b = point - math::Vec2{position_x_[b], position_y_[b]};
+        contact.inverse_mass_a = inverse_mass_[a];
+        contact.inverse_inertia_a = inverse_inertia_[a];
+        contact.inverse_mass_b = inverse_mass_[b];
+        contact.inverse_inertia_b = inverse_inertia_[b];
+        contact.separation = contact_separation_[index];
+        contact.friction = std::sqrt(friction_[a] * friction_[b]);
+        contact.normal_impulse = contact_normal_impulse_[index];
+        contact.tangent_impulse = contact_tangent_impulse_[index];
+        contacts.push_back(contact);
+    }
+
+    scratch.solver.solve(contacts, velocities, empty_slot, dt, iterations_);
+
+    // Islands share no body and no contact, so they write apart
+    for (uint32 slot = 0; slot != body_count; ++slot) {
+        const auto body = island_bodies_[first_body + slot];
+        velocity_x_[body] = velocities.x[slot];
+        velocity_y_[body] = velocities.y[slot];
+        angular_velocity_[body] = velocities.angular[slot];
+    }
+    for (std::size_t i = 0; i != contacts.size(); ++i) {
+        const auto index = island_contacts_[island_offsets_[island] + i];
+        contact_normal_impulse_[index] = contacts[i].normal_impulse;
+        contact_tangent_impulse_[index] = contacts[i].tangent_impulse;
+    }
+}
+
+// The contacts are already sorted
+void System::store_impulses()
+{
+    cache_.clear();
+    for (std::size_t i = 0; i != contact_a_.size(); ++i) {
+        cache_.push_back(Cached_impulse{
+                body_pair(ids_[contact_a_[i]], ids_[contact_b_[i]]),
+                contact_feature_[i], contact_normal_impulse_[i],
+                contact_tangent_impulse_[i]});
+    }
+}
+
+}} // namespace bolder::physics
@@ -0,0 +1,55 @@
+#include "bolder/physics/collision.hpp"
+
+#include "doctest.h"
+
+using namespace bolder;
+using namespace bolder::physics;
+
+TEST_CASE("[physics] Collision of shapes") {
+    const auto box = Shape::box(1, 1);
+    const auto circle = Shape::circle(1);
+    const Pose origin {math::Vec2{0, 0}, 0};
+
+    SUBCASE("Bounds of rotated box") {
+        const auto box_bounds = bounds(box, Pose{math::Vec2{1, 2},
+                                                 0.78539816f});
+        CHECK_EQ(box_bounds.min.x, doctest::Approx(1 - 1.41421356f));
+        CHECK_EQ(box_bounds.max.y, doctest::Approx(2 + 1.41421356f));
+    }
+
+    SUBCASE("Shapes apart do not touch") {
+        const Pose far {math::Vec2{3, 0}, 0};
+        CHECK_EQ(collide(box, origin, box, far).count, 0);
+        CHECK_EQ(collide(box, origin, circle, far).count, 0);
+        CHECK_EQ(collide(circle, origin, circle, far).count, 0);
+    }
+
+    SUBCASE("Box resting on a box touches at both corners") {
+        const auto manifold = collide(box, origin, box,
+                                      Pose{math::Vec2{0.5f, 1.9f}, 0});
+        REQUIRE_EQ(manifold.count, 2);
+        CHECK_EQ(manifold.normal.x, doctest::Approx(0));
+        CHECK_EQ(manifold.normal.y, doctest::Approx(1));
+        for (const auto& point : manifold.points) {
+            CHECK_EQ(point.separation, doctest::Approx(-0.1f));
+        }
+        CHECK_NE(manifold.points[0].feature, manifold.points[1].feature);
+    }
+
+    SUBCASE("Normal points from the first shape") {
+        const Pose left {math::Vec2{-1.5f, 0}, 0};
+        const auto box_circle = collide(box, origin, circle, left);
+        REQUIRE_EQ(box_circle.count, 1);
+        CHECK_EQ(box_circle.normal.x, doctest::Approx(-1));
+        CHECK_EQ(box_circle.points[0].separation, doctest::Approx(-0.5f));
+
+        const auto circle_box = collide(circle, left, box, origin);
+        REQUIRE_EQ(circle_box.count, 1);
+        CHECK_EQ(circle_box.normal.x, doctest::Approx(1));
+
+        const auto circles = collide(circle, origin, circle, left);
+        REQUIRE_EQ(circles.count, 1);
+        CHECK_EQ(circles.normal.x, doctest::Approx(-1));
+        CHECK_EQ(circles.points[0].separation, doctest::Approx(-0.5f));
+    }
+}
@@ -0,0 +1,147 @@
+#include "bolder/physics/system.hpp"
+
+#include <cmath>
+
+#include "doctest.h"
+
+#include "bolder/exception.hpp"
+#include "bolder/thread_pool.hpp"
+#include "bolder/ecs/scheduler.hpp"
+#include "bolder/ecs/world.hpp"
+
+using namespace bolder;
+using namespace bolder::physics;
+
+namespace {
+constexpr float dt = 0.01f;
+
+Body_id add_ground(System& system, float x = 0) {
+    Body_def ground;
+    ground.position = math::Vec2{x, -1};
+    ground.shape = Shape::box(20, 1);
+    ground.density = 0;
+    return system.add_body(ground);
+}
+
+Body_id add_box(System& system, float x, float y) {
+    Body_def box;
+    box.position = math::Vec2{x, y};
+    return system.add_body(box);
+}
+} // anonymous namespace
+
+TEST_CASE("[physics] Physics system") {
+    Thread_pool pool {4};
+    System system {pool};
+
+    SUBCASE("Bodies fall under gravity") {
+        const auto box = add_box(system, 0, 10);
+        for (int i = 0; i != 100; ++i) system.step(dt);
+        CHECK_EQ(system.velocity(box).y, doctest::Approx(-10));
+        CHECK_EQ(system.position(box).y, doctest::Approx(10 - 5.05f));
+        CHECK_EQ(system.contact_count(), 0);
+        CHECK_EQ(system.island_count(), 0);
+    }
+
+    SUBCASE("Static bodies never move") {
+        const auto ground = add_ground(system);
+        system.set_velocity(ground, math::Vec2{1, 1}, 1);
+        system.step(dt);
+        CHECK_EQ(system.position(ground).y, -1);
+        CHECK_EQ(system.velocity(ground).x, 0);
+    }
+
+    SUBCASE("Box comes to rest on the ground") {
+        add_ground(system);
+        const auto box = add_box(system, 0, 2);
+        for (int i = 0; i != 300; ++i) system.step(dt);
+        CHECK_EQ(system.position(box).y, doctest::Approx(0.5f).epsilon(0.02));
+        CHECK_EQ(system.velocity(box).y, doctest::Approx(0).epsilon(0.01));
+        CHECK_EQ(system.angle(box).value(), doctest::Approx(0));
+        CHECK_EQ(system.contact_count(), 2);
+    }
+
+    SUBCASE("Stacks stand still, each stack as one island") {
+        add_ground(system);
+        constexpr int stacks = 5;
+        constexpr int height = 10;
+        std::vector<Body_id> top;
+        for (int stack = 0; stack != stacks; ++stack) {
+            const auto x = static_cast<float>(stack) * 2;
+            for (int level = 0; level != height; ++level) {
+                const auto y = 0.5f + static_cast<float>(level);
+                const auto box = add_box(system, x, y);
+                if (level == height - 1) top.push_back(box);
+            }
+        }
+
+        // Tall stacks sway a little, but stand
+        for (int i = 0; i != 500; ++i) system.step(dt);
+        CHECK_EQ(system.island_count(), stacks);
+        for (int stack = 0; stack != stacks; ++stack) {
+            const auto position =
+                    system.position(top[static_cast<std::size_t>(stack)]);
+            CHECK_LT(std::abs(position.x - static_cast<float>(stack) * 2), 0.5f);
+            CHECK_GT(position.y, height - 0.5f - 0.1f * height);
+        }
+    }
+
+    SUBCASE("Circle rolls down a slope") {
+        Body_def slope;
+        slope.shape = Shape::box(10, 0.5f);
+        slope.angle = math::Radian{-0.3f};
+        slope.density = 0;
+        system.add_body(slope);
+
+        Body_def ball;
+        ball.position = math::Vec2{0, 1.6f};
+        ball.shape = Shape::circle(0.5f);
+        const auto id = system.add_body(ball);
+        for (int i = 0; i != 100; ++i) system.step(dt);
+        CHECK_GT(system.position(id).x, 0.5f);
+        CHECK_LT(system.angular_velocity(id), 0);
+    }
+
+    SUBCASE("Removes bodies and reuses their ids") {
+        add_ground(system);
+        const auto box = add_box(system, 0, 0.5f);
+        const auto other = add_box(system, 3, 0.5f);
+        system.step(dt);
+        system.remove_body(box);
+        CHECK_FALSE(system.contains(box));
+        CHECK_EQ(system.size(), 2);
+        CHECK_THROWS_AS(system.position(box), Runtime_error);
+        CHECK_THROWS_AS(system.remove_body(box), Runtime_error);
+
+        const auto reused = add_box(system, -3, 5);
+        CHECK_EQ(reused, box);
+        CHECK_EQ(system.position(other).x, 3);
+        system.step(dt);
+        CHECK_LT(system.position(reused).y, 5);
+    }
+
+    SUBCASE("Throws on bodies without area or with negative density") {
+        Body_def def;
+        def.shape = Shape::circle(0);
+        CHECK_THROWS_AS(system.add_body(def), Runtime_error);
+        def.shape = Shape::box(1, 1);
+        def.density = -1;
+        CHECK_THROWS_AS(system.add_body(def), Runtime_error);
+    }
+}
+
+TEST_CASE("[physics] Physics system updates Rigid_body components") {
+    Thread_pool pool {2};
+    ecs::Scheduler scheduler {pool};
+    ecs::World world;
+    auto& system = scheduler.emplace_system<System>(pool);
+
+    Rigid_body body;
+    body.body = add_box(system, 1, 10);
+    const auto entity = world.create_entity(body);
+    scheduler.run(world, dt);
+    const auto* rigid_body = world.get_component<Rigid_body>(entity);
+    REQUIRE(rigid_body);
+    CHECK_EQ(rigid_body->position.x, 1);
+    CHECK_LT(rigid_body->position.y, 10);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <ostream>
+
+#include "vector.hpp"
+
+/**
+ * @file aabb.hpp
+ * @brief Axis-aligned bounding boxes.
+ */
+
+namespace bolder { namespace math {
+
+/** \addtogroup math
+ *  @{
+ */
+
+/**
+ * @brief An axis-aligned bounding box.
+ *
+ * The box is closed: points on its boundary are inside it, and boxes that
+ * touch overlap.
+ */
+template<typename T, size_t size>
+struct Aabb {
+    Vector<T, size> min; ///< Corner with the smallest coordinates
+    Vector<T, size> max; ///< Corner with the largest coordinates
+
+    /// Returns the box of a circle, or of a sphere in 3D
+    static Aabb from_circle(const Vector<T, size>& center, T radius) {
+        Aabb box;
+        for (auto i = 0u; i != size; ++i) {
+            box.min[i] = center[i] - radius;
+            box.max[i] = center[i] + radius;
+        }
+        return box;
+    }
+
+    Vector<T, size> center() const {
+        return (min + max) / 2;
+    }
+
+    Vector<T, size> extent() const {
+        return max - min;
+    }
+
+    bool contains(const Vector<T, size>& point) const {
+        for (auto i = 0u; i != size; ++i) {
+            if (point[i] < min[i] || max[i] < point[i]) return false;
+        }
+        return true;
+    }
+
+    bool overlaps(const Aabb& other) const {
+        for (auto i = 0u; i != size; ++i) {
+            if (other.max[i] < min[i] || max[i] < other.min[i]) return false;
+        }
+        return true;
+    }
+
+    /// Returns the smallest box that contains both boxes
+    friend Aabb merge(const Aabb& lhs, const Aabb& rhs) {
+        Aabb box;
+        for (auto i = 0u; i != size; ++i) {
+            box.min[i] = std::min(lhs.min[i], rhs.min[i]);
+            box.max[i] = std::max(lhs.max[i], rhs.max[i]);
+        }
+        return box;
+    }
+
+    friend bool operator==(const Aabb& lhs, const Aabb& rhs) {
+        return lhs.min == rhs.min && lhs.max == rhs.max;
+    }
+
+    friend bool operator!=(const Aabb& lhs, const Aabb& rhs) {
+        return !(lhs == rhs);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Aabb& box) {
+        return os << "aabb(" << box.min << ',' << box.max << ')';
+    }
+};
+
+using Aabb2 = Aabb<float, 2>; ///< @brief 2D float axis-aligned box type
+using Aabb3 = Aabb<float, 3>; ///< @brief 3D float axis-aligned box type
+
+/** @}*/
+
+}} // namespace bolder::math
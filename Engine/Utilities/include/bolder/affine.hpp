@@ -0,0 +1,107 @@
+#pragma once
+
+#include <ostream>
+
+#include "angle.hpp"
+#include "matrix.hpp"
+#include "simd.hpp"
+#include "vector.hpp"
+
+/**
+ * @file affine.hpp
+ * @brief 2D affine transformations.
+ */
+
+namespace bolder { namespace math {
+
+/** \addtogroup math
+ *  @{
+ */
+
+/**
+ * @brief A 2D affine transformation.
+ *
+ * It is the upper 2x3 part of a 3x3 homogeneous matrix, stored column major
+ * and padded to two SIMD registers: the linear part (x and y axes) and the
+ * translation. Composing two transformations is a handful of SIMD operations.
+ */
+class Affine2 {
+public:
+    /// Default constructor creates an identity transformation
+    Affine2() : Affine2{Vec2{1, 0}, Vec2{0, 1}, Vec2{0, 0}} {}
+
+    /// Constructs a transformation from the images of the axes and the origin
+    Affine2(Vec2 x_axis, Vec2 y_axis, Vec2 translation)
+        : elems_{x_axis.x, x_axis.y, y_axis.x, y_axis.y,
+                 translation.x, translation.y, 0, 0} {}
+
+    /// Returns a transformation that scales, then rotates, then translates
+    static Affine2 from_trs(Vec2 translation, Radian rotation, Vec2 scale);
+
+    Vec2 x_axis() const {
+        return Vec2{elems_[0], elems_[1]};
+    }
+
+    Vec2 y_axis() const {
+        return Vec2{elems_[2], elems_[3]};
+    }
+
+    Vec2 translation() const {
+        return Vec2{elems_[4], elems_[5]};
+    }
+
+    /// Applies the transformation to a point
+    Vec2 transform_point(Vec2 point) const {
+        return Vec2{elems_[0] * point.x + elems_[2] * point.y + elems_[4],
+                    elems_[1] * point.x + elems_[3] * point.y + elems_[5]};
+    }
+
+    /// Returns the equivalent 4x4 matrix, to upload as a shader uniform
+    Mat4 to_mat4() const;
+
+    /**
+     * @brief Composes two transformations.
+     * @return A transformation that applies rhs first and then lhs
+     */
+    friend Affine2 operator*(const Affine2& lhs, const Affine2& rhs) {
+        const auto linear = simd::Float4::load(lhs.elems_);
+        const auto columns = linear.shuffle<0, 1, 0, 1>();
+        const auto rows = linear.shuffle<2, 3, 2, 3>();
+
+        const auto rhs_linear = simd::Float4::load(rhs.elems_);
+        const auto rhs_translation = simd::Float4::load(rhs.elems_ + 4);
+
+        Affine2 result {Uninitialized{}};
+        (columns * rhs_linear.shuffle<0, 0, 2, 2>()
+         + rows * rhs_linear.shuffle<1, 1, 3, 3>()).store(result.elems_);
+        // The padding lanes of the translations are 0 and stay 0
+        (columns * rhs_translation.shuffle<0, 0, 2, 2>()
+         + rows * rhs_translation.shuffle<1, 1, 3, 3>()
+         + simd::Float4::load(lhs.elems_ + 4)).store(result.elems_ + 4);
+        return result;
+    }
+
+    friend bool operator==(const Affine2& lhs, const Affine2& rhs) {
+        for (auto i = 0u; i != 6; ++i) {
+            if (lhs.elems_[i] != rhs.elems_[i]) return false;
+        }
+        return true;
+    }
+
+    friend bool operator!=(const Affine2& lhs, const Affine2& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    struct Uninitialized {};
+
+    float elems_[8];
+
+    explicit Affine2(Uninitialized) {}
+};
+
+std::ostream& operator<<(std::ostream& os, const Affine2& transform);
+
+/** @}*/
+
+}} // namespace bolder::math
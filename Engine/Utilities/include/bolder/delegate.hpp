@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+ * @file delegate.hpp
+ * @brief Non-owning callable references.
+ */
+
+#include <utility>
+
+namespace bolder {
+
+/** @addtogroup utilities
+ * @{
+ */
+
+template<typename Signature>
+class Delegate;
+
+/**
+ * @brief A reference to a function, or to a member function of an object.
+ *
+ * A Delegate is an object pointer and a function pointer. The function is
+ * generated at compile time for the target, so calling a Delegate costs one
+ * indirect call, and a Delegate never allocates and is trivially copyable.
+ * Unlike std::function, it does not own its target, which must outlive it.
+ *
+ * @par Example
+ * @code{.cpp}
+ * struct Counter {
+ *     int count = 0;
+ *     void operator()(int value) { count += value; }
+ *     void reset(int value) { count = value; }
+ * };
+ *
+ * Counter counter;
+ * auto add = Delegate<void(int)>::bind(counter);
+ * auto reset = Delegate<void(int)>::bind<Counter, &Counter::reset>(counter);
+ * add(2);
+ * reset(0);
+ * @endcode
+ */
+template<typename R, typename... Args>
+class Delegate<R(Args...)> {
+public:
+    /// Creates an empty Delegate, which must not be called
+    constexpr Delegate() = default;
+
+    /// Binds a free function
+    template<R (*function)(Args...)>
+    static Delegate bind() {
+        return Delegate{nullptr, &call_function<function>};
+    }
+
+    /// Binds the operator() of an object
+    template<typename T>
+    static Delegate bind(T& object) {
+        return Delegate{address(object), &call_object<T>};
+    }
+
+    /// Binds a member function of an object
+    template<typename T, R (T::*method)(Args...)>
+    static Delegate bind(T& object) {
+        return Delegate{address(object), &call_method<T, method>};
+    }
+
+    /// Binds a const member function of an object
+    template<typename T, R (T::*method)(Args...) const>
+    static Delegate bind(const T& object) {
+        return Delegate{address(object), &call_const_method<T, method>};
+    }
+
+    R operator()(Args... args) const {
+        return stub_(object_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const {
+        return stub_ != nullptr;
+    }
+
+    /// Whether two Delegates call the same function on the same object
+    friend bool operator==(const Delegate& lhs, const Delegate& rhs) {
+        return lhs.object_ == rhs.object_ && lhs.stub_ == rhs.stub_;
+    }
+
+    friend bool operator!=(const Delegate& lhs, const Delegate& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    using Stub = R (*)(void*, Args...);
+
+    void* object_ = nullptr;
+    Stub stub_ = nullptr;
+
+    constexpr Delegate(void* object, Stub stub)
+        : object_{object}, stub_{stub} {}
+
+    template<typename T>
+    static void* address(T& object) {
+        return const_cast<void*>(static_cast<const void*>(&object));
+    }
+
+    template<R (*function)(Args...)>
+    static R call_function(void*, Args... args) {
+        return function(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    static R call_object(void* object, Args... args) {
+        return (*static_cast<T*>(object))(std::forward<Args>(args)...);
+    }
+
+    template<typename T, R (T::*method)(Args...)>
+    static R call_method(void* object, Args... args) {
+        return (static_cast<T*>(object)->*method)(std::forward<Args>(args)...);
+    }
+
+    template<typename T, R (T::*method)(Args...) const>
+    static R call_const_method(void* object, Args... args) {
+        return (static_cast<const T*>(object)->*method)(
+                    std::forward<Args>(args)...);
+    }
+};
+
+/** @}*/
+
+} // namespace bolder
@@ -12,11 +12,11 @@
   */
 
 #include <chrono>
-#include <functional>
 #include <memory>
 #include <vector>
 #include <sstream>
 
+#include "delegate.hpp"
 #include "string_literal.hpp"
 
 namespace bolder {
@@ -65,7 +65,7 @@ struct Info {
  *
  * Logging policies are callback with a Info argument.
  */
-using Log_policy = std::function<void(const Info& info)>;
+using Log_policy = Delegate<void(const Info& info)>;
 
 /// A logging policy of writing message to a file
 class Log_file_policy {
@@ -123,16 +123,37 @@ public:
 
     void flush(const Message& message) const;
 
-    void add_policy(const Log_policy& policy);
+    /**
+     * @brief Adds a policy to the logger
+     *
+     * The logger keeps a copy of the policy, which can be a function or any
+     * object that can be called with an Info.
+     */
+    template <typename Policy>
+    void add_policy(Policy policy);
 
     /// Create a temporary Message to do logging.
     Message operator()(Level level = Level::info) const;
 
 private:
+    // Owns a policy of any type
+    using Policy_storage = std::unique_ptr<void, void (*)(void*)>;
+
     const String_literal name_; // Name of the logger
-    std::vector<Log_policy> policies_;
+    std::vector<Policy_storage> policy_storage_;
+    std::vector<Log_policy> policies_; // Call the stored policies
 };
 
+template <typename Policy>
+void Logger::add_policy(Policy policy) {
+    Policy_storage stored {new Policy{std::move(policy)}, [](void* object) {
+        delete static_cast<Policy*>(object);
+    }};
+    auto& object = *static_cast<Policy*>(stored.get());
+    policy_storage_.push_back(std::move(stored));
+    policies_.push_back(Log_policy::bind(object));
+}
+
 /// Accumulate a variable of type to into log message
 template <typename T>
 Message& Message::operator<< (const T& value) {
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+#include "byte.hpp"
+
+/**
+ * @file mapped_file.hpp
+ * @brief Read-only memory mapping of files.
+ */
+
+namespace bolder {
+
+/** @addtogroup utilities
+ * @{
+ */
+
+/**
+ * @brief Maps the whole content of a file into memory for reading.
+ *
+ * Pages are loaded by the operating system when they are first touched, so
+ * mapping a large file is cheap and reading it runs at the speed of the disk
+ * cache. The mapping starts at a page boundary.
+ */
+class Mapped_file {
+public:
+    /**
+     * @brief Maps a file.
+     * @throw Runtime_error if the file cannot be opened or mapped
+     */
+    explicit Mapped_file(const char* filename);
+
+    /// Unmaps the file
+    ~Mapped_file();
+
+    Mapped_file(const Mapped_file&) = delete;
+    Mapped_file& operator=(const Mapped_file&) = delete;
+
+    /// Returns the content of the file, or nullptr if it is empty
+    const Byte* data() const {
+        return data_;
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+private:
+    const Byte* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
+/** @}*/
+
+} // namespace bolder
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <limits>
+#include <ostream>
+
+#include "vector.hpp"
+
+/**
+ * @file primitive.hpp
+ * @brief Geometric primitives for intersection tests.
+ *
+ * Axis-aligned boxes are in aabb.hpp.
+ */
+
+namespace bolder { namespace math {
+
+/** \addtogroup math
+ *  @{
+ */
+
+/**
+ * @brief A solid circle, or a solid sphere in 3D.
+ */
+template<typename T, size_t size>
+struct Sphere {
+    Vector<T, size> center;
+    T radius;
+
+    friend std::ostream& operator<<(std::ostream& os, const Sphere& sphere) {
+        return os << "sphere(" << sphere.center << ',' << sphere.radius << ')';
+    }
+};
+
+/**
+ * @brief The points within a radius of a segment.
+ */
+template<typename T, size_t size>
+struct Capsule {
+    Vector<T, size> a; ///< First end of the segment
+    Vector<T, size> b; ///< Second end of the segment
+    T radius;
+
+    friend std::ostream& operator<<(std::ostream& os, const Capsule& capsule) {
+        return os << "capsule(" << capsule.a << ',' << capsule.b << ','
+                  << capsule.radius << ')';
+    }
+};
+
+/**
+ * @brief An oriented bounding box.
+ *
+ * The box is the points center + sum of t[i] * axes[i], where each t[i] is
+ * between -half_extents[i] and half_extents[i].
+ */
+template<typename T, size_t size>
+struct Obb {
+    Vector<T, size> center;
+    Vector<T, size> axes[size]; ///< Orthonormal local axes of the box
+    Vector<T, size> half_extents;
+
+    friend std::ostream& operator<<(std::ostream& os, const Obb& box) {
+        os << "obb(" << box.center;
+        for (const auto& axis : box.axes) os << ',' << axis;
+        return os << ',' << box.half_extents << ')';
+    }
+};
+
+/**
+ * @brief A ray, or a segment if max_t is finite.
+ *
+ * The ray is the points origin + t * direction, for t between 0 and max_t.
+ * The direction does not need to be normalized.
+ */
+template<typename T, size_t size>
+struct Ray {
+    Vector<T, size> origin;
+    Vector<T, size> direction;
+    T max_t = std::numeric_limits<T>::infinity();
+
+    /// Returns the point at t along the ray
+    Vector<T, size> at(T t) const {
+        return origin + direction * t;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Ray& ray) {
+        return os << "ray(" << ray.origin << ',' << ray.direction << ','
+                  << ray.max_t << ')';
+    }
+};
+
+using Circle = Sphere<float, 2>; ///< @brief 2D float circle type
+using Sphere3 = Sphere<float, 3>; ///< @brief 3D float sphere type
+using Capsule2 = Capsule<float, 2>; ///< @brief 2D float capsule type
+using Capsule3 = Capsule<float, 3>; ///< @brief 3D float capsule type
+using Obb2 = Obb<float, 2>; ///< @brief 2D float oriented box type
+using Obb3 = Obb<float, 3>; ///< @brief 3D float oriented box type
+using Ray2 = Ray<float, 2>; ///< @brief 2D float ray type
+using Ray3 = Ray<float, 3>; ///< @brief 3D float ray type
+
+/** @}*/
+
+}} // namespace bolder::math
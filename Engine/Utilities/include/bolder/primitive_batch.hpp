@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "aabb.hpp"
+#include "integer.hpp"
+#include "primitive.hpp"
+
+/**
+ * @file primitive_batch.hpp
+ * @brief Structure of arrays containers of geometric primitives, and the
+ * queries that test one shape against all of their primitives with SIMD.
+ *
+ * The queries are compiled for 2D and 3D float primitives.
+ */
+
+namespace bolder { namespace math {
+
+/** \addtogroup math
+ *  @{
+ */
+
+/**
+ * @brief How a primitive is stored as floats in a Batch.
+ *
+ * Specializations define the number of floats as fields, and store() and
+ * load() to convert a primitive to and from them.
+ */
+template<typename Primitive>
+struct Batch_layout;
+
+/**
+ * @brief Many primitives of a type, stored as a structure of arrays.
+ *
+ * The primitives are stored in blocks of four, one SIMD register width: every
+ * block holds each field of its four primitives next to each other. The
+ * queries declared below load a field of a whole block at once, and test a
+ * shape against four primitives per step.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Batch<Aabb3> walls;
+ * walls.push_back(Aabb3{Vec3{0, 0, 0}, Vec3{1, 4, 10}});
+ * std::vector<Ray_hit> hits;
+ * raycast(walls, Ray3{eye, target - eye, 1}, hits);
+ * const bool line_of_sight = hits.empty();
+ * @endcode
+ */
+template<typename Primitive>
+class Batch {
+public:
+    using Layout = Batch_layout<Primitive>;
+
+    /// Number of primitives in a block
+    static constexpr std::size_t lanes = 4;
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /// Returns the number of blocks, the last of which may be partly used
+    std::size_t blocks() const {
+        return (size_ + lanes - 1) / lanes;
+    }
+
+    /// Returns the lanes of a field in a block
+    const float* field(std::size_t block, std::size_t field) const {
+        return data_.data() + (block * Layout::fields + field) * lanes;
+    }
+
+    Primitive operator[](std::size_t i) const {
+        assert(i < size_);
+        float values[Layout::fields];
+        for (std::size_t field = 0; field != Layout::fields; ++field) {
+            values[field] = at(i, field);
+        }
+        return Layout::load(values);
+    }
+
+    void push_back(const Primitive& primitive) {
+        if (size_ % lanes == 0) {
+            data_.resize(data_.size() + Layout::fields * lanes);
+        }
+        ++size_;
+        set(size_ - 1, primitive);
+    }
+
+    void set(std::size_t i, const Primitive& primitive) {
+        assert(i < size_);
+        float values[Layout::fields];
+        Layout::store(primitive, values);
+        for (std::size_t field = 0; field != Layout::fields; ++field) {
+            at(i, field) = values[field];
+        }
+    }
+
+    /// Removes a primitive by moving the last primitive into its place
+    void erase(std::size_t i) {
+        assert(i < size_);
+        if (i + 1 != size_) set(i, (*this)[size_ - 1]);
+        --size_;
+        if (size_ % lanes == 0) {
+            data_.resize(data_.size() - Layout::fields * lanes);
+        }
+    }
+
+    void clear() {
+        data_.clear();
+        size_ = 0;
+    }
+
+private:
+    std::vector<float> data_;
+    std::size_t size_ = 0;
+
+    float& at(std::size_t i, std::size_t field) {
+        return data_[(i / lanes * Layout::fields + field) * lanes + i % lanes];
+    }
+
+    float at(std::size_t i, std::size_t field) const {
+        return data_[(i / lanes * Layout::fields + field) * lanes + i % lanes];
+    }
+};
+
+template<typename Primitive>
+constexpr std::size_t Batch<Primitive>::lanes;
+
+template<size_t size>
+struct Batch_layout<Aabb<float, size>> {
+    static constexpr std::size_t fields = 2 * size;
+
+    static void store(const Aabb<float, size>& box, float* values) {
+        for (auto i = 0u; i != size; ++i) {
+            values[i] = box.min[i];
+            values[size + i] = box.max[i];
+        }
+    }
+
+    static Aabb<float, size> load(const float* values) {
+        Aabb<float, size> box;
+        for (auto i = 0u; i != size; ++i) {
+            box.min[i] = values[i];
+            box.max[i] = values[size + i];
+        }
+        return box;
+    }
+};
+
+template<size_t size>
+struct Batch_layout<Sphere<float, size>> {
+    static constexpr std::size_t fields = size + 1;
+
+    static void store(const Sphere<float, size>& sphere, float* values) {
+        for (auto i = 0u; i != size; ++i) values[i] = sphere.center[i];
+        values[size] = sphere.radius;
+    }
+
+    static Sphere<float, size> load(const float* values) {
+        Sphere<float, size> sphere;
+        for (auto i = 0u; i != size; ++i) sphere.center[i] = values[i];
+        sphere.radius = values[size];
+        return sphere;
+    }
+};
+
+template<size_t size>
+struct Batch_layout<Capsule<float, size>> {
+    static constexpr std::size_t fields = 2 * size + 1;
+
+    static void store(const Capsule<float, size>& capsule, float* values) {
+        for (auto i = 0u; i != size; ++i) {
+            values[i] = capsule.a[i];
+            values[size + i] = capsule.b[i];
+        }
+        values[2 * size] = capsule.radius;
+    }
+
+    static Capsule<float, size> load(const float* values) {
+        Capsule<float, size> capsule;
+        for (auto i = 0u; i != size; ++i) {
+            capsule.a[i] = values[i];
+            capsule.b[i] = values[size + i];
+        }
+        capsule.radius = values[2 * size];
+        return capsule;
+    }
+};
+
+template<size_t size>
+struct Batch_layout<Obb<float, size>> {
+    // The center, the axes, and the half extents
+    static constexpr std::size_t fields = (size + 2) * size;
+
+    static void store(const Obb<float, size>& box, float* values) {
+        for (auto i = 0u; i != size; ++i) {
+            values[i] = box.center[i];
+            for (auto j = 0u; j != size; ++j) {
+                values[(i + 1) * size + j] = box.axes[i][j];
+            }
+            values[(size + 1) * size + i] = box.half_extents[i];
+        }
+    }
+
+    static Obb<float, size> load(const float* values) {
+        Obb<float, size> box;
+        for (auto i = 0u; i != size; ++i) {
+            box.center[i] = values[i];
+            for (auto j = 0u; j != size; ++j) {
+                box.axes[i][j] = values[(i + 1) * size + j];
+            }
+            box.half_extents[i] = values[(size + 1) * size + i];
+        }
+        return box;
+    }
+};
+
+/// A primitive of a batch that a ray hits
+struct Ray_hit {
+    uint32 index; ///< Index of the primitive in the batch
+    float t; ///< Where the ray enters the primitive, see Ray::at()
+};
+
+/**
+ * @brief Finds the primitives of a batch that a ray hits.
+ * @param hits Receives the hits in the order of the primitives; its previous
+ * content is cleared
+ *
+ * A ray that starts inside a primitive hits it at t = 0. A ray that runs
+ * exactly along a face of a box may miss it.
+ */
+template<size_t size>
+void raycast(const Batch<Aabb<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits);
+
+/// @overload
+template<size_t size>
+void raycast(const Batch<Sphere<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits);
+
+/// @overload
+template<size_t size>
+void raycast(const Batch<Capsule<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits);
+
+/// @overload
+template<size_t size>
+void raycast(const Batch<Obb<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits);
+
+/**
+ * @brief Finds the primitives of a batch that overlap a box.
+ * @param indices Receives the indices of the primitives in increasing order;
+ * its previous content is cleared
+ */
+template<size_t size>
+void overlapping(const Batch<Aabb<float, size>>& batch,
+                 const Aabb<float, size>& box, std::vector<uint32>& indices);
+
+/// @overload
+template<size_t size>
+void overlapping(const Batch<Sphere<float, size>>& batch,
+                 const Aabb<float, size>& box, std::vector<uint32>& indices);
+
+/**
+ * @brief Finds the primitives of a batch that contain a point.
+ * @param indices Receives the indices of the primitives in increasing order;
+ * its previous content is cleared
+ */
+template<size_t size>
+void containing(const Batch<Aabb<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices);
+
+/// @overload
+template<size_t size>
+void containing(const Batch<Sphere<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices);
+
+/// @overload
+template<size_t size>
+void containing(const Batch<Capsule<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices);
+
+/// @overload
+template<size_t size>
+void containing(const Batch<Obb<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices);
+
+/**
+ * @brief Finds the point of every primitive of a batch that is the closest
+ * to a point.
+ * @param points Receives the closest point of primitive i at index i; a
+ * primitive that contains the point gives the point itself
+ */
+template<size_t size>
+void closest_points(const Batch<Aabb<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points);
+
+/// @overload
+template<size_t size>
+void closest_points(const Batch<Sphere<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points);
+
+/// @overload
+template<size_t size>
+void closest_points(const Batch<Capsule<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points);
+
+/// @overload
+template<size_t size>
+void closest_points(const Batch<Obb<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points);
+
+/** @}*/
+
+}} // namespace bolder::math
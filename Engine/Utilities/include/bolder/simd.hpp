@@ -0,0 +1,265 @@
+#pragma once
+
+/**
+ * @file simd.hpp
+ * @brief A thin wrapper of 4-wide float SIMD registers.
+ *
+ * SSE2 is used when the compiler targets it, and a portable scalar fallback
+ * otherwise. Defining BOLDER_NO_SIMD forces the fallback.
+ */
+
+#if !defined(BOLDER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define BOLDER_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+
+namespace bolder { namespace simd {
+
+class Float4;
+
+/**
+ * @brief The results of a comparison of the four lanes of Float4.
+ */
+class Mask4 {
+public:
+#ifdef BOLDER_SIMD_SSE2
+    /// Wraps a mask that has all the bits of a lane set if it is true
+    explicit Mask4(__m128 value) : value_{value} {}
+#else
+    /// Wraps the lanes as bits, with lane i in bit i
+    explicit Mask4(int value) : value_{value} {}
+#endif
+
+    /// Returns the lanes as bits, with lane i in bit i
+    int bits() const {
+#ifdef BOLDER_SIMD_SSE2
+        return _mm_movemask_ps(value_);
+#else
+        return value_;
+#endif
+    }
+
+    bool any() const {
+        return bits() != 0;
+    }
+
+    bool all() const {
+        return bits() == 0xF;
+    }
+
+#ifdef BOLDER_SIMD_SSE2
+    friend Mask4 operator&(Mask4 lhs, Mask4 rhs) {
+        return Mask4{_mm_and_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Mask4 operator|(Mask4 lhs, Mask4 rhs) {
+        return Mask4{_mm_or_ps(lhs.value_, rhs.value_)};
+    }
+
+private:
+    friend Float4 select(Mask4 mask, Float4 if_true, Float4 if_false);
+
+    __m128 value_;
+#else
+    friend Mask4 operator&(Mask4 lhs, Mask4 rhs) {
+        return Mask4{lhs.value_ & rhs.value_};
+    }
+
+    friend Mask4 operator|(Mask4 lhs, Mask4 rhs) {
+        return Mask4{lhs.value_ | rhs.value_};
+    }
+
+private:
+    friend Float4 select(Mask4 mask, Float4 if_true, Float4 if_false);
+
+    int value_;
+#endif
+};
+
+/**
+ * @brief Four floats that are computed on at once.
+ *
+ * Loads and stores accept any float pointer, but are faster on data aligned to
+ * 16 bytes.
+ */
+class Float4 {
+public:
+    /// Leaves the lanes uninitialized
+    Float4() = default;
+
+#ifdef BOLDER_SIMD_SSE2
+    Float4(float x, float y, float z, float w) : value_{_mm_setr_ps(x, y, z, w)}
+    {}
+
+    /// Returns a Float4 with all four lanes set to value
+    static Float4 splat(float value) {
+        return Float4{_mm_set1_ps(value)};
+    }
+
+    static Float4 load(const float* data) {
+        return Float4{_mm_loadu_ps(data)};
+    }
+
+    void store(float* data) const {
+        _mm_storeu_ps(data, value_);
+    }
+
+    /// Returns the lanes in the order i0, i1, i2, i3
+    template<int i0, int i1, int i2, int i3>
+    Float4 shuffle() const {
+        return Float4{_mm_shuffle_ps(value_, value_,
+                                     _MM_SHUFFLE(i3, i2, i1, i0))};
+    }
+
+    friend Float4 operator+(Float4 lhs, Float4 rhs) {
+        return Float4{_mm_add_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Float4 operator-(Float4 lhs, Float4 rhs) {
+        return Float4{_mm_sub_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Float4 operator*(Float4 lhs, Float4 rhs) {
+        return Float4{_mm_mul_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Float4 operator/(Float4 lhs, Float4 rhs) {
+        return Float4{_mm_div_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Float4 min(Float4 lhs, Float4 rhs) {
+        return Float4{_mm_min_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Float4 max(Float4 lhs, Float4 rhs) {
+        return Float4{_mm_max_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Float4 sqrt(Float4 value) {
+        return Float4{_mm_sqrt_ps(value.value_)};
+    }
+
+    /// Returns the lanes of if_true where mask is true, and of if_false else
+    friend Float4 select(Mask4 mask, Float4 if_true, Float4 if_false) {
+        return Float4{_mm_or_ps(_mm_and_ps(mask.value_, if_true.value_),
+                                _mm_andnot_ps(mask.value_, if_false.value_))};
+    }
+
+    friend Mask4 operator<(Float4 lhs, Float4 rhs) {
+        return Mask4{_mm_cmplt_ps(lhs.value_, rhs.value_)};
+    }
+
+    friend Mask4 operator<=(Float4 lhs, Float4 rhs) {
+        return Mask4{_mm_cmple_ps(lhs.value_, rhs.value_)};
+    }
+
+private:
+    __m128 value_;
+
+    explicit Float4(__m128 value) : value_{value} {}
+#else
+    Float4(float x, float y, float z, float w) : value_{x, y, z, w} {}
+
+    /// Returns a Float4 with all four lanes set to value
+    static Float4 splat(float value) {
+        return Float4{value, value, value, value};
+    }
+
+    static Float4 load(const float* data) {
+        return Float4{data[0], data[1], data[2], data[3]};
+    }
+
+    void store(float* data) const {
+        for (auto i = 0; i != 4; ++i) data[i] = value_[i];
+    }
+
+    /// Returns the lanes in the order i0, i1, i2, i3
+    template<int i0, int i1, int i2, int i3>
+    Float4 shuffle() const {
+        return Float4{value_[i0], value_[i1], value_[i2], value_[i3]};
+    }
+
+    friend Float4 operator+(Float4 lhs, Float4 rhs) {
+        return lanewise(lhs, rhs, [](float a, float b) { return a + b; });
+    }
+
+    friend Float4 operator-(Float4 lhs, Float4 rhs) {
+        return lanewise(lhs, rhs, [](float a, float b) { return a - b; });
+    }
+
+    friend Float4 operator*(Float4 lhs, Float4 rhs) {
+        return lanewise(lhs, rhs, [](float a, float b) { return a * b; });
+    }
+
+    friend Float4 operator/(Float4 lhs, Float4 rhs) {
+        return lanewise(lhs, rhs, [](float a, float b) { return a / b; });
+    }
+
+    // Like SSE, returns rhs if either lane is NaN
+    friend Float4 min(Float4 lhs, Float4 rhs) {
+        return lanewise(lhs, rhs,
+                        [](float a, float b) { return a < b ? a : b; });
+    }
+
+    friend Float4 max(Float4 lhs, Float4 rhs) {
+        return lanewise(lhs, rhs,
+                        [](float a, float b) { return a > b ? a : b; });
+    }
+
+    friend Float4 sqrt(Float4 value) {
+        return Float4{std::sqrt(value.value_[0]), std::sqrt(value.value_[1]),
+                      std::sqrt(value.value_[2]), std::sqrt(value.value_[3])};
+    }
+
+    /// Returns the lanes of if_true where mask is true, and of if_false else
+    friend Float4 select(Mask4 mask, Float4 if_true, Float4 if_false) {
+        Float4 result;
+        for (auto i = 0; i != 4; ++i) {
+            result.value_[i] = ((mask.value_ >> i) & 1) ? if_true.value_[i]
+                                                        : if_false.value_[i];
+        }
+        return result;
+    }
+
+    friend Mask4 operator<(Float4 lhs, Float4 rhs) {
+        return compare(lhs, rhs, [](float a, float b) { return a < b; });
+    }
+
+    friend Mask4 operator<=(Float4 lhs, Float4 rhs) {
+        return compare(lhs, rhs, [](float a, float b) { return a <= b; });
+    }
+
+private:
+    float value_[4];
+
+    template<typename Binary_op>
+    static Float4 lanewise(Float4 lhs, Float4 rhs, Binary_op op) {
+        return Float4{op(lhs.value_[0], rhs.value_[0]),
+                      op(lhs.value_[1], rhs.value_[1]),
+                      op(lhs.value_[2], rhs.value_[2]),
+                      op(lhs.value_[3], rhs.value_[3])};
+    }
+
+    template<typename Compare>
+    static Mask4 compare(Float4 lhs, Float4 rhs, Compare op) {
+        int bits = 0;
+        for (auto i = 0; i != 4; ++i) {
+            if (op(lhs.value_[i], rhs.value_[i])) bits |= 1 << i;
+        }
+        return Mask4{bits};
+    }
+#endif
+
+    friend Mask4 operator>(Float4 lhs, Float4 rhs) {
+        return rhs < lhs;
+    }
+
+    friend Mask4 operator>=(Float4 lhs, Float4 rhs) {
+        return rhs <= lhs;
+    }
+};
+
+}} // namespace bolder::simd
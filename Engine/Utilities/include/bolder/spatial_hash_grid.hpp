@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "aabb.hpp"
+#include "integer.hpp"
+#include "vector.hpp"
+
+/**
+ * @file spatial_hash_grid.hpp
+ * @brief Proximity queries over points in the plane.
+ */
+
+namespace bolder { namespace math {
+
+/** \addtogroup math
+ *  @{
+ */
+
+/**
+ * @brief A uniform grid of square cells that finds the points near a position
+ * or inside a box.
+ *
+ * Only the cells that points fall in are stored, in a hash table keyed on their
+ * coordinates, so the grid is unbounded. Every cell keeps the positions and ids
+ * of its points in one contiguous bucket, and queries read whole buckets
+ * without touching any other memory. Inserting, moving and erasing a point are
+ * O(1).
+ *
+ * Points are identified by dense ids chosen by the user, such as entity
+ * indices; the grid keeps a table indexed by id. Cells are kept once created,
+ * so that points moving back and forth do not reallocate buckets, until
+ * clear().
+ *
+ * Cells about the size of the typical query radius work best.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Spatial_hash_grid grid {64};
+ * grid.insert(entity.index(), position);
+ * grid.move(entity.index(), position + velocity * dt);
+ * grid.query_radius(cursor, 16, [](Spatial_hash_grid::Id id, Vec2 position) {
+ *     pick(id);
+ * });
+ * @endcode
+ */
+class Spatial_hash_grid {
+public:
+    using Id = uint32;
+
+    /// @param cell_size Side of the cells, which must be positive
+    explicit Spatial_hash_grid(float cell_size);
+    ~Spatial_hash_grid();
+
+    Spatial_hash_grid(Spatial_hash_grid&&) = default;
+    Spatial_hash_grid& operator=(Spatial_hash_grid&&) = default;
+
+    float cell_size() const {
+        return cell_size_;
+    }
+
+    /// Returns the number of points
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool contains(Id id) const {
+        return id < records_.size() && records_[id].cell != npos;
+    }
+
+    /// Returns the position of a point that the grid contains
+    Vec2 position(Id id) const {
+        const auto& record = records_[id];
+        return cells_[record.cell].items[record.slot].position;
+    }
+
+    /**
+     * @brief Adds a point.
+     * @throw Runtime_error if the grid already contains id
+     */
+    void insert(Id id, Vec2 position);
+
+    /**
+     * @brief Moves a point, which only touches the buckets when it changes
+     * cell.
+     * @throw Runtime_error if the grid does not contain id
+     */
+    void move(Id id, Vec2 position);
+
+    /**
+     * @brief Removes a point.
+     * @throw Runtime_error if the grid does not contain id
+     */
+    void erase(Id id);
+
+    /// Removes all the points and releases the cells
+    void clear();
+
+    /// Calls f(id, position) for every point within radius of center
+    template<typename Function>
+    void query_radius(Vec2 center, float radius, Function f) const;
+
+    /// Calls f(id, position) for every point inside box
+    template<typename Function>
+    void query_aabb(const Aabb2& box, Function f) const;
+
+    /**
+     * @brief Finds the k points nearest to a position.
+     * @param out Receives the ids, from the nearest; it has fewer than k ids
+     * if the grid has fewer than k points
+     *
+     * Searches rings of cells around the position, until no point in the next
+     * ring can be nearer than the k found ones.
+     */
+    void query_nearest(Vec2 point, std::size_t k, std::vector<Id>& out) const;
+
+private:
+    static constexpr uint32 npos = ~0u;
+
+    struct Item {
+        Vec2 position;
+        Id id;
+    };
+
+    struct Cell {
+        int32 x;
+        int32 y;
+        std::vector<Item> items;
+    };
+
+    struct Record {
+        uint32 cell; // npos if the grid does not contain the id
+        uint32 slot; // Index in the bucket of the cell
+    };
+
+    float cell_size_;
+    float inverse_cell_size_;
+    std::vector<Cell> cells_;
+    // Open addressing hash table of indices into cells_, npos for no cell
+    std::vector<uint32> table_;
+    std::vector<Record> records_;
+    std::size_t size_ = 0;
+
+    int32 coordinate(float value) const;
+    uint32 slot_of(int32 x, int32 y) const;
+    uint32 find_cell(int32 x, int32 y) const;
+    uint32 find_or_add_cell(int32 x, int32 y);
+    void rehash(std::size_t capacity);
+    void add_item(Id id, Vec2 position, uint32 cell);
+    void remove_item(const Record& record);
+
+    // Calls f with every cell whose coordinates are in a range, or with every
+    // cell if the grid has fewer cells than the range
+    template<typename Function>
+    void visit_cells(const Aabb2& box, Function f) const;
+};
+
+template<typename Function>
+void Spatial_hash_grid::query_radius(Vec2 center, float radius, Function f) const
+{
+    const auto radius_square = radius * radius;
+    visit_cells(Aabb2::from_circle(center, radius),
+                [&f, center, radius_square](const Cell& cell) {
+        for (const auto& item : cell.items) {
+            if ((item.position - center).length_square() <= radius_square) {
+                f(item.id, item.position);
+            }
+        }
+    });
+}
+
+template<typename Function>
+void Spatial_hash_grid::query_aabb(const Aabb2& box, Function f) const
+{
+    visit_cells(box, [&f, &box](const Cell& cell) {
+        for (const auto& item : cell.items) {
+            if (box.contains(item.position)) {
+                f(item.id, item.position);
+            }
+        }
+    });
+}
+
+template<typename Function>
+void Spatial_hash_grid::visit_cells(const Aabb2& box, Function f) const
+{
+    const auto min_x = coordinate(box.min.x);
+    const auto min_y = coordinate(box.min.y);
+    const auto max_x = coordinate(box.max.x);
+    const auto max_y = coordinate(box.max.y);
+    const auto range = static_cast<uint64>(int64{max_x} - min_x + 1)
+            * static_cast<uint64>(int64{max_y} - min_y + 1);
+
+    if (range > cells_.size()) {
+        for (const auto& cell : cells_) {
+            if (min_x <= cell.x && cell.x <= max_x
+                    && min_y <= cell.y && cell.y <= max_y) {
+                f(cell);
+            }
+        }
+        return;
+    }
+
+    for (auto y = min_y; y <= max_y; ++y) {
+        for (auto x = min_x; x <= max_x; ++x) {
+            const auto cell = find_cell(x, y);
+            if (cell != npos) f(cells_[cell]);
+        }
+    }
+}
+
+/** @}*/
+
+}} // namespace bolder::math
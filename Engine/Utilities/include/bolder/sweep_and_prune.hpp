@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "aabb.hpp"
+#include "integer.hpp"
+
+/**
+ * @file sweep_and_prune.hpp
+ * @brief Broadphase collision detection of 2D boxes.
+ */
+
+namespace bolder { namespace math {
+
+/** \addtogroup math
+ *  @{
+ */
+
+/**
+ * @brief Finds the pairs of overlapping boxes among many moving boxes.
+ *
+ * The boxes are kept sorted by their minimum x. Every find_pairs() sweeps the
+ * sorted boxes: a box can only overlap the boxes after it that start before it
+ * ends on x, and these are tested against it eight at a time with SIMD, on
+ * structure of arrays copies of the box bounds.
+ *
+ * Boxes move little from one step to the next, so the order of the last step
+ * is almost sorted, and insertion sort restores it in close to linear time.
+ * Boxes inserted since the last step are sorted on their own and merged in.
+ *
+ * Boxes are identified by dense ids chosen by the user, such as entity
+ * indices; the broadphase keeps a table indexed by id.
+ *
+ * @par Example
+ * @code{.cpp}
+ * Sweep_and_prune broadphase;
+ * broadphase.insert(entity.index(), bounds);
+ * // Every step
+ * broadphase.update(entity.index(), moved_bounds);
+ * broadphase.find_pairs(pairs);
+ * @endcode
+ */
+class Sweep_and_prune {
+public:
+    using Id = uint32;
+
+    /// Two overlapping boxes, where first < second
+    struct Pair {
+        Id first;
+        Id second;
+
+        friend bool operator==(const Pair& lhs, const Pair& rhs) {
+            return lhs.first == rhs.first && lhs.second == rhs.second;
+        }
+
+        friend bool operator<(const Pair& lhs, const Pair& rhs) {
+            return lhs.first < rhs.first
+                    || (lhs.first == rhs.first && lhs.second < rhs.second);
+        }
+    };
+
+    Sweep_and_prune();
+    ~Sweep_and_prune();
+
+    Sweep_and_prune(Sweep_and_prune&&) = default;
+    Sweep_and_prune& operator=(Sweep_and_prune&&) = default;
+
+    /// Returns the number of boxes
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool contains(Id id) const {
+        return id < records_.size() && records_[id].alive;
+    }
+
+    /// Returns the box of an id that the broadphase contains
+    const Aabb2& box(Id id) const {
+        return records_[id].box;
+    }
+
+    /**
+     * @brief Adds a box.
+     * @throw Runtime_error if the broadphase already contains id, or if a
+     * coordinate of the box is infinite or NaN
+     */
+    void insert(Id id, const Aabb2& box);
+
+    /**
+     * @brief Moves a box, which takes effect at the next find_pairs().
+     * @throw Runtime_error if the broadphase does not contain id, or if a
+     * coordinate of the box is infinite or NaN
+     */
+    void update(Id id, const Aabb2& box);
+
+    /**
+     * @brief Removes a box.
+     * @throw Runtime_error if the broadphase does not contain id
+     */
+    void erase(Id id);
+
+    /**
+     * @brief Finds every pair of overlapping boxes.
+     * @param out Receives the pairs, in no particular order; its previous
+     * content is cleared, but its memory is reused
+     *
+     * Boxes that touch overlap.
+     */
+    void find_pairs(std::vector<Pair>& out);
+
+private:
+    struct Record {
+        Aabb2 box;
+        bool alive;
+        // Whether the id has an entry in order_, which can outlive the box
+        // until the next find_pairs()
+        bool listed;
+    };
+
+    struct Entry {
+        Aabb2 box;
+        Id id;
+    };
+
+    std::vector<Record> records_;
+    // Entries sorted by min_x up to sorted_, followed by the inserted ones
+    std::vector<Entry> order_;
+    std::size_t sorted_ = 0;
+    std::size_t size_ = 0;
+    // Bounds of the boxes in sorted order, padded to read 8 past the end
+    std::vector<float> min_x_;
+    std::vector<float> max_x_;
+    std::vector<float> min_y_;
+    std::vector<float> max_y_;
+
+    void sort();
+    void sweep(std::vector<Pair>& out) const;
+};
+
+/** @}*/
+
+}} // namespace bolder::math
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "byte.hpp"
+
+/**
+ * @file thread_pool.hpp
+ * @brief A pool of worker threads that run tasks.
+ */
+
+namespace bolder {
+
+/// Size of the cache lines that threads must not share to not slow each other
+constexpr std::size_t cache_line_size = 64;
+
+/**
+ * @brief A fixed set of worker threads that run submitted tasks.
+ *
+ * Tasks are run in the order they are submitted, but any number of them may run
+ * at the same time. Destroying the pool waits for every submitted task to
+ * finish.
+ */
+class Thread_pool {
+public:
+    using Task = std::function<void()>;
+
+    /// Starts thread_count worker threads, or one per hardware thread if 0
+    explicit Thread_pool(unsigned thread_count = 0);
+
+    /// Runs the remaining tasks and joins the worker threads
+    ~Thread_pool();
+
+    Thread_pool(const Thread_pool&) = delete;
+    Thread_pool& operator=(const Thread_pool&) = delete;
+
+    /// Schedules a task to run on a worker thread
+    void submit(Task task);
+
+    /// Returns the number of worker threads
+    unsigned size() const {
+        return static_cast<unsigned>(workers_.size());
+    }
+
+private:
+    std::mutex mutex_; // Protects tasks_ and stopping_
+    std::condition_variable task_available_;
+    std::deque<Task> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void work();
+};
+
+/**
+ * @brief Calls f for every index in [0, count), spreading the calls over the
+ * calling thread and the worker threads of a pool.
+ *
+ * The indices are split into one contiguous range per thread. A thread takes
+ * indices from the front of its own range, and steals from the ranges of the
+ * other threads once its own is empty, so uneven work still keeps every thread
+ * busy. The calling thread takes part, so parallel_for can be called from a
+ * task of the same pool without deadlocking, even when every worker is busy.
+ *
+ * @param f Called as f(participant, index), where participant is in
+ * [0, pool.size() + 1) and is distinct for the threads that run at the same
+ * time, so it can index per-thread data. The caller is participant 0.
+ *
+ * Returns after every call finishes. If calls throw, the other calls still
+ * run and the first exception is rethrown.
+ */
+void parallel_for(Thread_pool& pool, std::size_t count,
+                  std::function<void(std::size_t participant,
+                                     std::size_t index)> f);
+
+/**
+ * @brief A value for every participant of a parallel_for, each on cache lines
+ * of its own.
+ *
+ * A participant can change its own value without synchronization, and without
+ * writing to a cache line that another participant reads.
+ */
+template<typename T>
+class Per_participant {
+public:
+    /// Constructs a T from args for each of the pool.size() + 1 participants
+    template<typename... Args>
+    explicit Per_participant(const Thread_pool& pool, const Args&... args);
+
+    ~Per_participant();
+
+    Per_participant(const Per_participant&) = delete;
+    Per_participant& operator=(const Per_participant&) = delete;
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    T& operator[](std::size_t participant) {
+        return slots_[participant].value;
+    }
+
+    const T& operator[](std::size_t participant) const {
+        return slots_[participant].value;
+    }
+
+private:
+    struct alignas(T) alignas(cache_line_size) Slot {
+        template<typename... Args>
+        explicit Slot(const Args&... args) : value(args...) {}
+
+        T value;
+    };
+
+    std::size_t size_;
+    // Over-aligned allocations need C++17, so the slots are aligned by hand
+    std::unique_ptr<Byte[]> storage_;
+    Slot* slots_;
+};
+
+template<typename T>
+template<typename... Args>
+Per_participant<T>::Per_participant(const Thread_pool& pool,
+                                    const Args&... args)
+    : size_{pool.size() + 1u},
+      storage_{new Byte[size_ * sizeof(Slot) + alignof(Slot)]}
+{
+    void* first = storage_.get();
+    auto space = size_ * sizeof(Slot) + alignof(Slot);
+    slots_ = static_cast<Slot*>(std::align(alignof(Slot), size_ * sizeof(Slot),
+                                           first, space));
+
+    std::size_t constructed = 0;
+    try {
+        for (; constructed != size_; ++constructed) {
+            new (&slots_[constructed]) Slot(args...);
+        }
+    } catch (...) {
+        while (constructed != 0) {
+            slots_[--constructed].~Slot();
+        }
+        throw;
+    }
+}
+
+template<typename T>
+Per_participant<T>::~Per_participant()
+{
+    for (std::size_t i = 0; i != size_; ++i) {
+        slots_[i].~Slot();
+    }
+}
+
+}
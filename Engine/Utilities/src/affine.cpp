@@ -0,0 +1,35 @@
+#include "affine.hpp"
+
+#include <cmath>
+
+namespace bolder { namespace math {
+
+Affine2 Affine2::from_trs(Vec2 translation, Radian rotation, Vec2 scale)
+{
+    const auto cos = std::cos(rotation.value());
+    const auto sin = std::sin(rotation.value());
+    return Affine2{Vec2{cos * scale.x, sin * scale.x},
+                   Vec2{-sin * scale.y, cos * scale.y},
+                   translation};
+}
+
+Mat4 Affine2::to_mat4() const
+{
+    Mat4 result(1);
+    result[0][0] = elems_[0];
+    result[0][1] = elems_[1];
+    result[1][0] = elems_[2];
+    result[1][1] = elems_[3];
+    result[3][0] = elems_[4];
+    result[3][1] = elems_[5];
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const Affine2& transform)
+{
+    os << "affine(" << transform.x_axis() << ',' << transform.y_axis() << ','
+       << transform.translation() << ')';
+    return os;
+}
+
+}} // namespace bolder::math
@@ -80,18 +80,12 @@ void Logger::flush(const Message& message) const {
     Info info{std::move(time), name_,
                 message.level_, message.buffer_.str()};
 
-    for (auto policy : policies_) {
+    for (const auto& policy : policies_) {
         policy(info);
     }
 
 }
 
-/// Adds a policy to the logger
-void Logger::add_policy(const Log_policy& policy)
-{
-    policies_.push_back(policy);
-}
-
 /**
  * @brief Create a temporary Message to do logging.
  * @param level Level of the logging
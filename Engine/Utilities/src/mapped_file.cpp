@@ -0,0 +1,99 @@
+#include "mapped_file.hpp"
+#include "exception.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bolder {
+
+#ifdef _WIN32
+
+Mapped_file::Mapped_file(const char* filename)
+{
+    const auto file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ,
+                                  nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw Runtime_error {"Cannot open file to map"};
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw Runtime_error {"Cannot get the size of file to map"};
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping_ == nullptr) {
+        throw Runtime_error {"Cannot map file"};
+    }
+
+    data_ = static_cast<const Byte*>(
+                MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        CloseHandle(mapping_);
+        throw Runtime_error {"Cannot map file"};
+    }
+}
+
+Mapped_file::~Mapped_file()
+{
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+    }
+}
+
+#else
+
+Mapped_file::Mapped_file(const char* filename)
+{
+    const auto file = open(filename, O_RDONLY);
+    if (file == -1) {
+        throw Runtime_error {"Cannot open file to map"};
+    }
+
+    struct stat status;
+    if (fstat(file, &status) == -1) {
+        close(file);
+        throw Runtime_error {"Cannot get the size of file to map"};
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ == 0) {
+        close(file);
+        return;
+    }
+
+    auto* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        throw Runtime_error {"Cannot map file"};
+    }
+    data_ = static_cast<const Byte*>(data);
+}
+
+Mapped_file::~Mapped_file()
+{
+    if (data_ != nullptr) {
+        munmap(const_cast<Byte*>(data_), size_);
+    }
+}
+
+#endif
+
+} // namespace bolder
@@ -0,0 +1,541 @@
+#include "primitive_batch.hpp"
+
+#include <limits>
+
+#include "simd.hpp"
+
+namespace bolder { namespace math {
+
+namespace {
+using simd::Float4;
+using simd::Mask4;
+
+constexpr std::size_t lanes = 4;
+
+// A coordinate of a vector in every lane of a block
+template<size_t size>
+struct Wide_vector {
+    Float4 elems[size];
+
+    Float4& operator[](size_t i) {
+        return elems[i];
+    }
+
+    const Float4& operator[](size_t i) const {
+        return elems[i];
+    }
+};
+
+template<size_t size>
+Wide_vector<size> splat(const Vector<float, size>& vector)
+{
+    Wide_vector<size> result;
+    for (auto i = 0u; i != size; ++i) result[i] = Float4::splat(vector[i]);
+    return result;
+}
+
+// Loads the vector that starts at a field of the primitives of a block
+template<size_t size, typename Primitive>
+Wide_vector<size> load(const Batch<Primitive>& batch, std::size_t block,
+                       std::size_t field)
+{
+    Wide_vector<size> result;
+    for (auto i = 0u; i != size; ++i) {
+        result[i] = Float4::load(batch.field(block, field + i));
+    }
+    return result;
+}
+
+template<size_t size>
+Wide_vector<size> operator+(const Wide_vector<size>& lhs,
+                            const Wide_vector<size>& rhs)
+{
+    Wide_vector<size> result;
+    for (auto i = 0u; i != size; ++i) result[i] = lhs[i] + rhs[i];
+    return result;
+}
+
+template<size_t size>
+Wide_vector<size> operator-(const Wide_vector<size>& lhs,
+                            const Wide_vector<size>& rhs)
+{
+    Wide_vector<size> result;
+    for (auto i = 0u; i != size; ++i) result[i] = lhs[i] - rhs[i];
+    return result;
+}
+
+template<size_t size>
+Wide_vector<size> operator*(const Wide_vector<size>& lhs, Float4 rhs)
+{
+    Wide_vector<size> result;
+    for (auto i = 0u; i != size; ++i) result[i] = lhs[i] * rhs;
+    return result;
+}
+
+template<size_t size>
+Float4 dot(const Wide_vector<size>& lhs, const Wide_vector<size>& rhs)
+{
+    auto result = lhs[0] * rhs[0];
+    for (auto i = 1u; i != size; ++i) result = result + lhs[i] * rhs[i];
+    return result;
+}
+
+Float4 clamp(Float4 value, Float4 low, Float4 high)
+{
+    return max(low, min(value, high));
+}
+
+// Returns the bits of the lanes of a block that hold primitives
+template<typename Primitive>
+int used_lanes(const Batch<Primitive>& batch, std::size_t block)
+{
+    const auto remaining = batch.size() - block * lanes;
+    return remaining >= lanes ? 0xF : (1 << remaining) - 1;
+}
+
+void append_indices(std::size_t block, int bits, std::vector<uint32>& indices)
+{
+    for (auto lane = 0u; bits != 0; ++lane, bits >>= 1) {
+        if (bits & 1) {
+            indices.push_back(static_cast<uint32>(block * lanes + lane));
+        }
+    }
+}
+
+void append_hits(std::size_t block, int bits, Float4 t,
+                 std::vector<Ray_hit>& hits)
+{
+    float ts[lanes];
+    t.store(ts);
+    for (auto lane = 0u; bits != 0; ++lane, bits >>= 1) {
+        if (bits & 1) {
+            hits.push_back(Ray_hit{static_cast<uint32>(block * lanes + lane),
+                                   ts[lane]});
+        }
+    }
+}
+
+template<size_t size>
+void store_points(std::size_t block, int bits, const Wide_vector<size>& wide,
+                  std::vector<Vector<float, size>>& points)
+{
+    float coordinates[size][lanes];
+    for (auto i = 0u; i != size; ++i) wide[i].store(coordinates[i]);
+    for (auto lane = 0u; bits != 0; ++lane, bits >>= 1) {
+        if ((bits & 1) == 0) continue;
+        auto& point = points[block * lanes + lane];
+        for (auto i = 0u; i != size; ++i) point[i] = coordinates[i][lane];
+    }
+}
+
+// Where a ray enters the primitives of a block, and whether it does so
+// before max_t
+struct Ray_entry {
+    Float4 t;
+    Mask4 hit;
+};
+
+template<size_t size>
+Ray_entry ray_sphere(const Ray<float, size>& ray,
+                     const Wide_vector<size>& center, Float4 radius)
+{
+    const auto a = Float4::splat(dot(ray.direction, ray.direction));
+    const auto m = splat(ray.origin) - center;
+    const auto b = dot(m, splat(ray.direction));
+    const auto c = dot(m, m) - radius * radius;
+    const auto discriminant = b * b - a * c;
+    const auto root = sqrt(max(discriminant, Float4::splat(0)));
+
+    const auto zero = Float4::splat(0);
+    const auto enter = (zero - b - root) / a;
+    const auto exit = (zero - b + root) / a;
+    return Ray_entry{max(enter, zero),
+                     (discriminant >= zero) & (exit >= zero)
+                     & (enter <= Float4::splat(ray.max_t))};
+}
+
+// Returns the closest points to a point on segments from a to b
+template<size_t size>
+Wide_vector<size> closest_on_segment(const Wide_vector<size>& point,
+                                     const Wide_vector<size>& a,
+                                     const Wide_vector<size>& b)
+{
+    const auto ab = b - a;
+    // A segment whose ends coincide is a point
+    const auto length_square = max(dot(ab, ab),
+                                   Float4::splat(1e-30f));
+    const auto t = clamp(dot(point - a, ab) / length_square,
+                         Float4::splat(0), Float4::splat(1));
+    return a + ab * t;
+}
+
+// Returns the points at most radius away from centers closest to a point
+template<size_t size>
+Wide_vector<size> closest_in_ball(const Wide_vector<size>& point,
+                                  const Wide_vector<size>& center,
+                                  Float4 radius)
+{
+    const auto offset = point - center;
+    const auto distance = sqrt(dot(offset, offset));
+    const auto outside = distance > radius;
+    // Inside lanes may divide by zero, but are not selected
+    const auto scale = radius / distance;
+    const auto on_surface = center + offset * scale;
+
+    Wide_vector<size> result;
+    for (auto i = 0u; i != size; ++i) {
+        result[i] = select(outside, on_surface[i], point[i]);
+    }
+    return result;
+}
+} // anonymous namespace
+
+template<size_t size>
+void raycast(const Batch<Aabb<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits)
+{
+    hits.clear();
+    Float4 origin[size];
+    Float4 inverse_direction[size];
+    for (auto i = 0u; i != size; ++i) {
+        origin[i] = Float4::splat(ray.origin[i]);
+        inverse_direction[i] = Float4::splat(1 / ray.direction[i]);
+    }
+
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        // Clips the ray between the two planes of every axis
+        auto enter = Float4::splat(0);
+        auto exit = Float4::splat(ray.max_t);
+        for (auto i = 0u; i != size; ++i) {
+            const auto t1 = (Float4::load(batch.field(block, i)) - origin[i])
+                    * inverse_direction[i];
+            const auto t2 = (Float4::load(batch.field(block, size + i))
+                             - origin[i]) * inverse_direction[i];
+            enter = max(enter, min(t1, t2));
+            exit = min(exit, max(t1, t2));
+        }
+        append_hits(block, (enter <= exit).bits() & used_lanes(batch, block),
+                    enter, hits);
+    }
+}
+
+template<size_t size>
+void raycast(const Batch<Sphere<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits)
+{
+    hits.clear();
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto entry = ray_sphere(ray, load<size>(batch, block, 0),
+                                      Float4::load(batch.field(block, size)));
+        append_hits(block, entry.hit.bits() & used_lanes(batch, block),
+                    entry.t, hits);
+    }
+}
+
+template<size_t size>
+void raycast(const Batch<Capsule<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits)
+{
+    hits.clear();
+    const auto zero = Float4::splat(0);
+    const auto infinity = Float4::splat(std::numeric_limits<float>::infinity());
+    const auto origin = splat(ray.origin);
+    const auto direction = splat(ray.direction);
+    const auto direction_square = dot(ray.direction, ray.direction);
+
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto a = load<size>(batch, block, 0);
+        const auto b = load<size>(batch, block, size);
+        const auto radius = Float4::load(batch.field(block, 2 * size));
+
+        // The capsule is the union of the balls at its ends and the cylinder
+        // between them, so the ray enters it where it first enters either
+        const auto entry_a = ray_sphere(ray, a, radius);
+        const auto entry_b = ray_sphere(ray, b, radius);
+        auto first = select(entry_a.hit, entry_a.t, infinity);
+        first = select(entry_b.hit, min(first, entry_b.t), first);
+
+        // Solves |m + t n - (md + t nd) / dd * d|^2 = r^2 for the cylinder,
+        // from Real-Time Collision Detection 5.3.7
+        const auto d = b - a;
+        const auto m = origin - a;
+        const auto md = dot(m, d);
+        const auto nd = dot(direction, d);
+        const auto dd = dot(d, d);
+        const auto nn = Float4::splat(direction_square);
+        const auto quadratic = dd * nn - nd * nd;
+        const auto linear = dd * dot(m, direction) - nd * md;
+        const auto constant = dd * (dot(m, m) - radius * radius) - md * md;
+        const auto discriminant = linear * linear - quadratic * constant;
+        const auto t = (zero - linear - sqrt(max(discriminant, zero)))
+                / quadratic;
+        const auto projection = md + t * nd;
+        // Rays almost parallel to the axis enter through the balls
+        const auto on_side = (quadratic > dd * nn * Float4::splat(1e-6f))
+                & (discriminant >= zero) & (t >= zero)
+                & (projection >= zero) & (projection <= dd);
+        first = select(on_side, min(first, t), first);
+
+        const auto offset = origin - closest_on_segment(origin, a, b);
+        const auto inside = dot(offset, offset) <= radius * radius;
+        first = select(inside, zero, first);
+        const auto found = first <= Float4::splat(ray.max_t);
+        append_hits(block, found.bits() & used_lanes(batch, block), first,
+                    hits);
+    }
+}
+
+template<size_t size>
+void raycast(const Batch<Obb<float, size>>& batch,
+             const Ray<float, size>& ray, std::vector<Ray_hit>& hits)
+{
+    hits.clear();
+    const auto zero = Float4::splat(0);
+    const auto origin = splat(ray.origin);
+    const auto direction = splat(ray.direction);
+
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto relative = origin
+                - load<size>(batch, block, 0);
+
+        // Clips the ray between the two planes of every axis of the box
+        auto enter = zero;
+        auto exit = Float4::splat(ray.max_t);
+        for (auto i = 0u; i != size; ++i) {
+            const auto axis = load<size>(
+                        batch, block, (i + 1) * size);
+            const auto half_extent = Float4::load(
+                        batch.field(block, (size + 1) * size + i));
+            const auto local_origin = dot(relative, axis);
+            const auto local_direction = dot(direction, axis);
+            const auto t1 = (zero - half_extent - local_origin)
+                    / local_direction;
+            const auto t2 = (half_extent - local_origin) / local_direction;
+            enter = max(enter, min(t1, t2));
+            exit = min(exit, max(t1, t2));
+        }
+        append_hits(block, (enter <= exit).bits() & used_lanes(batch, block),
+                    enter, hits);
+    }
+}
+
+template<size_t size>
+void overlapping(const Batch<Aabb<float, size>>& batch,
+                 const Aabb<float, size>& box, std::vector<uint32>& indices)
+{
+    indices.clear();
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        auto bits = used_lanes(batch, block);
+        for (auto i = 0u; i != size; ++i) {
+            const auto min = Float4::load(batch.field(block, i));
+            const auto max = Float4::load(batch.field(block, size + i));
+            bits &= ((min <= Float4::splat(box.max[i]))
+                     & (Float4::splat(box.min[i]) <= max)).bits();
+        }
+        append_indices(block, bits, indices);
+    }
+}
+
+template<size_t size>
+void overlapping(const Batch<Sphere<float, size>>& batch,
+                 const Aabb<float, size>& box, std::vector<uint32>& indices)
+{
+    indices.clear();
+    const auto box_min = splat(box.min);
+    const auto box_max = splat(box.max);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto center = load<size>(batch, block, 0);
+        const auto radius = Float4::load(batch.field(block, size));
+
+        // Distance from the center to the closest point of the box
+        auto distance_square = Float4::splat(0);
+        for (auto i = 0u; i != size; ++i) {
+            const auto offset = center[i]
+                    - clamp(center[i], box_min[i], box_max[i]);
+            distance_square = distance_square + offset * offset;
+        }
+        const auto overlaps = distance_square <= radius * radius;
+        append_indices(block, overlaps.bits() & used_lanes(batch, block),
+                       indices);
+    }
+}
+
+template<size_t size>
+void containing(const Batch<Aabb<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices)
+{
+    indices.clear();
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        auto bits = used_lanes(batch, block);
+        for (auto i = 0u; i != size; ++i) {
+            const auto coordinate = Float4::splat(point[i]);
+            const auto min = Float4::load(batch.field(block, i));
+            const auto max = Float4::load(batch.field(block, size + i));
+            bits &= ((min <= coordinate) & (coordinate <= max)).bits();
+        }
+        append_indices(block, bits, indices);
+    }
+}
+
+template<size_t size>
+void containing(const Batch<Sphere<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices)
+{
+    indices.clear();
+    const auto wide_point = splat(point);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto offset = wide_point
+                - load<size>(batch, block, 0);
+        const auto radius = Float4::load(batch.field(block, size));
+        const auto inside = dot(offset, offset) <= radius * radius;
+        append_indices(block, inside.bits() & used_lanes(batch, block),
+                       indices);
+    }
+}
+
+template<size_t size>
+void containing(const Batch<Capsule<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices)
+{
+    indices.clear();
+    const auto wide_point = splat(point);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto a = load<size>(batch, block, 0);
+        const auto b = load<size>(batch, block, size);
+        const auto radius = Float4::load(batch.field(block, 2 * size));
+        const auto offset = wide_point - closest_on_segment(wide_point, a, b);
+        const auto inside = dot(offset, offset) <= radius * radius;
+        append_indices(block, inside.bits() & used_lanes(batch, block),
+                       indices);
+    }
+}
+
+template<size_t size>
+void containing(const Batch<Obb<float, size>>& batch,
+                const Vector<float, size>& point, std::vector<uint32>& indices)
+{
+    indices.clear();
+    const auto wide_point = splat(point);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto relative = wide_point
+                - load<size>(batch, block, 0);
+        auto bits = used_lanes(batch, block);
+        for (auto i = 0u; i != size; ++i) {
+            const auto local = dot(relative, load<size>(
+                                       batch, block, (i + 1) * size));
+            const auto half_extent = Float4::load(
+                        batch.field(block, (size + 1) * size + i));
+            bits &= ((local <= half_extent)
+                     & (Float4::splat(0) - half_extent <= local)).bits();
+        }
+        append_indices(block, bits, indices);
+    }
+}
+
+template<size_t size>
+void closest_points(const Batch<Aabb<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points)
+{
+    points.resize(batch.size());
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        Wide_vector<size> closest;
+        for (auto i = 0u; i != size; ++i) {
+            closest[i] = clamp(Float4::splat(point[i]),
+                               Float4::load(batch.field(block, i)),
+                               Float4::load(batch.field(block, size + i)));
+        }
+        store_points(block, used_lanes(batch, block), closest, points);
+    }
+}
+
+template<size_t size>
+void closest_points(const Batch<Sphere<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points)
+{
+    points.resize(batch.size());
+    const auto wide_point = splat(point);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto closest = closest_in_ball(
+                    wide_point, load<size>(batch, block, 0),
+                    Float4::load(batch.field(block, size)));
+        store_points(block, used_lanes(batch, block), closest, points);
+    }
+}
+
+template<size_t size>
+void closest_points(const Batch<Capsule<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points)
+{
+    points.resize(batch.size());
+    const auto wide_point = splat(point);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto a = load<size>(batch, block, 0);
+        const auto b = load<size>(batch, block, size);
+        const auto closest = closest_in_ball(
+                    wide_point, closest_on_segment(wide_point, a, b),
+                    Float4::load(batch.field(block, 2 * size)));
+        store_points(block, used_lanes(batch, block), closest, points);
+    }
+}
+
+template<size_t size>
+void closest_points(const Batch<Obb<float, size>>& batch,
+                    const Vector<float, size>& point,
+                    std::vector<Vector<float, size>>& points)
+{
+    points.resize(batch.size());
+    const auto wide_point = splat(point);
+    for (std::size_t block = 0; block != batch.blocks(); ++block) {
+        const auto center = load<size>(batch, block, 0);
+        const auto relative = wide_point - center;
+
+        // Clamps the point in the coordinates of the box
+        auto closest = center;
+        for (auto i = 0u; i != size; ++i) {
+            const auto axis = load<size>(
+                        batch, block, (i + 1) * size);
+            const auto half_extent = Float4::load(
+                        batch.field(block, (size + 1) * size + i));
+            const auto local = clamp(dot(relative, axis),
+                                     Float4::splat(0) - half_extent,
+                                     half_extent);
+            closest = closest + axis * local;
+        }
+        store_points(block, used_lanes(batch, block), closest, points);
+    }
+}
+
+#define BOLDER_INSTANTIATE_QUERIES(Primitive, size)                          \
+    template void raycast(const Batch<Primitive<float, size>>&,              \
+                          const Ray<float, size>&, std::vector<Ray_hit>&);   \
+    template void containing(const Batch<Primitive<float, size>>&,           \
+                             const Vector<float, size>&,                     \
+                             std::vector<uint32>&);                          \
+    template void closest_points(const Batch<Primitive<float, size>>&,       \
+                                 const Vector<float, size>&,                 \
+                                 std::vector<Vector<float, size>>&);
+
+BOLDER_INSTANTIATE_QUERIES(Aabb, 2)
+BOLDER_INSTANTIATE_QUERIES(Aabb, 3)
+BOLDER_INSTANTIATE_QUERIES(Sphere, 2)
+BOLDER_INSTANTIATE_QUERIES(Sphere, 3)
+BOLDER_INSTANTIATE_QUERIES(Capsule, 2)
+BOLDER_INSTANTIATE_QUERIES(Capsule, 3)
+BOLDER_INSTANTIATE_QUERIES(Obb, 2)
+BOLDER_INSTANTIATE_QUERIES(Obb, 3)
+
+#undef BOLDER_INSTANTIATE_QUERIES
+
+template void overlapping(const Batch<Aabb2>&, const Aabb2&,
+                          std::vector<uint32>&);
+template void overlapping(const Batch<Aabb3>&, const Aabb3&,
+                          std::vector<uint32>&);
+template void overlapping(const Batch<Circle>&, const Aabb2&,
+                          std::vector<uint32>&);
+template void overlapping(const Batch<Sphere3>&, const Aabb3&,
+                          std::vector<uint32>&);
+
+}} // namespace bolder::math
@@ -0,0 +1,225 @@
+#include "spatial_hash_grid.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include "exception.hpp"
+
+namespace bolder { namespace math {
+
+namespace {
+// Cell coordinates are clamped to this, so that ranges of cells and rings
+// around a cell never overflow
+constexpr float max_coordinate = 1 << 30;
+
+// The hash table grows when it is half full
+constexpr std::size_t min_table_size = 16;
+} // anonymous namespace
+
+constexpr uint32 Spatial_hash_grid::npos;
+
+Spatial_hash_grid::Spatial_hash_grid(float cell_size)
+    : cell_size_{cell_size}, inverse_cell_size_{1 / cell_size},
+      table_(min_table_size, npos)
+{
+    assert(cell_size > 0);
+}
+
+Spatial_hash_grid::~Spatial_hash_grid() = default;
+
+void Spatial_hash_grid::insert(Id id, Vec2 position)
+{
+    if (contains(id)) {
+        throw Runtime_error {"Insert a point that the grid already contains"};
+    }
+    if (id >= records_.size()) {
+        records_.resize(std::size_t{id} + 1, Record{npos, 0});
+    }
+
+    add_item(id, position, find_or_add_cell(coordinate(position.x),
+                                            coordinate(position.y)));
+    ++size_;
+}
+
+void Spatial_hash_grid::move(Id id, Vec2 position)
+{
+    if (!contains(id)) {
+        throw Runtime_error {"Move a point that the grid does not contain"};
+    }
+
+    const auto record = records_[id];
+    auto& cell = cells_[record.cell];
+    const auto x = coordinate(position.x);
+    const auto y = coordinate(position.y);
+    if (cell.x == x && cell.y == y) {
+        cell.items[record.slot].position = position;
+        return;
+    }
+
+    remove_item(record);
+    add_item(id, position, find_or_add_cell(x, y));
+}
+
+void Spatial_hash_grid::erase(Id id)
+{
+    if (!contains(id)) {
+        throw Runtime_error {"Erase a point that the grid does not contain"};
+    }
+
+    remove_item(records_[id]);
+    records_[id].cell = npos;
+    --size_;
+}
+
+void Spatial_hash_grid::clear()
+{
+    cells_.clear();
+    table_.assign(min_table_size, npos);
+    records_.clear();
+    size_ = 0;
+}
+
+void Spatial_hash_grid::query_nearest(Vec2 point, std::size_t k,
+                                      std::vector<Id>& out) const
+{
+    out.clear();
+    if (k == 0 || size_ == 0) return;
+
+    // Max-heap of the squared distances and ids of the nearest points so far
+    std::vector<std::pair<float, Id>> nearest;
+    nearest.reserve(std::min(k, size_));
+    auto visit = [&nearest, k, point](const Cell& cell) {
+        for (const auto& item : cell.items) {
+            const auto distance = (item.position - point).length_square();
+            if (nearest.size() < k) {
+                nearest.emplace_back(distance, item.id);
+                std::push_heap(nearest.begin(), nearest.end());
+            } else if (distance < nearest.front().first) {
+                std::pop_heap(nearest.begin(), nearest.end());
+                nearest.back() = std::make_pair(distance, item.id);
+                std::push_heap(nearest.begin(), nearest.end());
+            }
+        }
+    };
+
+    const auto x = coordinate(point.x);
+    const auto y = coordinate(point.y);
+    for (int32 ring = 0;; ++ring) {
+        // Scanning all the cells is cheaper than searching any further
+        const auto side = 2 * static_cast<uint64>(ring) + 1;
+        if (side * side > cells_.size()) {
+            nearest.clear();
+            std::for_each(cells_.begin(), cells_.end(), visit);
+            break;
+        }
+
+        auto visit_at = [this, &visit](int32 cell_x, int32 cell_y) {
+            const auto cell = find_cell(cell_x, cell_y);
+            if (cell != npos) visit(cells_[cell]);
+        };
+        for (auto i = x - ring; i <= x + ring; ++i) {
+            visit_at(i, y - ring);
+            if (ring != 0) visit_at(i, y + ring);
+        }
+        for (auto j = y - ring + 1; j < y + ring; ++j) {
+            visit_at(x - ring, j);
+            visit_at(x + ring, j);
+        }
+
+        // Distance from the point to the cells outside of the ring
+        const auto bound = std::min(
+                    {point.x - static_cast<float>(x - ring) * cell_size_,
+                     static_cast<float>(x + ring + 1) * cell_size_ - point.x,
+                     point.y - static_cast<float>(y - ring) * cell_size_,
+                     static_cast<float>(y + ring + 1) * cell_size_ - point.y});
+        if (nearest.size() == k && nearest.front().first <= bound * bound) {
+            break;
+        }
+    }
+
+    std::sort_heap(nearest.begin(), nearest.end());
+    for (const auto& found : nearest) {
+        out.push_back(found.second);
+    }
+}
+
+int32 Spatial_hash_grid::coordinate(float value) const
+{
+    const auto scaled = std::floor(value * inverse_cell_size_);
+    return static_cast<int32>(std::max(-max_coordinate,
+                                       std::min(scaled, max_coordinate)));
+}
+
+// Returns the slot of the hash table where the search for a cell starts
+uint32 Spatial_hash_grid::slot_of(int32 x, int32 y) const
+{
+    auto hash = static_cast<uint32>(x) * 0x9E3779B1u
+            ^ static_cast<uint32>(y) * 0x85EBCA77u;
+    hash ^= hash >> 15;
+    return hash & static_cast<uint32>(table_.size() - 1);
+}
+
+// Returns the index of a cell, or npos if there is no such cell
+uint32 Spatial_hash_grid::find_cell(int32 x, int32 y) const
+{
+    const auto mask = static_cast<uint32>(table_.size() - 1);
+    for (auto slot = slot_of(x, y);; slot = (slot + 1) & mask) {
+        const auto cell = table_[slot];
+        if (cell == npos
+                || (cells_[cell].x == x && cells_[cell].y == y)) {
+            return cell;
+        }
+    }
+}
+
+uint32 Spatial_hash_grid::find_or_add_cell(int32 x, int32 y)
+{
+    const auto found = find_cell(x, y);
+    if (found != npos) return found;
+
+    if (2 * (cells_.size() + 1) > table_.size()) {
+        rehash(2 * table_.size());
+    }
+    const auto cell = static_cast<uint32>(cells_.size());
+    cells_.push_back(Cell{x, y, {}});
+
+    const auto mask = static_cast<uint32>(table_.size() - 1);
+    auto slot = slot_of(x, y);
+    while (table_[slot] != npos) slot = (slot + 1) & mask;
+    table_[slot] = cell;
+    return cell;
+}
+
+void Spatial_hash_grid::rehash(std::size_t capacity)
+{
+    table_.assign(capacity, npos);
+    const auto mask = static_cast<uint32>(capacity - 1);
+    for (auto cell = 0u; cell != cells_.size(); ++cell) {
+        auto slot = slot_of(cells_[cell].x, cells_[cell].y);
+        while (table_[slot] != npos) slot = (slot + 1) & mask;
+        table_[slot] = cell;
+    }
+}
+
+void Spatial_hash_grid::add_item(Id id, Vec2 position, uint32 cell)
+{
+    auto& items = cells_[cell].items;
+    records_[id] = Record{cell, static_cast<uint32>(items.size())};
+    items.push_back(Item{position, id});
+}
+
+// Removes an item from its bucket by moving the last item of the bucket into
+// its slot
+void Spatial_hash_grid::remove_item(const Record& record)
+{
+    auto& items = cells_[record.cell].items;
+    if (record.slot + 1 != items.size()) {
+        items[record.slot] = items.back();
+        records_[items[record.slot].id].slot = record.slot;
+    }
+    items.pop_back();
+}
+
+}} // namespace bolder::math
@@ -0,0 +1,169 @@
+#include "sweep_and_prune.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "exception.hpp"
+#include "simd.hpp"
+
+namespace bolder { namespace math {
+
+namespace {
+// Number of boxes that every iteration of the sweep tests, as two SIMD tests
+constexpr std::size_t batch = 8;
+
+// The sweep stops at the padding past the last box, whose min x is infinite,
+// so it needs boxes that end before infinity
+bool finite(const Aabb2& box)
+{
+    return std::isfinite(box.min.x) && std::isfinite(box.min.y)
+            && std::isfinite(box.max.x) && std::isfinite(box.max.y);
+}
+} // anonymous namespace
+
+Sweep_and_prune::Sweep_and_prune() = default;
+
+Sweep_and_prune::~Sweep_and_prune() = default;
+
+void Sweep_and_prune::insert(Id id, const Aabb2& box)
+{
+    if (contains(id)) {
+        throw Runtime_error {"Insert a box that the broadphase already contains"};
+    }
+    if (!finite(box)) {
+        throw Runtime_error {"Insert a box that is not finite"};
+    }
+    if (id >= records_.size()) {
+        records_.resize(std::size_t{id} + 1, Record{Aabb2{}, false, false});
+    }
+
+    auto& record = records_[id];
+    record.box = box;
+    record.alive = true;
+    if (!record.listed) {
+        record.listed = true;
+        order_.push_back(Entry{box, id});
+    }
+    ++size_;
+}
+
+void Sweep_and_prune::update(Id id, const Aabb2& box)
+{
+    if (!contains(id)) {
+        throw Runtime_error {"Update a box that the broadphase does not contain"};
+    }
+    if (!finite(box)) {
+        throw Runtime_error {"Update a box to one that is not finite"};
+    }
+    records_[id].box = box;
+}
+
+void Sweep_and_prune::erase(Id id)
+{
+    if (!contains(id)) {
+        throw Runtime_error {"Erase a box that the broadphase does not contain"};
+    }
+    records_[id].alive = false;
+    --size_;
+}
+
+void Sweep_and_prune::find_pairs(std::vector<Pair>& out)
+{
+    out.clear();
+    sort();
+    sweep(out);
+}
+
+// Sorts the entries by the current boxes and copies their bounds in order
+void Sweep_and_prune::sort()
+{
+    // Drops the erased boxes and refreshes the keys, which keeps the order
+    std::size_t kept = 0;
+    std::size_t sorted = 0;
+    for (std::size_t i = 0; i != order_.size(); ++i) {
+        auto entry = order_[i];
+        auto& record = records_[entry.id];
+        if (!record.alive) {
+            record.listed = false;
+            continue;
+        }
+
+        entry.box = record.box;
+        order_[kept++] = entry;
+        if (i < sorted_) ++sorted;
+    }
+    order_.resize(kept);
+
+    auto less = [](const Entry& lhs, const Entry& rhs) {
+        return lhs.box.min.x < rhs.box.min.x;
+    };
+    for (std::size_t i = 1; i < sorted; ++i) {
+        const auto entry = order_[i];
+        auto j = i;
+        for (; j != 0 && less(entry, order_[j - 1]); --j) {
+            order_[j] = order_[j - 1];
+        }
+        order_[j] = entry;
+    }
+    const auto middle = order_.begin() + static_cast<std::ptrdiff_t>(sorted);
+    std::sort(middle, order_.end(), less);
+    std::inplace_merge(order_.begin(), middle, order_.end(), less);
+    sorted_ = order_.size();
+
+    // Boxes past the end start after every box ends, which stops the sweep
+    const auto padded = order_.size() + batch;
+    min_x_.resize(padded);
+    max_x_.resize(padded);
+    min_y_.resize(padded);
+    max_y_.resize(padded);
+    for (std::size_t i = 0; i != order_.size(); ++i) {
+        const auto& box = order_[i].box;
+        min_x_[i] = box.min.x;
+        max_x_[i] = box.max.x;
+        min_y_[i] = box.min.y;
+        max_y_[i] = box.max.y;
+    }
+    std::fill(min_x_.begin() + static_cast<std::ptrdiff_t>(order_.size()),
+              min_x_.end(), std::numeric_limits<float>::infinity());
+}
+
+void Sweep_and_prune::sweep(std::vector<Pair>& out) const
+{
+    using simd::Float4;
+
+    const auto* min_xs = min_x_.data();
+    const auto* min_ys = min_y_.data();
+    const auto* max_ys = max_y_.data();
+    const auto* entries = order_.data();
+    const auto count = order_.size();
+    for (std::size_t i = 0; i != count; ++i) {
+        const auto max_x = max_x_[i];
+        const auto max_x4 = Float4::splat(max_x);
+        const auto min_y4 = Float4::splat(min_ys[i]);
+        const auto max_y4 = Float4::splat(max_ys[i]);
+        const auto id = entries[i].id;
+
+        // The boxes after i that start before it ends on x are consecutive
+        for (auto j = i + 1;; j += batch) {
+            auto test = [=](std::size_t k) {
+                return (Float4::load(min_xs + k) <= max_x4)
+                        & (Float4::load(min_ys + k) <= max_y4)
+                        & (Float4::load(max_ys + k) >= min_y4);
+            };
+            auto bits = test(j).bits() | test(j + 4).bits() << 4;
+
+            for (; bits != 0; bits &= bits - 1) {
+                auto lane = 0u;
+                while (((bits >> lane) & 1) == 0) ++lane;
+                const auto other = entries[j + lane].id;
+                out.push_back(id < other ? Pair{id, other} : Pair{other, id});
+            }
+            // The boxes are sorted, so the last one of the batch tells
+            // whether all of them start before box i ends
+            if (!(min_xs[j + batch - 1] <= max_x)) break;
+        }
+    }
+}
+
+}} // namespace bolder::math
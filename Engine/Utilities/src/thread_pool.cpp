@@ -0,0 +1,142 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <utility>
+
+namespace bolder {
+
+namespace {
+// The indices that a participant of parallel_for takes first, padded to a
+// cache line since other participants steal from it
+struct Index_range {
+    std::atomic<std::size_t> next;
+    std::size_t end;
+    char padding[64 - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+};
+
+// Shared by the tasks of a parallel_for, which may start after it returns
+struct Parallel_for_state {
+    std::function<void(std::size_t, std::size_t)> function;
+    std::size_t count = 0;
+    std::size_t participant_count = 0;
+    std::unique_ptr<Index_range[]> ranges;
+    std::atomic<std::size_t> finished {0};
+
+    std::mutex mutex; // Protects error
+    std::condition_variable all_finished;
+    std::exception_ptr error;
+
+    void run(std::size_t participant) {
+        for (auto i = 0u; i != participant_count; ++i) {
+            auto& range = ranges[(participant + i) % participant_count];
+            for (;;) {
+                const auto index =
+                        range.next.fetch_add(1, std::memory_order_relaxed);
+                if (index >= range.end) break;
+
+                try {
+                    function(participant, index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock {mutex};
+                    if (!error) error = std::current_exception();
+                }
+
+                // Notify under the lock, so that the wakeup cannot be missed
+                if (finished.fetch_add(1, std::memory_order_acq_rel) + 1
+                        == count) {
+                    std::lock_guard<std::mutex> lock {mutex};
+                    all_finished.notify_all();
+                }
+            }
+        }
+    }
+};
+} // anonymous namespace
+
+Thread_pool::Thread_pool(unsigned thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    workers_.reserve(thread_count);
+    for (auto i = 0u; i != thread_count; ++i) {
+        workers_.emplace_back([this] { work(); });
+    }
+}
+
+Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void Thread_pool::submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        tasks_.push_back(std::move(task));
+    }
+    task_available_.notify_one();
+}
+
+void Thread_pool::work()
+{
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock {mutex_};
+            task_available_.wait(lock, [this] {
+                return stopping_ || !tasks_.empty();
+            });
+            if (tasks_.empty()) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void parallel_for(Thread_pool& pool, std::size_t count,
+                  std::function<void(std::size_t, std::size_t)> f)
+{
+    if (count == 0) return;
+
+    auto state = std::make_shared<Parallel_for_state>();
+    state->function = std::move(f);
+    state->count = count;
+    state->participant_count = std::min<std::size_t>(pool.size() + 1u, count);
+    state->ranges.reset(new Index_range[state->participant_count]);
+    for (auto i = 0u; i != state->participant_count; ++i) {
+        state->ranges[i].next = count * i / state->participant_count;
+        state->ranges[i].end = count * (i + 1) / state->participant_count;
+    }
+
+    for (std::size_t i = 1; i != state->participant_count; ++i) {
+        pool.submit([state, i] { state->run(i); });
+    }
+    state->run(0);
+
+    std::unique_lock<std::mutex> lock {state->mutex};
+    state->all_finished.wait(lock, [&state] {
+        return state->finished.load(std::memory_order_acquire) == state->count;
+    });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+}
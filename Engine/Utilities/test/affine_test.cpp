@@ -0,0 +1,61 @@
+#include <sstream>
+#include "doctest.h"
+
+#include "bolder/affine.hpp"
+
+using namespace bolder::math;
+
+TEST_CASE("[math] 2D affine transformations") {
+    const Affine2 identity;
+    const Affine2 translate {Vec2{1, 0}, Vec2{0, 1}, Vec2{3, 4}};
+    const Affine2 scale {Vec2{2, 0}, Vec2{0, 5}, Vec2{0, 0}};
+
+    SUBCASE("Default constructed transformation is identity") {
+        REQUIRE_EQ(identity.transform_point(Vec2{7, 9}), Vec2{7, 9});
+    }
+
+    SUBCASE("Print transformation") {
+        std::stringstream ss;
+        ss << translate;
+        REQUIRE_EQ(ss.str(), "affine(vec(1,0),vec(0,1),vec(3,4))");
+    }
+
+    SUBCASE("Composition applies the right hand side first") {
+        REQUIRE_EQ(translate * identity, translate);
+        REQUIRE_EQ(identity * translate, translate);
+
+        const auto scale_then_translate = translate * scale;
+        REQUIRE_EQ(scale_then_translate.transform_point(Vec2{1, 1}),
+                   Vec2{5, 9});
+
+        const auto translate_then_scale = scale * translate;
+        REQUIRE_EQ(translate_then_scale.transform_point(Vec2{1, 1}),
+                   Vec2{8, 25});
+    }
+
+    SUBCASE("Create transformation from translation, rotation and scale") {
+        const auto transform = Affine2::from_trs(Vec2{10, 20}, Radian{pi / 2},
+                                                 Vec2{2, 3});
+        const auto point = transform.transform_point(Vec2{1, 1});
+        REQUIRE_EQ(point.x, doctest::Approx(7));
+        REQUIRE_EQ(point.y, doctest::Approx(22));
+
+        const auto composed = transform * Affine2::from_trs(
+                    Vec2{1, 1}, Radian{0}, Vec2{1, 1});
+        const auto expectation = transform.transform_point(Vec2{2, 2});
+        REQUIRE_EQ(composed.transform_point(Vec2{1, 1}).x,
+                   doctest::Approx(expectation.x));
+        REQUIRE_EQ(composed.transform_point(Vec2{1, 1}).y,
+                   doctest::Approx(expectation.y));
+    }
+
+    SUBCASE("Convert transformation to a 4x4 matrix") {
+        const auto expectation = Mat4 {
+            2, 0, 0, 0,
+            0, 5, 0, 0,
+            0, 0, 1, 0,
+            3, 4, 0, 1
+        };
+        REQUIRE_EQ((translate * scale).to_mat4(), expectation);
+    }
+}
@@ -0,0 +1,72 @@
+#include "doctest.h"
+
+#include <type_traits>
+
+#include "bolder/delegate.hpp"
+
+using namespace bolder;
+
+namespace {
+int twice(int value) {
+    return value * 2;
+}
+
+struct Accumulator {
+    int total = 0;
+
+    int operator()(int value) {
+        return total += value;
+    }
+
+    int reset(int value) {
+        return total = value;
+    }
+
+    int plus(int value) const {
+        return total + value;
+    }
+};
+} // anonymous namespace
+
+TEST_CASE("Delegate") {
+    using Callback = Delegate<int(int)>;
+    static_assert(std::is_trivially_copyable<Callback>::value,
+                  "Delegates must be trivially copyable");
+
+    Accumulator accumulator;
+
+    SUBCASE("Calls free functions") {
+        const auto callback = Callback::bind<&twice>();
+        REQUIRE_EQ(callback(21), 42);
+    }
+
+    SUBCASE("Calls operator() of objects") {
+        const auto callback = Callback::bind(accumulator);
+        callback(1);
+        callback(2);
+        REQUIRE_EQ(accumulator.total, 3);
+    }
+
+    SUBCASE("Calls member functions") {
+        const auto reset = Callback::bind<Accumulator, &Accumulator::reset>(
+                    accumulator);
+        reset(10);
+        REQUIRE_EQ(accumulator.total, 10);
+
+        const Accumulator& constant = accumulator;
+        const auto plus = Callback::bind<Accumulator, &Accumulator::plus>(
+                    constant);
+        REQUIRE_EQ(plus(5), 15);
+    }
+
+    SUBCASE("Compares by target") {
+        Accumulator other;
+        CHECK_FALSE(Callback{});
+        CHECK(Callback::bind(accumulator));
+        CHECK_EQ(Callback::bind(accumulator), Callback::bind(accumulator));
+        CHECK_NE(Callback::bind(accumulator), Callback::bind(other));
+        CHECK_NE(Callback::bind(accumulator),
+                 (Callback::bind<Accumulator, &Accumulator::reset>(
+                      accumulator)));
+    }
+}
@@ -29,6 +29,25 @@ TEST_CASE("logger work with stream style logging") {
     REQUIRE_EQ(ss.str(), "[Debug] Test output 2a");
 }
 
+namespace {
+int logged_count = 0;
+
+void count_log(const logging::Info&) {
+    ++logged_count;
+}
+}
+
+TEST_CASE("logger calls every policy") {
+    std::ostringstream ss;
+    Logger test_logger {"[Test]"};
+    test_logger.add_policy(count_log);
+    test_logger.add_policy(Log_test_policy{ss});
+    test_logger(logging::Level::info) << "first";
+    test_logger(logging::Level::error) << "second";
+    REQUIRE_EQ(logged_count, 2);
+    REQUIRE_EQ(ss.str(), "[Info] first[Error] second");
+}
+
 // Implementation details of the log test policy
 Log_test_policy::Log_test_policy(std::ostringstream& ss) : ss_{ss} {}
 
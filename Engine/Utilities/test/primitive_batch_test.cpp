@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "doctest.h"
+
+#include "bolder/primitive_batch.hpp"
+
+using namespace bolder;
+using namespace bolder::math;
+
+namespace {
+// Distances from a point to the primitives, which are 0 inside them
+template<size_t size>
+float distance(const Aabb<float, size>& box, const Vector<float, size>& point)
+{
+    auto offset = point;
+    for (auto i = 0u; i != size; ++i) {
+        offset[i] -= std::max(box.min[i], std::min(point[i], box.max[i]));
+    }
+    return offset.length();
+}
+
+template<size_t size>
+float distance(const Sphere<float, size>& sphere,
+               const Vector<float, size>& point)
+{
+    return std::max(0.f, (point - sphere.center).length() - sphere.radius);
+}
+
+template<size_t size>
+float distance(const Capsule<float, size>& capsule,
+               const Vector<float, size>& point)
+{
+    const auto ab = capsule.b - capsule.a;
+    const auto t = std::max(0.f, std::min(dot(point - capsule.a, ab)
+                                          / ab.length_square(), 1.f));
+    return distance(Sphere<float, size>{capsule.a + ab * t, capsule.radius},
+                    point);
+}
+
+template<size_t size>
+float distance(const Obb<float, size>& box, const Vector<float, size>& point)
+{
+    Vector<float, size> outside;
+    for (auto i = 0u; i != size; ++i) {
+        const auto local = dot(point - box.center, box.axes[i]);
+        outside[i] = local - std::max(-box.half_extents[i],
+                                      std::min(local, box.half_extents[i]));
+    }
+    return outside.length();
+}
+
+template<size_t size>
+struct Generator {
+    std::mt19937 random {7};
+
+    float uniform(float low, float high) {
+        return std::uniform_real_distribution<float>{low, high}(random);
+    }
+
+    Vector<float, size> point(float range = 10) {
+        Vector<float, size> result;
+        for (auto i = 0u; i != size; ++i) result[i] = uniform(-range, range);
+        return result;
+    }
+
+    void make(Aabb<float, size>& box) {
+        box.min = point();
+        box.max = box.min + point(2) + point(2);
+        for (auto i = 0u; i != size; ++i) {
+            if (box.max[i] < box.min[i]) std::swap(box.min[i], box.max[i]);
+        }
+    }
+
+    void make(Sphere<float, size>& sphere) {
+        sphere = Sphere<float, size>{point(), uniform(0.2f, 3)};
+    }
+
+    void make(Capsule<float, size>& capsule) {
+        const auto a = point();
+        capsule = Capsule<float, size>{a, a + point(3), uniform(0.2f, 2)};
+    }
+
+    // Gram-Schmidt orthonormalizes random axes
+    void make(Obb<float, size>& box) {
+        box.center = point();
+        for (auto i = 0u; i != size; ++i) {
+            auto axis = point(1);
+            for (auto j = 0u; j != i; ++j) {
+                axis -= box.axes[j] * dot(axis, box.axes[j]);
+            }
+            box.axes[i] = axis / axis.length();
+            box.half_extents[i] = uniform(0.2f, 3);
+        }
+    }
+};
+
+template<typename Primitive, size_t size>
+void check_queries()
+{
+    Generator<size> generator;
+    std::vector<Primitive> primitives(37);
+    Batch<Primitive> batch;
+    for (auto& primitive : primitives) {
+        generator.make(primitive);
+        batch.push_back(primitive);
+    }
+    REQUIRE_EQ(batch.size(), primitives.size());
+    REQUIRE_EQ(batch.blocks(), 10);
+
+    std::vector<uint32> indices;
+    std::vector<Vector<float, size>> points;
+    std::vector<Ray_hit> hits;
+    for (auto query = 0; query != 40; ++query) {
+        const auto point = generator.point(12);
+
+        containing(batch, point, indices);
+        std::vector<uint32> expected;
+        for (auto i = 0u; i != primitives.size(); ++i) {
+            if (distance(primitives[i], point) == 0) expected.push_back(i);
+        }
+        REQUIRE_EQ(indices, expected);
+
+        closest_points(batch, point, points);
+        REQUIRE_EQ(points.size(), primitives.size());
+        for (auto i = 0u; i != primitives.size(); ++i) {
+            REQUIRE_LE(distance(primitives[i], points[i]), 1e-3f);
+            REQUIRE_EQ((point - points[i]).length(),
+                       doctest::Approx(distance(primitives[i], point))
+                       .epsilon(1e-3));
+        }
+
+        // Segments, so that misses can be checked by walking along them
+        const Ray<float, size> ray {point, generator.point(1), 20};
+        raycast(batch, ray, hits);
+        auto hit = hits.begin();
+        for (auto i = 0u; i != primitives.size(); ++i) {
+            if (hit != hits.end() && hit->index == i) {
+                REQUIRE(0 <= hit->t);
+                REQUIRE(hit->t <= ray.max_t);
+                REQUIRE_LE(distance(primitives[i], ray.at(hit->t)), 1e-3f);
+                if (hit->t > 0.01f) {
+                    REQUIRE_GT(distance(primitives[i], ray.at(hit->t - 0.01f)),
+                               0);
+                }
+                ++hit;
+            } else {
+                auto closest = distance(primitives[i], ray.origin);
+                for (auto t = 0.f; t <= ray.max_t; t += 0.01f) {
+                    closest = std::min(closest,
+                                       distance(primitives[i], ray.at(t)));
+                }
+                REQUIRE_GT(closest, 0);
+            }
+        }
+        REQUIRE(hit == hits.end());
+    }
+}
+} // anonymous namespace
+
+TEST_CASE("[math] Batches of primitives") {
+    Batch<Circle> circles;
+    circles.push_back(Circle{Vec2{0, 0}, 1});
+    circles.push_back(Circle{Vec2{3, 0}, 2});
+    circles.push_back(Circle{Vec2{6, 0}, 3});
+    REQUIRE_EQ(circles.blocks(), 1);
+    REQUIRE_EQ(circles[1].center, Vec2{3, 0});
+    REQUIRE_EQ(circles[1].radius, 2);
+
+    circles.set(0, Circle{Vec2{-1, 0}, 4});
+    REQUIRE_EQ(circles[0].radius, 4);
+
+    SUBCASE("Erasing moves the last primitive into the hole") {
+        circles.erase(0);
+        REQUIRE_EQ(circles.size(), 2);
+        REQUIRE_EQ(circles[0].radius, 3);
+        REQUIRE_EQ(circles[1].radius, 2);
+        circles.erase(1);
+        circles.erase(0);
+        REQUIRE(circles.empty());
+        REQUIRE_EQ(circles.blocks(), 0);
+    }
+
+    SUBCASE("Unused lanes never match") {
+        std::vector<uint32> indices;
+        containing(circles, Vec2{0, 0}, indices);
+        REQUIRE_EQ(indices, std::vector<uint32>{0});
+
+        std::vector<Ray_hit> hits;
+        raycast(circles, Ray2{Vec2{-10, 0}, Vec2{1, 0}}, hits);
+        REQUIRE_EQ(hits.size(), 3);
+        REQUIRE_EQ(hits[0].t, doctest::Approx(5));
+        REQUIRE_EQ(hits[1].t, doctest::Approx(11));
+    }
+}
+
+TEST_CASE("[math] Queries on batches of primitives") {
+    SUBCASE("Boxes") {
+        check_queries<Aabb2, 2>();
+        check_queries<Aabb3, 3>();
+    }
+
+    SUBCASE("Spheres") {
+        check_queries<Circle, 2>();
+        check_queries<Sphere3, 3>();
+    }
+
+    SUBCASE("Capsules") {
+        check_queries<Capsule2, 2>();
+        check_queries<Capsule3, 3>();
+    }
+
+    SUBCASE("Oriented boxes") {
+        check_queries<Obb2, 2>();
+        check_queries<Obb3, 3>();
+    }
+
+    SUBCASE("Overlapping boxes") {
+        Generator<3> generator;
+        Batch<Aabb3> boxes;
+        Batch<Sphere3> spheres;
+        std::vector<Aabb3> box_list(30);
+        std::vector<Sphere3> sphere_list(30);
+        for (auto i = 0u; i != 30; ++i) {
+            generator.make(box_list[i]);
+            boxes.push_back(box_list[i]);
+            generator.make(sphere_list[i]);
+            spheres.push_back(sphere_list[i]);
+        }
+
+        std::vector<uint32> indices;
+        for (auto query = 0; query != 20; ++query) {
+            Aabb3 box;
+            generator.make(box);
+
+            std::vector<uint32> expected;
+            for (auto i = 0u; i != 30; ++i) {
+                if (box_list[i].overlaps(box)) expected.push_back(i);
+            }
+            overlapping(boxes, box, indices);
+            REQUIRE_EQ(indices, expected);
+
+            expected.clear();
+            for (auto i = 0u; i != 30; ++i) {
+                if (distance(box, sphere_list[i].center)
+                        <= sphere_list[i].radius) {
+                    expected.push_back(i);
+                }
+            }
+            overlapping(spheres, box, indices);
+            REQUIRE_EQ(indices, expected);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <vector>
+
+#include "doctest.h"
+
+#include "bolder/exception.hpp"
+#include "bolder/spatial_hash_grid.hpp"
+
+using namespace bolder;
+using namespace bolder::math;
+
+namespace {
+// Position of the point with an id, on a 100x100 lattice with spacing 1
+Vec2 lattice_point(Spatial_hash_grid::Id id) {
+    return Vec2{static_cast<float>(id % 100), static_cast<float>(id / 100)};
+}
+
+std::vector<Spatial_hash_grid::Id> sorted(
+        std::vector<Spatial_hash_grid::Id> ids) {
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+} // anonymous namespace
+
+TEST_CASE("[math] Axis-aligned bounding boxes") {
+    const Aabb2 box {Vec2{0, 0}, Vec2{2, 4}};
+    REQUIRE_EQ(box.center(), Vec2{1, 2});
+    REQUIRE(box.contains(Vec2{2, 4}));
+    REQUIRE_FALSE(box.contains(Vec2{2.5f, 1}));
+    REQUIRE(box.overlaps(Aabb2{Vec2{2, 4}, Vec2{3, 5}}));
+    REQUIRE_FALSE(box.overlaps(Aabb2{Vec2{-2, 0}, Vec2{-1, 1}}));
+    REQUIRE_EQ(merge(box, Aabb2{Vec2{-1, 1}, Vec2{1, 5}}),
+               (Aabb2{Vec2{-1, 0}, Vec2{2, 5}}));
+}
+
+TEST_CASE("[math] Spatial hash grid") {
+    Spatial_hash_grid grid {4};
+    for (Spatial_hash_grid::Id id = 0; id != 10000; ++id) {
+        grid.insert(id, lattice_point(id));
+    }
+    REQUIRE_EQ(grid.size(), 10000);
+
+    // Every query is checked against testing every point
+    auto brute_force = [&grid](auto predicate) {
+        std::vector<Spatial_hash_grid::Id> ids;
+        for (Spatial_hash_grid::Id id = 0; id != 10000; ++id) {
+            if (grid.contains(id) && predicate(grid.position(id))) {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    };
+    auto radius_query = [&grid](Vec2 center, float radius) {
+        std::vector<Spatial_hash_grid::Id> ids;
+        grid.query_radius(center, radius,
+                          [&ids](Spatial_hash_grid::Id id, Vec2) {
+            ids.push_back(id);
+        });
+        return sorted(ids);
+    };
+
+    SUBCASE("Finds the points within a radius") {
+        const Vec2 center {50.5f, 20.25f};
+        REQUIRE_EQ(radius_query(center, 7.5f), brute_force([center](Vec2 p) {
+            return (p - center).length_square() <= 7.5f * 7.5f;
+        }));
+        REQUIRE(radius_query(Vec2{-100, -100}, 10).empty());
+    }
+
+    SUBCASE("Finds the points inside a box") {
+        const Aabb2 box {Vec2{-3, 10.5f}, Vec2{12, 30}};
+        std::vector<Spatial_hash_grid::Id> ids;
+        grid.query_aabb(box, [&ids](Spatial_hash_grid::Id id, Vec2) {
+            ids.push_back(id);
+        });
+        REQUIRE_EQ(sorted(ids), brute_force([&box](Vec2 p) {
+            return box.contains(p);
+        }));
+
+        // Larger than the grid, so that it visits every cell
+        ids.clear();
+        grid.query_aabb(Aabb2{Vec2{-1e6f, -1e6f}, Vec2{1e6f, 1e6f}},
+                        [&ids](Spatial_hash_grid::Id id, Vec2) {
+            ids.push_back(id);
+        });
+        REQUIRE_EQ(ids.size(), 10000);
+    }
+
+    SUBCASE("Moves and erases points") {
+        grid.move(0, Vec2{50.1f, 50.1f});
+        grid.move(1, Vec2{1.5f, 0.5f});
+        grid.erase(5050);
+        REQUIRE_EQ(grid.size(), 9999);
+        REQUIRE_FALSE(grid.contains(5050));
+        REQUIRE_EQ(grid.position(1), Vec2{1.5f, 0.5f});
+        REQUIRE_EQ(radius_query(Vec2{50, 50}, 0.5f),
+                   std::vector<Spatial_hash_grid::Id>{0});
+
+        REQUIRE_THROWS_AS(grid.insert(1, Vec2{}), Runtime_error);
+        REQUIRE_THROWS_AS(grid.erase(5050), Runtime_error);
+        REQUIRE_THROWS_AS(grid.move(5050, Vec2{}), Runtime_error);
+
+        grid.insert(5050, Vec2{-10, -10});
+        REQUIRE_EQ(radius_query(Vec2{-10, -10}, 1),
+                   std::vector<Spatial_hash_grid::Id>{5050});
+    }
+
+    SUBCASE("Finds the nearest points") {
+        std::vector<Spatial_hash_grid::Id> ids;
+        grid.query_nearest(Vec2{10.1f, 10.2f}, 3, ids);
+        REQUIRE_EQ(ids, std::vector<Spatial_hash_grid::Id>{1010, 1110, 1011});
+
+        // Far from every point, so that the rings reach every cell
+        grid.query_nearest(Vec2{-500, 20}, 1, ids);
+        REQUIRE_EQ(ids, std::vector<Spatial_hash_grid::Id>{2000});
+
+        grid.clear();
+        grid.insert(7, Vec2{1, 1});
+        grid.query_nearest(Vec2{0, 0}, 5, ids);
+        REQUIRE_EQ(ids, std::vector<Spatial_hash_grid::Id>{7});
+    }
+}
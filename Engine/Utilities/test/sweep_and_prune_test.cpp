@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "doctest.h"
+
+#include "bolder/exception.hpp"
+#include "bolder/sweep_and_prune.hpp"
+
+using namespace bolder;
+using namespace bolder::math;
+
+namespace {
+using Pair = Sweep_and_prune::Pair;
+
+std::vector<Pair> sorted_pairs(Sweep_and_prune& broadphase) {
+    std::vector<Pair> pairs;
+    broadphase.find_pairs(pairs);
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+std::vector<Pair> brute_force(const Sweep_and_prune& broadphase,
+                              Sweep_and_prune::Id count) {
+    std::vector<Pair> pairs;
+    for (Sweep_and_prune::Id i = 0; i != count; ++i) {
+        for (auto j = i + 1; j != count; ++j) {
+            if (broadphase.contains(i) && broadphase.contains(j)
+                    && broadphase.box(i).overlaps(broadphase.box(j))) {
+                pairs.push_back(Pair{i, j});
+            }
+        }
+    }
+    return pairs;
+}
+} // anonymous namespace
+
+TEST_CASE("[math] Sweep and prune broadphase") {
+    constexpr Sweep_and_prune::Id count = 500;
+    std::mt19937 random {42};
+    std::uniform_real_distribution<float> position {0, 100};
+    std::uniform_real_distribution<float> size {0.5f, 4};
+
+    Sweep_and_prune broadphase;
+    for (Sweep_and_prune::Id id = 0; id != count; ++id) {
+        const Vec2 min {position(random), position(random)};
+        broadphase.insert(id, Aabb2{min, min + Vec2{size(random),
+                                                    size(random)}});
+    }
+
+    SUBCASE("Finds every overlapping pair") {
+        const auto pairs = sorted_pairs(broadphase);
+        REQUIRE_FALSE(pairs.empty());
+        REQUIRE_EQ(pairs, brute_force(broadphase, count));
+    }
+
+    SUBCASE("Keeps up with moving boxes") {
+        std::uniform_real_distribution<float> step {-1, 1};
+        for (int frame = 0; frame != 5; ++frame) {
+            for (Sweep_and_prune::Id id = 0; id != count; ++id) {
+                auto box = broadphase.box(id);
+                const Vec2 offset {step(random), step(random)};
+                broadphase.update(id, Aabb2{box.min + offset,
+                                            box.max + offset});
+            }
+            REQUIRE_EQ(sorted_pairs(broadphase), brute_force(broadphase, count));
+        }
+    }
+
+    SUBCASE("Inserts and erases boxes between steps") {
+        sorted_pairs(broadphase);
+        for (Sweep_and_prune::Id id = 0; id < count; id += 3) {
+            broadphase.erase(id);
+        }
+        broadphase.insert(0, Aabb2{Vec2{-1, -1}, Vec2{200, 200}});
+        broadphase.insert(count, Aabb2{Vec2{-10, -10}, Vec2{-5, -5}});
+        REQUIRE_EQ(broadphase.size(), count - (count + 2) / 3 + 2);
+        REQUIRE_EQ(sorted_pairs(broadphase), brute_force(broadphase,
+                                                         count + 1));
+
+        REQUIRE_THROWS_AS(broadphase.insert(0, Aabb2{}), Runtime_error);
+        REQUIRE_THROWS_AS(broadphase.erase(3), Runtime_error);
+        REQUIRE_THROWS_AS(broadphase.update(3, Aabb2{}), Runtime_error);
+    }
+
+    SUBCASE("Rejects boxes that are not finite") {
+        const auto infinity = std::numeric_limits<float>::infinity();
+        const auto size = broadphase.size();
+        REQUIRE_THROWS_AS(broadphase.insert(count, Aabb2{Vec2{0, 0},
+                                                         Vec2{infinity, 1}}),
+                          Runtime_error);
+        REQUIRE_THROWS_AS(broadphase.update(1, Aabb2{Vec2{0, std::nanf("")},
+                                                     Vec2{1, 1}}),
+                          Runtime_error);
+        REQUIRE_EQ(broadphase.size(), size);
+        REQUIRE_FALSE(broadphase.contains(count));
+        REQUIRE_EQ(sorted_pairs(broadphase), brute_force(broadphase, count));
+    }
+
+    SUBCASE("Boxes that touch overlap") {
+        Sweep_and_prune touching;
+        touching.insert(0, Aabb2{Vec2{0, 0}, Vec2{1, 1}});
+        touching.insert(1, Aabb2{Vec2{1, 1}, Vec2{2, 2}});
+        touching.insert(2, Aabb2{Vec2{2.5f, 0}, Vec2{3, 1}});
+        REQUIRE_EQ(sorted_pairs(touching), std::vector<Pair>{Pair{0, 1}});
+    }
+}
@@ -0,0 +1,100 @@
+#include "bolder/thread_pool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace bolder;
+
+TEST_CASE("Thread_pool") {
+    std::atomic<int> count {0};
+
+    SUBCASE("Runs every submitted task before destruction") {
+        {
+            Thread_pool pool {4};
+            REQUIRE_EQ(pool.size(), 4);
+            for (int i = 0; i != 1000; ++i) {
+                pool.submit([&count] { ++count; });
+            }
+        }
+        REQUIRE_EQ(count.load(), 1000);
+    }
+
+    SUBCASE("Tasks can submit more tasks") {
+        {
+            Thread_pool pool {2};
+            pool.submit([&] {
+                for (int i = 0; i != 10; ++i) {
+                    pool.submit([&count] { ++count; });
+                }
+            });
+            while (count.load() != 10) {}
+        }
+        REQUIRE_EQ(count.load(), 10);
+    }
+}
+
+TEST_CASE("parallel_for") {
+    Thread_pool pool {4};
+    constexpr std::size_t count = 10000;
+
+    SUBCASE("Calls the function once for every index") {
+        std::vector<std::atomic<int>> calls(count);
+        std::vector<std::size_t> sums(pool.size() + 1);
+        parallel_for(pool, count, [&](std::size_t participant,
+                                      std::size_t index) {
+            ++calls[index];
+            sums[participant] += index;
+        });
+
+        for (const auto& call : calls) {
+            REQUIRE_EQ(call.load(), 1);
+        }
+        std::size_t sum = 0;
+        for (auto partial : sums) sum += partial;
+        REQUIRE_EQ(sum, count * (count - 1) / 2);
+    }
+
+    SUBCASE("Can be called from the tasks of the same pool") {
+        std::atomic<int> finished {0};
+        std::atomic<std::size_t> calls {0};
+        for (int i = 0; i != 8; ++i) {
+            pool.submit([&] {
+                parallel_for(pool, 100, [&calls](std::size_t, std::size_t) {
+                    ++calls;
+                });
+                ++finished;
+            });
+        }
+        while (finished.load() != 8) {}
+        REQUIRE_EQ(calls.load(), 800);
+    }
+
+    SUBCASE("Rethrows the first exception after every call finishes") {
+        std::atomic<std::size_t> calls {0};
+        REQUIRE_THROWS_AS(parallel_for(pool, count,
+                                       [&calls](std::size_t, std::size_t index) {
+            ++calls;
+            if (index % 100 == 0) throw std::runtime_error{"error"};
+        }), std::runtime_error);
+        REQUIRE_EQ(calls.load(), count);
+    }
+
+    SUBCASE("Gives every participant a value on cache lines of its own") {
+        Per_participant<bool> visited {pool, false};
+        REQUIRE_EQ(visited.size(), pool.size() + 1);
+        for (std::size_t i = 0; i != visited.size(); ++i) {
+            const auto address = reinterpret_cast<std::uintptr_t>(&visited[i]);
+            REQUIRE_EQ(address % cache_line_size, 0);
+        }
+
+        parallel_for(pool, count, [&visited](std::size_t participant,
+                                             std::size_t) {
+            visited[participant] = true;
+        });
+        REQUIRE(visited[0]);
+    }
+}